@@ -8,31 +8,62 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/module.h>
 #include <linux/interrupt.h>
 #include <linux/pci.h>
 #include <linux/ethtool.h>
+#include <linux/dcbnl.h>
+#include <linux/sched/isolation.h>
+#include <net/ip.h>
+#include <net/tcp.h>
 
 #include "otx2_reg.h"
 #include "otx2_common.h"
 #include "otx2_struct.h"
 
-static inline void otx2_nix_rq_op_stats(struct queue_stats *stats,
-					struct otx2_nic *pfvf, int qidx);
-static inline void otx2_nix_sq_op_stats(struct queue_stats *stats,
-					struct otx2_nic *pfvf, int qidx);
+static unsigned int rx_page_cache_size = 512;
+module_param(rx_page_cache_size, uint, 0644);
+MODULE_PARM_DESC(rx_page_cache_size,
+		 "Receive buffer pages cached per pool for recycling, 0 to disable");
+
+static unsigned int tx_comp_interval = 1;
+module_param(tx_comp_interval, uint, 0644);
+MODULE_PARM_DESC(tx_comp_interval,
+		 "Send completion is requested once every these many packets, 1 for every packet");
+
+static unsigned int rx_red_start = 90;
+module_param(rx_red_start, uint, 0644);
+MODULE_PARM_DESC(rx_red_start,
+		 "With rx-red flag set, percent of receive CQEs or buffers in use beyond which packets are randomly dropped");
+
+static unsigned int rx_red_drop = 98;
+module_param(rx_red_drop, uint, 0644);
+MODULE_PARM_DESC(rx_red_drop,
+		 "With rx-red flag set, percent of receive CQEs or buffers in use beyond which all packets are dropped");
+
+static unsigned int rx_bp_level = 85;
+module_param(rx_bp_level, uint, 0644);
+MODULE_PARM_DESC(rx_bp_level,
+		 "Percent of receive CQEs or buffers in use beyond which backpressure i.e PAUSE or PFC is asserted");
 
 /* Sync MAC address with RVU */
 int otx2_hw_set_mac_addr(struct otx2_nic *pfvf, struct net_device *netdev)
 {
 	struct nix_set_mac_addr *req;
+	int err;
 
+	mutex_lock(&pfvf->mbox.lock);
 	req = otx2_mbox_alloc_msg_NIX_SET_MAC_ADDR(&pfvf->mbox);
-	if (!req)
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
 		return -ENOMEM;
+	}
 
 	ether_addr_copy(req->mac_addr, netdev->dev_addr);
 
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
 }
 
 int otx2_set_mac_address(struct net_device *netdev, void *p)
@@ -45,11 +76,10 @@ int otx2_set_mac_address(struct net_device *netdev, void *p)
 
 	memcpy(netdev->dev_addr, addr->sa_data, netdev->addr_len);
 
-	/* If mbox irq (i.e MSIX) is disabled then mark this
-	 * change as pending and return, AF will be synced
-	 * once irqs are re-enabled.
+	/* If interface is down then mark this change as pending
+	 * and return, AF will be synced once it's brought up.
 	 */
-	if (pfvf->hw.num_vec) {
+	if (netif_running(netdev)) {
 		if (otx2_hw_set_mac_addr(pfvf, netdev))
 			return -EBUSY;
 	} else {
@@ -63,17 +93,24 @@ EXPORT_SYMBOL(otx2_set_mac_address);
 int otx2_hw_set_mtu(struct otx2_nic *pfvf, int mtu)
 {
 	struct nix_frs_cfg *req;
+	int err;
 
 	if (!pfvf->hw.num_vec)
 		return -EINVAL;
 
+	mutex_lock(&pfvf->mbox.lock);
 	req = otx2_mbox_alloc_msg_NIX_SET_HW_FRS(&pfvf->mbox);
-	if (!req)
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
 		return -ENOMEM;
+	}
 
 	req->update_smq = true;
-	req->maxlen = mtu + OTX2_ETH_HLEN;
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	/* Leave room for the timestamp CGX prepends when PTP is on */
+	req->maxlen = mtu + OTX2_ETH_HLEN + OTX2_HW_TIMESTAMP_LEN;
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
 }
 
 int otx2_change_mtu(struct net_device *netdev, int new_mtu)
@@ -81,6 +118,23 @@ int otx2_change_mtu(struct net_device *netdev, int new_mtu)
 	struct otx2_nic *pfvf = netdev_priv(netdev);
 	int err;
 
+	if (pfvf->xdp_prog && new_mtu > OTX2_MAX_XDP_MTU) {
+		netdev_warn(netdev,
+			    "Jumbo frames not yet supported with XDP, max MTU %d\n",
+			    OTX2_MAX_XDP_MTU);
+		return -EINVAL;
+	}
+
+	/* Receive buffers are sized for the MTU, resize them too */
+	if (netif_running(netdev) &&
+	    otx2_get_rbuf_len(new_mtu) != pfvf->hw.rbuf_len) {
+		netdev_info(netdev, "Changing MTU from %d to %d\n",
+			    netdev->mtu, new_mtu);
+		netdev->netdev_ops->ndo_stop(netdev);
+		netdev->mtu = new_mtu;
+		return netdev->netdev_ops->ndo_open(netdev);
+	}
+
 	if (netif_running(netdev)) {
 		err = otx2_hw_set_mtu(pfvf, new_mtu);
 		if (err)
@@ -93,10 +147,64 @@ int otx2_change_mtu(struct net_device *netdev, int new_mtu)
 }
 EXPORT_SYMBOL(otx2_change_mtu);
 
+/* Enable or disable stripping of the outer VLAN tag on receive.
+ * NPC captures the tag at layer LB as VTAG type 0, stripped tag's
+ * TCI is reported in the CQE.
+ */
+int otx2_enable_rxvlan(struct otx2_nic *pfvf, bool enable)
+{
+	struct nix_vtag_config *req;
+	int err;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NIX_VTAG_CFG(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->cfg_type = 1; /* Rx vtag config */
+	req->vtag_size = VTAGSIZE_T4;
+	req->rx.vtag_type = 0;
+	req->rx.strip_vtag = enable;
+	req->rx.capture_vtag = enable;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+EXPORT_SYMBOL(otx2_enable_rxvlan);
+
+/* Stripping is of whatever tag is outermost, CTAG or STAG, so both
+ * Rx VLAN offloads go on and off together.
+ */
+netdev_features_t otx2_fix_features(struct net_device *netdev,
+				    netdev_features_t features)
+{
+	netdev_features_t changed = features ^ netdev->features;
+
+	if (changed & NETIF_F_HW_VLAN_CTAG_RX) {
+		if (features & NETIF_F_HW_VLAN_CTAG_RX)
+			features |= NETIF_F_HW_VLAN_STAG_RX;
+		else
+			features &= ~NETIF_F_HW_VLAN_STAG_RX;
+	} else if (changed & NETIF_F_HW_VLAN_STAG_RX) {
+		if (features & NETIF_F_HW_VLAN_STAG_RX)
+			features |= NETIF_F_HW_VLAN_CTAG_RX;
+		else
+			features &= ~NETIF_F_HW_VLAN_CTAG_RX;
+	}
+	return features;
+}
+EXPORT_SYMBOL(otx2_fix_features);
+
+/* Caller holds mbox lock */
 int otx2_set_flowkey_cfg(struct otx2_nic *pfvf)
 {
 	struct otx2_rss_info *rss = &pfvf->hw.rss_info;
+	struct nix_rss_flowkey_cfg_rsp *rsp;
 	struct nix_rss_flowkey_cfg *req;
+	int err;
 
 	req = otx2_mbox_alloc_msg_NIX_RSS_FLOWKEY_CFG(&pfvf->mbox);
 	if (!req)
@@ -105,9 +213,74 @@ int otx2_set_flowkey_cfg(struct otx2_nic *pfvf)
 	req->flowkey_cfg = rss->flowkey_cfg;
 	req->group = DEFAULT_RSS_CONTEXT_GROUP;
 
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		return err;
+
+	rsp = (struct nix_rss_flowkey_cfg_rsp *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp))
+		return PTR_ERR(rsp);
+
+	/* Needed by ntuple rules with RSS action */
+	rss->flowkey_alg_idx = rsp->alg_idx;
+	return rsp->hdr.rc;
+}
+
+/* Send out all queued messages in one go and check every response.
+ * A batch of AQ instructions can fail partially, AF still executes
+ * the ones following a failed instruction. So report each failure
+ * along with the context it targeted and return the first error.
+ */
+static int otx2_sync_mbox_aq(struct otx2_nic *pfvf)
+{
+	struct otx2_mbox *mbox = &pfvf->mbox.mbox;
+	struct otx2_mbox_dev *mdev = &mbox->dev[0];
+	struct mbox_msghdr *req, *rsp;
+	int offset, id, err;
+
+	if (!otx2_mbox_nonempty(mbox, 0))
+		return 0;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		return err;
+
+	offset = ALIGN(sizeof(struct mbox_hdr), MBOX_MSG_ALIGN);
+	req = (struct mbox_msghdr *)(mdev->mbase + mbox->tx_start + offset);
+	rsp = (struct mbox_msghdr *)(mdev->mbase + mbox->rx_start + offset);
+
+	for (id = 0; id < mdev->msgs_acked; id++) {
+		if (rsp->id != req->id)
+			return -ENODEV;
+
+		if (rsp->rc) {
+			if (req->id == MBOX_MSG_NIX_AQ_ENQ)
+				dev_err(pfvf->dev,
+					"NIX AQ ctype %d qidx %d failed, err %d\n",
+					((struct nix_aq_enq_req *)req)->ctype,
+					((struct nix_aq_enq_req *)req)->qidx,
+					rsp->rc);
+			else if (req->id == MBOX_MSG_NPA_AQ_ENQ)
+				dev_err(pfvf->dev,
+					"NPA AQ ctype %d aura %d failed, err %d\n",
+					((struct npa_aq_enq_req *)req)->ctype,
+					((struct npa_aq_enq_req *)req)->aura_id,
+					rsp->rc);
+			if (!err)
+				err = rsp->rc;
+		}
+
+		req = (struct mbox_msghdr *)(mdev->mbase + mbox->tx_start +
+					     req->next_msgoff);
+		rsp = (struct mbox_msghdr *)(mdev->mbase + mbox->rx_start +
+					     rsp->next_msgoff);
+	}
+
+	return err;
 }
 
+/* Caller holds mbox lock */
 int otx2_set_rss_table(struct otx2_nic *pfvf)
 {
 	struct otx2_rss_info *rss = &pfvf->hw.rss_info;
@@ -122,7 +295,7 @@ int otx2_set_rss_table(struct otx2_nic *pfvf)
 			/* The shared memory buffer can be full.
 			 * Flush it and retry
 			 */
-			err = otx2_sync_mbox_msg(mbox);
+			err = otx2_sync_mbox_aq(pfvf);
 			if (err)
 				return err;
 			aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(mbox);
@@ -137,7 +310,20 @@ int otx2_set_rss_table(struct otx2_nic *pfvf)
 		aq->ctype = NIX_AQ_CTYPE_RSS;
 		aq->op = NIX_AQ_INSTOP_INIT;
 	}
-	return otx2_sync_mbox_msg(mbox);
+	return otx2_sync_mbox_aq(pfvf);
+}
+
+/* Spread flows evenly across all RQs */
+int otx2_set_rss_table_default(struct otx2_nic *pfvf)
+{
+	struct otx2_rss_info *rss = &pfvf->hw.rss_info;
+	int idx;
+
+	for (idx = 0; idx < rss->rss_size; idx++)
+		rss->ind_tbl[idx] =
+			ethtool_rxfh_indir_default(idx, pfvf->hw.rx_queues);
+
+	return otx2_set_rss_table(pfvf);
 }
 
 void otx2_set_rss_key(struct otx2_nic *pfvf)
@@ -166,7 +352,7 @@ void otx2_set_rss_key(struct otx2_nic *pfvf)
 int otx2_rss_init(struct otx2_nic *pfvf)
 {
 	struct otx2_rss_info *rss = &pfvf->hw.rss_info;
-	int idx, ret = 0;
+	int ret = 0;
 
 	/* Enable RSS */
 	rss->enable = true;
@@ -176,12 +362,7 @@ int otx2_rss_init(struct otx2_nic *pfvf)
 	netdev_rss_key_fill(rss->key, sizeof(rss->key));
 	otx2_set_rss_key(pfvf);
 
-	/* Default indirection table */
-	for (idx = 0; idx < rss->rss_size; idx++)
-		rss->ind_tbl[idx] =
-			ethtool_rxfh_indir_default(idx, pfvf->hw.rx_queues);
-
-	ret = otx2_set_rss_table(pfvf);
+	ret = otx2_set_rss_table_default(pfvf);
 	if (ret)
 		return ret;
 
@@ -199,38 +380,89 @@ void otx2_update_lmac_stats(struct otx2_nic *pfvf)
 
 	if (!netif_running(pfvf->netdev))
 		return;
+	mutex_lock(&pfvf->mbox.lock);
 	req = otx2_mbox_alloc_msg_CGX_STATS(&pfvf->mbox);
-	if (!req)
-		return;
-
-	otx2_sync_mbox_msg(&pfvf->mbox);
+	if (req)
+		otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
 }
 
-int otx2_update_rq_stats(struct otx2_nic *pfvf, int qidx)
+int otx2_alloc_queue_stats(struct otx2_nic *pfvf)
 {
-	struct otx2_rcv_queue *rq = &pfvf->qset.rq[qidx];
+	struct otx2_hw *hw = &pfvf->hw;
+	int qidx;
 
-	if (!pfvf->qset.rq)
-		return 0;
+	hw->rq_stats = devm_kcalloc(pfvf->dev, hw->max_queues,
+				    sizeof(*hw->rq_stats), GFP_KERNEL);
+	hw->sq_stats = devm_kcalloc(pfvf->dev, hw->max_queues,
+				    sizeof(*hw->sq_stats), GFP_KERNEL);
+	if (!hw->rq_stats || !hw->sq_stats)
+		return -ENOMEM;
+
+	for (qidx = 0; qidx < hw->max_queues; qidx++) {
+		u64_stats_init(&hw->rq_stats[qidx].syncp);
+		u64_stats_init(&hw->sq_stats[qidx].syncp);
+	}
+	return 0;
+}
+EXPORT_SYMBOL(otx2_alloc_queue_stats);
 
-	otx2_nix_rq_op_stats(&rq->stats, pfvf, qidx);
-	return 1;
+/* Snapshot of a queue's SW stats, doesn't touch HW */
+void otx2_get_rq_stats(struct otx2_nic *pfvf, int qidx,
+		       struct otx2_rq_stats *stats)
+{
+	struct otx2_rq_stats *rq_stats = &pfvf->hw.rq_stats[qidx];
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin_irq(&rq_stats->syncp);
+		stats->bytes = rq_stats->bytes;
+		stats->pkts = rq_stats->pkts;
+		stats->mcast = rq_stats->mcast;
+		stats->drops = rq_stats->drops;
+		stats->alloc_fail = rq_stats->alloc_fail;
+	} while (u64_stats_fetch_retry_irq(&rq_stats->syncp, start));
 }
+EXPORT_SYMBOL(otx2_get_rq_stats);
 
-int otx2_update_sq_stats(struct otx2_nic *pfvf, int qidx)
+void otx2_get_sq_stats(struct otx2_nic *pfvf, int qidx,
+		       struct otx2_sq_stats *stats)
 {
-	struct otx2_snd_queue *sq = &pfvf->qset.sq[qidx];
+	struct otx2_sq_stats *sq_stats = &pfvf->hw.sq_stats[qidx];
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin_irq(&sq_stats->syncp);
+		stats->bytes = sq_stats->bytes;
+		stats->pkts = sq_stats->pkts;
+		stats->drops = sq_stats->drops;
+		stats->linearized = sq_stats->linearized;
+		stats->ring_full = sq_stats->ring_full;
+	} while (u64_stats_fetch_retry_irq(&sq_stats->syncp, start));
+}
+EXPORT_SYMBOL(otx2_get_sq_stats);
 
-	if (!pfvf->qset.sq)
-		return 0;
+/* RQ's HW counters are read with an atomic op on queue index,
+ * error bit is set if the RQ isn't initialized.
+ */
+static u64 otx2_nix_rq_op_stat(struct otx2_nic *pfvf, u64 reg, int qidx)
+{
+	atomic64_t *ptr = (__force atomic64_t *)(pfvf->reg_base + reg);
+	u64 incr = (u64)qidx << 32;
+	u64 val;
 
-	otx2_nix_sq_op_stats(&sq->stats, pfvf, qidx);
-	return 1;
+	val = atomic64_fetch_add_relaxed(incr, ptr);
+	if (val & BIT_ULL(63))
+		return 0;
+	return val & GENMASK_ULL(47, 0);
 }
 
 void otx2_get_dev_stats(struct otx2_nic *pfvf)
 {
 	struct otx2_dev_stats *dev_stats = &pfvf->hw.dev_stats;
+	struct otx2_sq_stats sq_stats;
+	struct otx2_pool *pool;
+	int pool_id, qidx;
 
 #define OTX2_GET_RX_STATS(reg) \
 	 otx2_read64(pfvf, NIX_LF_RX_STATX(reg))
@@ -246,6 +478,21 @@ void otx2_get_dev_stats(struct otx2_nic *pfvf)
 			       dev_stats->rx_mcast_frames +
 			       dev_stats->rx_ucast_frames;
 
+	dev_stats->rx_queue_drops = 0;
+	for (qidx = 0; netif_running(pfvf->netdev) &&
+	     qidx < pfvf->hw.rx_queues; qidx++)
+		dev_stats->rx_queue_drops +=
+			otx2_nix_rq_op_stat(pfvf, NIX_LF_RQ_OP_DROP_PKTS, qidx);
+
+	dev_stats->rx_page_recycle_hits = 0;
+	dev_stats->rx_page_recycle_misses = 0;
+	for (pool_id = 0; pfvf->qset.pool &&
+	     pool_id < pfvf->hw.rx_queues; pool_id++) {
+		pool = &pfvf->qset.pool[pool_id];
+		dev_stats->rx_page_recycle_hits += pool->cache.hits;
+		dev_stats->rx_page_recycle_misses += pool->cache.misses;
+	}
+
 	dev_stats->tx_bytes = OTX2_GET_TX_STATS(TX_OCTS);
 	dev_stats->tx_drops = OTX2_GET_TX_STATS(TX_DROP);
 	dev_stats->tx_bcast_frames = OTX2_GET_TX_STATS(TX_BCAST);
@@ -254,6 +501,12 @@ void otx2_get_dev_stats(struct otx2_nic *pfvf)
 	dev_stats->tx_frames = dev_stats->tx_bcast_frames +
 			       dev_stats->tx_mcast_frames +
 			       dev_stats->tx_ucast_frames;
+
+	dev_stats->tx_linearized = 0;
+	for (qidx = 0; qidx < pfvf->hw.max_queues; qidx++) {
+		otx2_get_sq_stats(pfvf, qidx, &sq_stats);
+		dev_stats->tx_linearized += sq_stats.linearized;
+	}
 }
 
 void otx2_get_stats64(struct net_device *netdev,
@@ -261,77 +514,304 @@ void otx2_get_stats64(struct net_device *netdev,
 {
 	struct otx2_nic *pfvf = netdev_priv(netdev);
 	struct otx2_dev_stats *dev_stats = &pfvf->hw.dev_stats;
+	struct otx2_rq_stats rq_stats;
+	struct otx2_sq_stats sq_stats;
+	int qidx;
 
-	otx2_get_dev_stats(pfvf);
-
-	stats->rx_bytes = dev_stats->rx_bytes;
-	stats->rx_packets = dev_stats->rx_frames;
-	stats->rx_dropped = dev_stats->rx_drops;
-	stats->multicast = dev_stats->rx_mcast_frames;
+	/* Totals of all queues' SW stats, including queues which are
+	 * currently not in use, so that counters never go backwards.
+	 */
+	for (qidx = 0; qidx < pfvf->hw.max_queues; qidx++) {
+		otx2_get_rq_stats(pfvf, qidx, &rq_stats);
+		stats->rx_bytes += rq_stats.bytes;
+		stats->rx_packets += rq_stats.pkts;
+		stats->multicast += rq_stats.mcast;
+		stats->rx_dropped += rq_stats.drops;
+
+		otx2_get_sq_stats(pfvf, qidx, &sq_stats);
+		stats->tx_bytes += sq_stats.bytes;
+		stats->tx_packets += sq_stats.pkts;
+		stats->tx_dropped += sq_stats.drops;
+	}
 
-	stats->tx_bytes = dev_stats->tx_bytes;
-	stats->tx_packets = dev_stats->tx_frames;
-	stats->tx_dropped = dev_stats->tx_drops;
+	/* Packets dropped by HW, from when HW stats were last read.
+	 * NIX LF's RX_DROP includes RQ level drops, RED ones as well.
+	 */
+	stats->rx_dropped += READ_ONCE(dev_stats->rx_drops);
 }
 EXPORT_SYMBOL(otx2_get_stats64);
 
-void otx2_set_irq_affinity(struct otx2_nic *pfvf)
+/* CQ interrupts are spread over online CPUs that are not isolated,
+ * the ones on the device's NUMA node are used first. Queues serviced
+ * by a CINT have their memory allocated on this CPU's node.
+ */
+static int otx2_cint_cpu(struct otx2_nic *pfvf, int cint)
+{
+	const struct cpumask *hk = housekeeping_cpumask(HK_FLAG_DOMAIN);
+	int node = dev_to_node(pfvf->dev);
+	int cpu, cnt = 0;
+
+	for_each_cpu_and(cpu, cpu_online_mask, hk)
+		cnt++;
+	if (!cnt) {
+		hk = cpu_online_mask;
+		cnt = num_online_cpus();
+	}
+	cint %= cnt;
+
+	if (node != NUMA_NO_NODE) {
+		for_each_cpu_and(cpu, cpumask_of_node(node), hk) {
+			if (cpu_online(cpu) && !cint--)
+				return cpu;
+		}
+	}
+
+	for_each_cpu_and(cpu, cpu_online_mask, hk) {
+		if (cpu_to_node(cpu) != node && !cint--)
+			return cpu;
+	}
+
+	return cpumask_first(cpu_online_mask);
+}
+
+/* NUMA node of the CPU servicing a queue, queues and pools at the same
+ * index modulo max_queues are mapped to the same CINT.
+ */
+static int otx2_queue_node(struct otx2_nic *pfvf, int qidx)
+{
+	return cpu_to_node(otx2_cint_cpu(pfvf, qidx % pfvf->hw.max_queues));
+}
+
+/* Transmit on the CPU that processes the SQ's completions */
+void otx2_set_xps_queue(struct otx2_nic *pfvf, int qidx)
+{
+	int vec = pfvf->hw.nix_msixoff + NIX_LF_CINT_VEC_START + qidx;
+
+	if (!pfvf->hw.irq_allocated[vec])
+		return;
+
+	netif_set_xps_queue(pfvf->netdev, pfvf->hw.affinity_mask[vec], qidx);
+}
+EXPORT_SYMBOL(otx2_set_xps_queue);
+
+void otx2_set_cint_affinity(struct otx2_nic *pfvf, int cint)
 {
 	struct otx2_hw *hw = &pfvf->hw;
-	int vec, cpu, irq, cint;
+	int vec, cpu, irq;
+
+	vec = hw->nix_msixoff + NIX_LF_CINT_VEC_START + cint;
+	if (!hw->irq_allocated[vec])
+		return;
+
+	cpu = otx2_cint_cpu(pfvf, cint);
+
+	if (!zalloc_cpumask_var(&hw->affinity_mask[vec], GFP_KERNEL))
+		return;
+
+	cpumask_set_cpu(cpu, hw->affinity_mask[vec]);
+
+	irq = pci_irq_vector(pfvf->pdev, vec);
+	irq_set_affinity_hint(irq, hw->affinity_mask[vec]);
 
-	vec = hw->nix_msixoff + NIX_LF_CINT_VEC_START;
-	cpu = cpumask_first(cpu_online_mask);
+	if (cint < hw->tx_queues)
+		otx2_set_xps_queue(pfvf, cint);
+}
+
+void otx2_set_irq_affinity(struct otx2_nic *pfvf)
+{
+	int cint;
 
 	/* CQ interrupts */
-	for (cint = 0; cint < pfvf->hw.cint_cnt; cint++, vec++) {
-		if (!hw->irq_allocated[vec])
-			continue;
+	for (cint = 0; cint < pfvf->hw.cint_cnt; cint++)
+		otx2_set_cint_affinity(pfvf, cint);
+}
+
+/* Program CQE interrupt coalescing, takes effect right away */
+void otx2_config_irq_coalescing(struct otx2_nic *pfvf, int cint)
+{
+	otx2_write64(pfvf, NIX_LF_CINTX_WAIT(cint),
+		     ((u64)pfvf->cq_time_wait << 48) | pfvf->cq_ecount_wait);
+}
+
+/* Buffer pages are DMA mapped as a whole and only once. 'page->private'
+ * counts buffers of the page currently owned by HW, plus one while
+ * buffers are still being carved out of it. Once it drops to zero,
+ * page is parked in the pool's cache along with the pool's reference
+ * and reused without a remap after stack has freed all it's buffers.
+ */
+static int otx2_page_cache_init(struct otx2_nic *pfvf, struct otx2_pool *pool)
+{
+	struct otx2_page_cache *cache = &pool->cache;
+	unsigned int size = min_t(unsigned int, rx_page_cache_size, SZ_32K);
+
+	memset(cache, 0, sizeof(*cache));
+	if (!size)
+		return 0;
+
+	size = roundup_pow_of_two(size);
+	cache->pages = kcalloc_node(size, sizeof(*cache->pages),
+				    GFP_KERNEL, pool->node);
+	cache->iova = kcalloc_node(size, sizeof(*cache->iova),
+				   GFP_KERNEL, pool->node);
+	if (!cache->pages || !cache->iova) {
+		kfree(cache->pages);
+		kfree(cache->iova);
+		cache->pages = NULL;
+		cache->iova = NULL;
+		return -ENOMEM;
+	}
+	cache->size = size;
+	return 0;
+}
+
+static void otx2_page_release(struct otx2_nic *pfvf, struct otx2_pool *pool,
+			      struct page *page, dma_addr_t iova)
+{
+	struct otx2_page_cache *cache = &pool->cache;
+	u16 tail = (cache->tail + 1) & (cache->size - 1);
+
+	if (cache->size && tail != cache->head) {
+		cache->pages[cache->tail] = page;
+		cache->iova[cache->tail] = iova;
+		cache->tail = tail;
+		return;
+	}
+
+	/* Cache is full, stack will free the page eventually */
+	dma_unmap_page_attrs(pfvf->dev, iova, PAGE_SIZE << pool->page_order,
+			     otx2_rx_dma_dir(pfvf), DMA_ATTR_SKIP_CPU_SYNC);
+	put_page(page);
+}
+
+static struct page *otx2_page_cache_get(struct otx2_pool *pool,
+					dma_addr_t *iova)
+{
+	struct otx2_page_cache *cache = &pool->cache;
+	struct page *page;
+
+	if (cache->head == cache->tail)
+		goto miss;
+
+	page = cache->pages[cache->head];
+	*iova = cache->iova[cache->head];
+	cache->head = (cache->head + 1) & (cache->size - 1);
+
+	/* Only pool's reference is left, all buffers are free */
+	if (page_ref_count(page) == 1) {
+		cache->hits++;
+		return page;
+	}
+
+	/* Stack is still holding on to it, move it to the tail so that
+	 * next lookup doesn't get stuck on the same page.
+	 */
+	cache->pages[cache->tail] = page;
+	cache->iova[cache->tail] = *iova;
+	cache->tail = (cache->tail + 1) & (cache->size - 1);
+miss:
+	cache->misses++;
+	return NULL;
+}
 
-		if (!alloc_cpumask_var(&hw->affinity_mask[vec], GFP_KERNEL))
-			return;
+static void otx2_page_put_hw_ref(struct otx2_nic *pfvf, struct otx2_pool *pool,
+				 struct page *page, dma_addr_t iova)
+{
+	unsigned long hw_refs = page_private(page) - 1;
 
-		cpumask_set_cpu(cpu, hw->affinity_mask[vec]);
+	set_page_private(page, hw_refs);
+	if (!hw_refs)
+		otx2_page_release(pfvf, pool, page, iova);
+}
 
-		irq = pci_irq_vector(pfvf->pdev, vec);
-		irq_set_affinity_hint(irq, hw->affinity_mask[vec]);
+/* Buffer at 'iova' is no longer owned by HW */
+void otx2_put_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool,
+		   void *va, u64 iova)
+{
+	struct page *page = virt_to_head_page(va);
 
-		cpu = cpumask_next(cpu, cpu_online_mask);
-		if (unlikely(cpu >= nr_cpu_ids))
-			cpu = 0;
+	iova -= va - page_address(page);
+	otx2_page_put_hw_ref(pfvf, pool, page, iova);
+}
+
+/* Release page currently being carved and all cached pages */
+static void otx2_page_cache_free(struct otx2_nic *pfvf,
+				 struct otx2_pool *pool)
+{
+	struct otx2_page_cache *cache = &pool->cache;
+	struct page *page;
+
+	if (pool->page) {
+		otx2_get_page(pool);
+		page = pool->page;
+		pool->page = NULL;
+		otx2_page_put_hw_ref(pfvf, pool, page, pool->page_iova);
+	}
+
+	while (cache->head != cache->tail) {
+		dma_unmap_page_attrs(pfvf->dev, cache->iova[cache->head],
+				     PAGE_SIZE << pool->page_order,
+				     otx2_rx_dma_dir(pfvf),
+				     DMA_ATTR_SKIP_CPU_SYNC);
+		put_page(cache->pages[cache->head]);
+		cache->head = (cache->head + 1) & (cache->size - 1);
 	}
+
+	kfree(cache->pages);
+	kfree(cache->iova);
+	cache->pages = NULL;
+	cache->iova = NULL;
+	cache->size = 0;
 }
 
-dma_addr_t otx2_alloc_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool)
+dma_addr_t otx2_alloc_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool,
+			   gfp_t gfp)
 {
+	struct page *page;
 	dma_addr_t iova;
 
-	/* Check if request can be accommodated in previous allocated page */
+	/* Check if request can be accommodated in current page */
 	if (pool->page &&
-	    ((pool->page_offset + pool->rbsize) <= PAGE_SIZE)) {
-		pool->pageref++;
+	    ((pool->page_offset + pool->rbsize) <=
+	     (PAGE_SIZE << pool->page_order)))
 		goto ret;
+
+	/* Done carving the current page */
+	if (pool->page) {
+		otx2_get_page(pool);
+		page = pool->page;
+		pool->page = NULL;
+		otx2_page_put_hw_ref(pfvf, pool, page, pool->page_iova);
 	}
 
-	otx2_get_page(pool);
+	page = otx2_page_cache_get(pool, &iova);
+	if (!page) {
+		/* Allocate and map a new page */
+		page = alloc_pages_node(pool->node,
+					gfp | __GFP_COMP | __GFP_NOWARN,
+					pool->page_order);
+		if (!page)
+			return -ENOMEM;
 
-	/* Allocate a new page */
-	pool->page = alloc_pages(GFP_KERNEL | __GFP_COMP | __GFP_NOWARN, 0);
-	if (!pool->page)
-		return -ENOMEM;
+		iova = dma_map_page_attrs(pfvf->dev, page, 0,
+					  PAGE_SIZE << pool->page_order,
+					  otx2_rx_dma_dir(pfvf),
+					  DMA_ATTR_SKIP_CPU_SYNC);
+		if (dma_mapping_error(pfvf->dev, iova)) {
+			__free_pages(page, pool->page_order);
+			return -ENOMEM;
+		}
+	}
 
+	pool->page = page;
+	pool->page_iova = iova;
 	pool->page_offset = 0;
+	/* Hold until page is fully carved */
+	set_page_private(page, 1);
 ret:
-	iova = (u64)dma_map_page_attrs(pfvf->dev, pool->page,
-				       pool->page_offset, pool->rbsize,
-				       DMA_FROM_DEVICE, DMA_ATTR_SKIP_CPU_SYNC);
-	if (dma_mapping_error(pfvf->dev, iova)) {
-		if (!pool->page_offset)
-			__free_pages(pool->page, 0);
-		pool->page = NULL;
-		return -ENOMEM;
-	}
+	iova = pool->page_iova + pool->page_offset;
 	pool->page_offset += pool->rbsize;
+	pool->pageref++;
+	set_page_private(pool->page, page_private(pool->page) + 1);
 	return iova;
 }
 
@@ -343,6 +823,38 @@ void otx2_tx_timeout(struct net_device *netdev)
 }
 EXPORT_SYMBOL(otx2_tx_timeout);
 
+/* HW offloads checksum and TSO of tunneled packets only if inner
+ * headers are IPv4/IPv6 and header pointers fit in the SQE's 8 bits.
+ */
+netdev_features_t otx2_features_check(struct sk_buff *skb,
+				      struct net_device *dev,
+				      netdev_features_t features)
+{
+	features = vlan_features_check(skb, features);
+	if (!skb->encapsulation)
+		return features;
+
+	if (inner_ip_hdr(skb)->version != 4 &&
+	    inner_ip_hdr(skb)->version != 6)
+		goto no_offload;
+
+	if (skb->ip_summed == CHECKSUM_PARTIAL &&
+	    skb_checksum_start_offset(skb) != skb_inner_transport_offset(skb))
+		goto no_offload;
+
+	if (skb_is_gso(skb) &&
+	    skb_inner_transport_offset(skb) + inner_tcp_hdrlen(skb) > U8_MAX)
+		goto no_offload;
+
+	if (skb_inner_transport_offset(skb) > U8_MAX)
+		goto no_offload;
+
+	return features;
+no_offload:
+	return features & ~(NETIF_F_CSUM_MASK | NETIF_F_GSO_MASK);
+}
+EXPORT_SYMBOL(otx2_features_check);
+
 static int otx2_get_link(struct otx2_nic *pfvf)
 {
 	int link = 0;
@@ -360,11 +872,51 @@ static int otx2_get_link(struct otx2_nic *pfvf)
 	return link;
 }
 
-int otx2_txschq_config(struct otx2_nic *pfvf, int lvl)
+/* Shaper rate is ((256 + mantissa) << exponent) * 2 / 256 Mbps,
+ * with divider exponent at zero this covers 2Mbps to 100Gbps.
+ */
+u64 otx2_get_txschq_rate_regval(u32 rate)
+{
+	u64 exp, mantissa;
+
+	rate = clamp_t(u32, rate, OTX2_MIN_TX_RATE, OTX2_MAX_TX_RATE);
+	exp = ilog2(rate);
+	mantissa = ((u64)(rate - (1U << exp)) << 8) >> exp;
+
+	return TLX_BURST_MAX | ((exp - 1) << 9) | (mantissa << 1) | BIT_ULL(0);
+}
+
+static u16 otx2_get_smq(struct otx2_nic *pfvf, u16 qidx)
+{
+	int idx = min_t(int, qidx, pfvf->hw.max_queues);
+
+	return pfvf->hw.txschq_list[NIX_TXSCH_LVL_SMQ][idx];
+}
+
+/* Traffic class, and so the TL4, a SMQ is fed to */
+static int otx2_get_smq_tc(struct otx2_nic *pfvf, int idx)
+{
+	/* XDP SQs and queues not in any traffic class go to the first */
+	if (idx >= pfvf->hw.tx_queues || !netdev_get_num_tc(pfvf->netdev))
+		return 0;
+	return max(netdev_txq_to_tc(pfvf->netdev, idx), 0);
+}
+
+/* Per queue rate set via sysfs tx_maxrate, in Mbps */
+static u32 otx2_get_smq_maxrate(struct otx2_nic *pfvf, int idx)
+{
+	if (idx >= pfvf->hw.tx_queues)
+		return 0;
+	return netdev_get_tx_queue(pfvf->netdev, idx)->tx_maxrate;
+}
+
+int otx2_txschq_config(struct otx2_nic *pfvf, int lvl, int idx)
 {
 	struct nix_txschq_config *req;
 	struct otx2_hw *hw = &pfvf->hw;
 	u64 schq, parent;
+	int tc;
+	u32 rate;
 
 	req = otx2_mbox_alloc_msg_NIX_TXSCHQ_CFG(&pfvf->mbox);
 	if (!req)
@@ -373,7 +925,7 @@ int otx2_txschq_config(struct otx2_nic *pfvf, int lvl)
 	req->lvl = lvl;
 	req->num_regs = 1;
 
-	schq = hw->txschq_list[lvl][0];
+	schq = hw->txschq_list[lvl][idx];
 	/* Set topology e.t.c configuration */
 	if (lvl == NIX_TXSCH_LVL_SMQ) {
 		/* Set min and max Tx packet lengths */
@@ -381,18 +933,43 @@ int otx2_txschq_config(struct otx2_nic *pfvf, int lvl)
 		req->regval[0] = ((pfvf->netdev->mtu  + OTX2_ETH_HLEN) << 8) |
 				   OTX2_MIN_MTU;
 		req->num_regs++;
-		/* MDQ config */
-		parent =  hw->txschq_list[NIX_TXSCH_LVL_TL4][0];
+		/* MDQ config, parent is TL4 of SQ's traffic class */
+		tc = otx2_get_smq_tc(pfvf, idx);
+		parent =  hw->txschq_list[NIX_TXSCH_LVL_TL4][tc];
 		req->reg[1] = NIX_AF_MDQX_PARENT(schq);
 		req->regval[1] = parent << 16;
 		req->num_regs++;
 		/* Set DWRR quantum */
 		req->reg[2] = NIX_AF_MDQX_SCHEDULE(schq);
-		req->regval[2] = pfvf->netdev->mtu;
+		req->regval[2] = (TXSCH_TL1_DFLT_RR_PRIO << 24) |
+				 pfvf->netdev->mtu;
+		req->num_regs++;
+		rate = otx2_get_smq_maxrate(pfvf, idx);
+		req->reg[3] = NIX_AF_MDQX_PIR(schq);
+		req->regval[3] = rate ? otx2_get_txschq_rate_regval(rate) : 0;
 	} else if (lvl == NIX_TXSCH_LVL_TL4) {
 		parent =  hw->txschq_list[NIX_TXSCH_LVL_TL3][0];
 		req->reg[0] = NIX_AF_TL4X_PARENT(schq);
 		req->regval[0] = parent << 16;
+		/* Traffic classes share TL3 in DWRR fashion, their
+		 * min and max rates are enforced by CIR and PIR.
+		 */
+		req->num_regs++;
+		req->reg[1] = NIX_AF_TL4X_SCHEDULE(schq);
+		req->regval[1] = (TXSCH_TL1_DFLT_RR_PRIO << 24) |
+				 pfvf->netdev->mtu;
+		req->num_regs++;
+		req->reg[2] = NIX_AF_TL4X_CIR(schq);
+		req->regval[2] = hw->tc_min_rate[idx] ?
+			otx2_get_txschq_rate_regval(hw->tc_min_rate[idx]) : 0;
+		req->num_regs++;
+		req->reg[3] = NIX_AF_TL4X_PIR(schq);
+		req->regval[3] = hw->tc_max_rate[idx] ?
+			otx2_get_txschq_rate_regval(hw->tc_max_rate[idx]) : 0;
+		/* SQs' MDQs of this class are served in DWRR fashion */
+		req->num_regs++;
+		req->reg[4] = NIX_AF_TL4X_TOPOLOGY(schq);
+		req->regval[4] = (TXSCH_TL1_DFLT_RR_PRIO << 1);
 	} else if (lvl == NIX_TXSCH_LVL_TL3) {
 		parent = hw->txschq_list[NIX_TXSCH_LVL_TL2][0];
 		req->reg[0] = NIX_AF_TL3X_PARENT(schq);
@@ -402,6 +979,9 @@ int otx2_txschq_config(struct otx2_nic *pfvf, int lvl)
 							otx2_get_link(pfvf));
 		/* Enable this queue and backpressure */
 		req->regval[1] = BIT_ULL(13) | BIT_ULL(12);
+		req->num_regs++;
+		req->reg[2] = NIX_AF_TL3X_TOPOLOGY(schq);
+		req->regval[2] = (TXSCH_TL1_DFLT_RR_PRIO << 1);
 	} else if (lvl == NIX_TXSCH_LVL_TL2) {
 		parent =  hw->txschq_list[NIX_TXSCH_LVL_TL1][0];
 		req->reg[0] = NIX_AF_TL2X_PARENT(schq);
@@ -431,6 +1011,39 @@ int otx2_txschq_config(struct otx2_nic *pfvf, int lvl)
 	return otx2_sync_mbox_msg(&pfvf->mbox);
 }
 
+/* Cap a SQ's rate by its MDQ shaper, rate is in Mbps.
+ * Stack keeps the rate in netdev_queue, which is applied on open.
+ */
+int otx2_set_tx_maxrate(struct net_device *netdev, int qidx, u32 rate)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	struct nix_txschq_config *req;
+	int err;
+
+	if (rate > OTX2_MAX_TX_RATE)
+		return -EINVAL;
+
+	if (!netif_running(netdev))
+		return 0;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NIX_TXSCHQ_CFG(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->lvl = NIX_TXSCH_LVL_SMQ;
+	req->num_regs = 1;
+	req->reg[0] = NIX_AF_MDQX_PIR(otx2_get_smq(pfvf, qidx));
+	req->regval[0] = rate ? otx2_get_txschq_rate_regval(rate) : 0;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+EXPORT_SYMBOL(otx2_set_tx_maxrate);
+
 int otx2_txsch_alloc(struct otx2_nic *pfvf)
 {
 	struct nix_txsch_alloc_req *req;
@@ -443,9 +1056,9 @@ int otx2_txsch_alloc(struct otx2_nic *pfvf)
 	if (!req)
 		return -ENOMEM;
 
-	/* Request one schq per level */
+	/* Request one schq per level, more at TL4 and SMQ levels */
 	for (lvl = 0; lvl < NIX_TXSCH_LVL_CNT; lvl++)
-		req->schq[lvl] = 1;
+		req->schq[lvl] = otx2_txschq_cnt(pfvf, lvl);
 
 	err = otx2_sync_mbox_msg(&pfvf->mbox);
 	if (err)
@@ -479,34 +1092,76 @@ int otx2_txschq_stop(struct otx2_nic *pfvf)
 	return 0;
 }
 
+/* Convert percent of CQEs or buffers in use to the HW's free level,
+ * which is in units of 1/256th of CQ size or aura's buffer count.
+ */
+static u8 otx2_rx_free_level(unsigned int in_use)
+{
+	return ((100 - min(in_use, 100U)) * 255) / 100;
+}
+
 static int otx2_rq_init(struct otx2_nic *pfvf, u16 qidx)
 {
+	struct otx2_rcv_queue *rq = &pfvf->qset.rq[qidx];
 	struct nix_aq_enq_req *aq;
+	int err;
+
+	err = xdp_rxq_info_reg(&rq->xdp_rxq, pfvf->netdev, qidx);
+	if (err)
+		return err;
 
 	/* Get memory to put this msg */
 	aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
-	if (!aq)
-		return -ENOMEM;
+	if (!aq) {
+		/* Shared mbox memory buffer is full, flush it and retry */
+		err = otx2_sync_mbox_aq(pfvf);
+		if (err)
+			return err;
+		aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
+		if (!aq)
+			return -ENOMEM;
+	}
 
 	aq->rq.cq = qidx;
 	aq->rq.ena = 1;
 	aq->rq.pb_caching = 1;
 	aq->rq.lpb_aura = qidx; /* Use large packet buffer aura */
-	aq->rq.lpb_sizem1 = (DMA_BUFFER_LEN / 8) - 1;
-	aq->rq.xqe_imm_size = 0; /* Copying of packet to CQE not needed */
+	aq->rq.lpb_sizem1 = (pfvf->hw.rbuf_len / 8) - 1;
+	/* Receive small packets into CQE, with XQE_IMM_COPY clear the
+	 * data copied to CQE isn't written to receive buffers.
+	 */
+	if (otx2_rx_imm_ena(pfvf))
+		aq->rq.xqe_imm_size = pfvf->rx_copybreak / 16;
 	aq->rq.flow_tagw = 32; /* Copy full 32bit flow_tag to CQE header */
 
+	/* RED, when free CQEs or buffers of the aura fall below pass
+	 * level packets are dropped randomly with increasing probability,
+	 * and below drop level all are dropped. This sheds load at NIX
+	 * before CQ overflows or NPA runs out of buffers.
+	 */
+	if (pfvf->rx_red_ena) {
+		unsigned int drop = min(READ_ONCE(rx_red_drop), 100U);
+		unsigned int start = min(READ_ONCE(rx_red_start), drop);
+
+		aq->rq.xqe_drop_ena = 1;
+		aq->rq.xqe_pass = otx2_rx_free_level(start);
+		aq->rq.xqe_drop = otx2_rx_free_level(drop);
+		aq->rq.lpb_drop_ena = 1;
+		aq->rq.lpb_aura_pass = otx2_rx_free_level(start);
+		aq->rq.lpb_aura_drop = otx2_rx_free_level(drop);
+	}
+
 	/* Fill AQ info */
 	aq->qidx = qidx;
 	aq->ctype = NIX_AQ_CTYPE_RQ;
 	aq->op = NIX_AQ_INSTOP_INIT;
 
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	return 0;
 }
 
 static int otx2_sq_init(struct otx2_nic *pfvf, u16 qidx)
 {
-	int pool_id = pfvf->hw.rx_queues + qidx;
+	int pool_id = otx2_get_sq_cq(pfvf, qidx);
 	struct otx2_qset *qset = &pfvf->qset;
 	struct otx2_snd_queue *sq;
 	struct nix_aq_enq_req *aq;
@@ -517,57 +1172,93 @@ static int otx2_sq_init(struct otx2_nic *pfvf, u16 qidx)
 	sq = &qset->sq[qidx];
 	sq->sqe_size = NIX_SQESZ_W16 ? 64 : 128;
 
-	err = qmem_alloc(pfvf->dev, &sq->sqe, 1, sq->sqe_size);
+	/* Room for SQEs staged before they are flushed to HW */
+	err = qmem_alloc(pfvf->dev, &sq->sqe, OTX2_SQE_BATCH, sq->sqe_size);
 	if (err)
 		return err;
 
-	sq->sqe_base = sq->sqe->base;
-	sq->sg = kcalloc((qset->sqe_cnt + 1),
-			 sizeof(struct sg_list), GFP_KERNEL);
+	sq->sg = kcalloc_node((qset->sqe_cnt + 1), sizeof(struct sg_list),
+			      GFP_KERNEL, otx2_queue_node(pfvf, qidx));
 	if (!sq->sg)
 		return -ENOMEM;
 
+	/* Skbs sent out on stack's SQs can have more frags than
+	 * what fits in a SQE, XDP frames are always single buffer.
+	 */
+	if (qidx < pfvf->hw.max_queues) {
+		err = qmem_alloc(pfvf->dev, &sq->jump, qset->sqe_cnt,
+				 OTX2_SQE_JUMP_SIZE);
+		if (err)
+			return err;
+
+		err = qmem_alloc(pfvf->dev, &sq->timestamps, qset->sqe_cnt,
+				 sizeof(u64));
+		if (err)
+			return err;
+	}
+
 	sq->head = 0;
-	sq->num_sqbs = (pfvf->hw.sqb_size / sq->sqe_size) - 1;
-	sq->num_sqbs = (qset->sqe_cnt + sq->num_sqbs) / sq->num_sqbs;
+	sq->sqe_cnt = qset->sqe_cnt;
+	sq->sqe_pending = 0;
+	sq->sqe_avail = 0;
+	sq->cons_head = 0;
+	sq->comp_pending = 0;
+	sq->comp_interval = clamp_t(unsigned int, tx_comp_interval,
+				    1, qset->sqe_cnt);
+	sq->sqe_per_sqb = (pfvf->hw.sqb_size / sq->sqe_size) - 1;
+	sq->num_sqbs = (qset->sqe_cnt + sq->sqe_per_sqb) / sq->sqe_per_sqb;
 	sq->aura_id = pool_id;
 	sq->aura_fc_addr = pool->fc_addr->base;
 	sq->lmt_addr = (__force u64 *)(pfvf->reg_base + LMT_LF_LMTLINEX(qidx));
 	sq->io_addr = (__force u64)(pfvf->reg_base + NIX_LF_OP_SENDX(0));
 
-	sq->stats.bytes = 0;
-	sq->stats.pkts = 0;
-
 	/* Get memory to put this msg */
 	aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
-	if (!aq)
-		return -ENOMEM;
+	if (!aq) {
+		/* Shared mbox memory buffer is full, flush it and retry */
+		err = otx2_sync_mbox_aq(pfvf);
+		if (err)
+			return err;
+		aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
+		if (!aq)
+			return -ENOMEM;
+	}
 
-	aq->sq.cq = pfvf->hw.rx_queues + qidx;
+	aq->sq.cq = pool_id;
 	aq->sq.max_sqe_size = NIX_MAXSQESZ_W16; /* 128 byte */
 	aq->sq.cq_ena = 1;
 	aq->sq.ena = 1;
-	/* Only one SMQ is allocated, map all SQ's to that SMQ  */
-	aq->sq.smq = pfvf->hw.txschq_list[NIX_TXSCH_LVL_SMQ][0];
+	aq->sq.smq = otx2_get_smq(pfvf, qidx);
 	aq->sq.smq_rr_quantum = DMA_BUFFER_LEN / 4;
 	aq->sq.default_chan = pfvf->tx_chan_base;
 	aq->sq.sqe_stype = NIX_STYPE_STF; /* Cache SQB */
-	aq->sq.sqb_aura = pfvf->hw.rx_queues + qidx;
+	aq->sq.sqb_aura = pool_id;
 
 	/* Fill AQ info */
 	aq->qidx = qidx;
 	aq->ctype = NIX_AQ_CTYPE_SQ;
 	aq->op = NIX_AQ_INSTOP_INIT;
 
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	return 0;
+}
+
+/* SQ context is in place, let XDP start queueing to it */
+static void otx2_sq_start(struct otx2_nic *pfvf, u16 qidx)
+{
+	struct otx2_snd_queue *sq = &pfvf->qset.sq[qidx];
+
+	spin_lock_bh(&sq->xdp_lock);
+	sq->sqe_base = sq->sqe->base;
+	spin_unlock_bh(&sq->xdp_lock);
 }
 
 static int otx2_cq_init(struct otx2_nic *pfvf, u16 qidx)
 {
 	struct otx2_qset *qset = &pfvf->qset;
 	struct nix_aq_enq_req *aq;
+	int max_queues = pfvf->hw.max_queues;
 	struct otx2_cq_queue *cq;
-	int err, pool_id;
+	int err;
 
 	cq = &qset->cq[qidx];
 	cq->cqe_cnt = qset->cqe_cnt;
@@ -581,38 +1272,58 @@ static int otx2_cq_init(struct otx2_nic *pfvf, u16 qidx)
 	/* Save CQE CPU base for faster reference */
 	cq->cqe_base = cq->cqe->base;
 	cq->rbpool = &qset->pool[qidx];
-	/* In case where all RQs auras point to single pool,
-	 * all CQs receive buffer pool also point to same pool.
-	 */
-	pool_id = ((qidx < pfvf->hw.rx_queues) &&
-		   (pfvf->hw.rqpool_cnt != pfvf->hw.rx_queues)) ? 0 : qidx;
-	cq->rbpool = &qset->pool[pool_id];
 	cq->cq_idx = qidx;
 
 	/* Get memory to put this msg */
 	aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
-	if (!aq)
-		return -ENOMEM;
+	if (!aq) {
+		/* Shared mbox memory buffer is full, flush it and retry */
+		err = otx2_sync_mbox_aq(pfvf);
+		if (err)
+			return err;
+		aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
+		if (!aq)
+			return -ENOMEM;
+	}
 
 	aq->cq.ena = 1;
 	aq->cq.qsize = Q_SIZE(cq->cqe_cnt, 4);
 	aq->cq.caching = 1;
 	aq->cq.base = cq->cqe->iova;
-	aq->cq.cint_idx = (qidx < pfvf->hw.rx_queues) ? qidx
-				: (qidx - pfvf->hw.rx_queues);
-	cq->cint_idx = aq->cq.cint_idx;
+	aq->cq.avg_level = 255; /* CQ is empty to start with */
+	/* CQs of RQs, stack's SQs and XDP SQs in that order,
+	 * Nth queue of each type is mapped to CINT N.
+	 */
+	if (qidx < max_queues) {
+		cq->cq_type = CQ_RX;
+		cq->cint_idx = qidx;
+	} else if (qidx < 2 * max_queues) {
+		cq->cq_type = CQ_TX;
+		cq->cint_idx = qidx - max_queues;
+	} else {
+		cq->cq_type = CQ_XDP;
+		cq->cint_idx = qidx - 2 * max_queues;
+	}
+	aq->cq.cint_idx = cq->cint_idx;
+
+	/* Backpressure the receive channel before CQ overflows */
+	if (cq->cq_type == CQ_RX && pfvf->hw.rx_bp_ena) {
+		aq->cq.bp_ena = 1;
+		aq->cq.bpid = pfvf->hw.rx_bpid;
+		aq->cq.bp = otx2_rx_free_level(READ_ONCE(rx_bp_level));
+	}
 
 	/* Fill AQ info */
 	aq->qidx = qidx;
 	aq->ctype = NIX_AQ_CTYPE_CQ;
 	aq->op = NIX_AQ_INSTOP_INIT;
 
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	return 0;
 }
 
 int otx2_config_nix_queues(struct otx2_nic *pfvf)
 {
-	int qidx, err;
+	int qidx, sq, err;
 
 	/* Initialize RX queues */
 	for (qidx = 0; qidx < pfvf->hw.rx_queues; qidx++) {
@@ -628,13 +1339,43 @@ int otx2_config_nix_queues(struct otx2_nic *pfvf)
 			return err;
 	}
 
+	/* Initialize XDP SQs, if any */
+	for (qidx = 0; qidx < pfvf->hw.xdp_queues; qidx++) {
+		err = otx2_sq_init(pfvf, otx2_get_xdp_sq(pfvf, qidx));
+		if (err)
+			return err;
+	}
+
 	/* Initialize completion queues */
-	for (qidx = 0; qidx < pfvf->qset.cq_cnt; qidx++) {
+	for (qidx = 0; qidx < pfvf->hw.rx_queues; qidx++) {
 		err = otx2_cq_init(pfvf, qidx);
 		if (err)
 			return err;
 	}
 
+	for (qidx = 0; qidx < pfvf->hw.tx_queues; qidx++) {
+		err = otx2_cq_init(pfvf, otx2_get_sq_cq(pfvf, qidx));
+		if (err)
+			return err;
+	}
+
+	for (qidx = 0; qidx < pfvf->hw.xdp_queues; qidx++) {
+		sq = otx2_get_xdp_sq(pfvf, qidx);
+		err = otx2_cq_init(pfvf, otx2_get_sq_cq(pfvf, sq));
+		if (err)
+			return err;
+	}
+
+	/* Above only queued the AQ instructions, send out the remaining */
+	err = otx2_sync_mbox_aq(pfvf);
+	if (err)
+		return err;
+
+	for (qidx = 0; qidx < pfvf->hw.tx_queues; qidx++)
+		otx2_sq_start(pfvf, qidx);
+	for (qidx = 0; qidx < pfvf->hw.xdp_queues; qidx++)
+		otx2_sq_start(pfvf, otx2_get_xdp_sq(pfvf, qidx));
+
 	return 0;
 }
 
@@ -644,29 +1385,33 @@ int otx2_config_nix(struct otx2_nic *pfvf)
 	struct mbox_msghdr *rsp_hdr;
 	int err;
 
-	pfvf->qset.xqe_size = NIX_XQESZ_W16 ? 128 : 512;
+	/* Packets received into CQE need the bigger 512 byte CQEs */
+	pfvf->qset.xqe_size = otx2_rx_imm_ena(pfvf) ? 512 : 128;
 
 	/* Get memory to put this msg */
 	nixlf = otx2_mbox_alloc_msg_NIX_LF_ALLOC(&pfvf->mbox);
 	if (!nixlf)
 		return -ENOMEM;
 
-	/* Set RQ/SQ/CQ counts */
-	nixlf->rq_cnt = pfvf->hw.rx_queues;
-	nixlf->sq_cnt = pfvf->hw.tx_queues;
+	/* Set RQ/SQ/CQ counts, enough for the max no of queues
+	 * so that queues can be added without reallocating NIXLF.
+	 */
+	nixlf->rq_cnt = pfvf->hw.max_queues;
+	nixlf->sq_cnt = 2 * pfvf->hw.max_queues;
 	nixlf->cq_cnt = pfvf->qset.cq_cnt;
 	nixlf->rss_sz = MAX_RSS_INDIR_TBL_SIZE;
 	nixlf->rss_grps = 1; /* Single RSS indir table supported, for now */
-	nixlf->xqe_sz = NIX_XQESZ_W16;
+	nixlf->xqe_sz = otx2_rx_imm_ena(pfvf) ? NIX_XQESZ_W64 : NIX_XQESZ_W16;
 	/* We don't know absolute NPA LF idx attached.
 	 * AF will replace 'RVU_DEFAULT_PF_FUNC' with
 	 * NPA LF attached to this RVU PF/VF.
 	 */
 	nixlf->npa_func = RVU_DEFAULT_PF_FUNC;
 	/* Disable alignment pad, enable L2 length check,
-	 * enable L4 TCP/UDP checksum verification.
+	 * enable outer and inner L4 TCP/UDP checksum verification.
 	 */
-	nixlf->rx_cfg = BIT_ULL(33) | BIT_ULL(35) | BIT_ULL(37);
+	nixlf->rx_cfg = BIT_ULL(33) | BIT_ULL(34) | BIT_ULL(35) |
+			BIT_ULL(37);
 
 	err = otx2_sync_mbox_msg(&pfvf->mbox);
 	if (err)
@@ -679,49 +1424,190 @@ int otx2_config_nix(struct otx2_nic *pfvf)
 	return rsp_hdr->rc;
 }
 
+/* Have the receive channels backpressured by RQs' CQs and auras,
+ * CGX turns this into PAUSE or PFC frames when either is enabled.
+ * Channels of all PFC priorities are mapped to the same BPID. LMAC
+ * is shared with VFs, so only PF configures this. BPID is retained
+ * when disabled, as RQs' CQs and auras keep referring to it.
+ * Caller holds mbox lock.
+ */
+int otx2_nix_config_bp(struct otx2_nic *pfvf, bool enable)
+{
+	struct nix_bp_cfg_rsp *rsp;
+	struct nix_bp_cfg_req *req;
+	int err;
+
+	if (pfvf->pcifunc & RVU_PFVF_FUNC_MASK)
+		return 0;
+
+	if (enable)
+		req = otx2_mbox_alloc_msg_NIX_BP_ENABLE(&pfvf->mbox);
+	else
+		req = otx2_mbox_alloc_msg_NIX_BP_DISABLE(&pfvf->mbox);
+	if (!req)
+		return -ENOMEM;
+
+	req->chan_cnt = IEEE_8021QAZ_MAX_TCS;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		return err;
+
+	rsp = (struct nix_bp_cfg_rsp *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp))
+		return PTR_ERR(rsp);
+
+	if (rsp->hdr.rc || !enable)
+		return rsp->hdr.rc;
+
+	/* Not supported on LBK links */
+	pfvf->hw.rx_bp_ena = !!rsp->chan_cnt;
+	pfvf->hw.rx_bpid = rsp->bpid;
+	return 0;
+}
+EXPORT_SYMBOL(otx2_nix_config_bp);
+
+/* Keep receive channels backpressured only while CGX sends PAUSE or
+ * PFC frames for it, so that it isn't left on once both are turned
+ * off. Needs NIX LF, caller holds mbox lock.
+ */
+int otx2_nix_sync_bp(struct otx2_nic *pfvf)
+{
+	struct cgx_pause_frm_cfg *pause_req, *pause_rsp;
+	struct cgx_pfc_cfg *pfc_req, *pfc_rsp;
+	int err;
+
+	if ((pfvf->pcifunc & RVU_PFVF_FUNC_MASK) || !pfvf->hw.rx_bp_ena)
+		return 0;
+
+	pause_req = otx2_mbox_alloc_msg_CGX_CFG_PAUSE_FRM(&pfvf->mbox);
+	pfc_req = otx2_mbox_alloc_msg_CGX_CFG_PFC(&pfvf->mbox);
+	if (!pause_req || !pfc_req) {
+		otx2_mbox_reset(&pfvf->mbox.mbox, 0);
+		return -ENOMEM;
+	}
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		return err;
+
+	pause_rsp = (struct cgx_pause_frm_cfg *)
+		    otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &pause_req->hdr);
+	pfc_rsp = (struct cgx_pfc_cfg *)
+		  otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &pfc_req->hdr);
+	if (IS_ERR(pause_rsp))
+		return PTR_ERR(pause_rsp);
+	if (IS_ERR(pfc_rsp))
+		return PTR_ERR(pfc_rsp);
+	if (pause_rsp->hdr.rc)
+		return pause_rsp->hdr.rc;
+	if (pfc_rsp->hdr.rc)
+		return pfc_rsp->hdr.rc;
+
+	return otx2_nix_config_bp(pfvf, pause_rsp->tx_pause ||
+				  pfc_rsp->pfc_en);
+}
+EXPORT_SYMBOL(otx2_nix_sync_bp);
+
+int otx2_config_pause_frm(struct otx2_nic *pfvf, bool tx_pause,
+			  bool rx_pause)
+{
+	struct cgx_pause_frm_cfg *req;
+	struct mbox_msghdr *rsp_hdr;
+	int err = -ENOMEM;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_CGX_CFG_PAUSE_FRM(&pfvf->mbox);
+	if (!req)
+		goto unlock;
+
+	req->set = 1;
+	req->tx_pause = tx_pause;
+	req->rx_pause = rx_pause;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		goto unlock;
+
+	rsp_hdr = otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp_hdr))
+		err = PTR_ERR(rsp_hdr);
+	else
+		err = rsp_hdr->rc;
+
+	if (!err && netif_running(pfvf->netdev))
+		err = otx2_nix_sync_bp(pfvf);
+unlock:
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+EXPORT_SYMBOL(otx2_config_pause_frm);
+
+/* Free SQB or receive buffer pointers held by an aura */
+static void otx2_free_pool_ptrs(struct otx2_nic *pfvf, int pool_id)
+{
+	struct otx2_pool *pool = &pfvf->qset.pool[pool_id];
+	int headroom = 0;
+	u64 iova, pa;
+	void *va;
+
+	/* RQ buffer pointers point past the headroom */
+	if (pool_id < pfvf->hw.max_queues)
+		headroom = OTX2_HEAD_ROOM;
+
+	iova = otx2_aura_allocptr(pfvf, pool_id);
+	while (iova) {
+		iova -= headroom;
+		pa = otx2_iova_to_phys(pfvf->iommu_domain, iova);
+		va = phys_to_virt(pa);
+		otx2_put_rbuf(pfvf, pool, va, iova);
+		put_page(virt_to_page(va));
+		iova = otx2_aura_allocptr(pfvf, pool_id);
+	}
+	otx2_page_cache_free(pfvf, pool);
+}
+
 void otx2_free_aura_ptr(struct otx2_nic *pfvf, int type)
 {
 	int pool_id, pool_start = 0, pool_end = 0;
-	struct otx2_pool *pool;
-	u64 iova, pa;
 
 	if (type == NIX_AQ_CTYPE_SQ) {
-		pool_start = pfvf->hw.rx_queues;
+		pool_start = pfvf->hw.max_queues;
 		pool_end = pfvf->hw.pool_cnt;
 	}
 	if (type == NIX_AQ_CTYPE_RQ) {
 		pool_start = 0;
-		pool_end = pfvf->hw.rqpool_cnt;
+		pool_end = pfvf->hw.max_queues;
 	}
 
 	/* Free SQB and RQB pointers from the aura pool */
 	for (pool_id = pool_start; pool_id < pool_end; pool_id++) {
-		pool = &pfvf->qset.pool[pool_id];
-		iova = otx2_aura_allocptr(pfvf, pool_id);
-		while (iova) {
-			pa = otx2_iova_to_phys(pfvf->iommu_domain, iova);
-			dma_unmap_page_attrs(pfvf->dev, iova, RCV_FRAG_LEN,
-					     DMA_FROM_DEVICE,
-					     DMA_ATTR_SKIP_CPU_SYNC);
-			put_page(virt_to_page(phys_to_virt(pa)));
-			iova = otx2_aura_allocptr(pfvf, pool_id);
-		}
+		if (pfvf->qset.pool[pool_id].stack)
+			otx2_free_pool_ptrs(pfvf, pool_id);
 	}
 }
 
+static void otx2_pool_free(struct otx2_nic *pfvf, int pool_id)
+{
+	struct otx2_pool *pool = &pfvf->qset.pool[pool_id];
+
+	qmem_free(pfvf->dev, pool->stack);
+	qmem_free(pfvf->dev, pool->fc_addr);
+	kfree(pool->cache.pages);
+	kfree(pool->cache.iova);
+	memset(pool, 0, sizeof(*pool));
+}
+
 void otx2_aura_pool_free(struct otx2_nic *pfvf)
 {
-	struct otx2_pool *pool;
 	int pool_id;
 
 	if (!pfvf->qset.pool)
 		return;
 
-	for (pool_id = 0; pool_id < pfvf->hw.pool_cnt; pool_id++) {
-		pool = &pfvf->qset.pool[pool_id];
-		qmem_free(pfvf->dev, pool->stack);
-		qmem_free(pfvf->dev, pool->fc_addr);
-	}
+	for (pool_id = 0; pool_id < pfvf->hw.pool_cnt; pool_id++)
+		otx2_pool_free(pfvf, pool_id);
 	devm_kfree(pfvf->dev, pfvf->qset.pool);
 }
 
@@ -747,7 +1633,7 @@ static int otx2_aura_init(struct otx2_nic *pfvf, int aura_id,
 	aq = otx2_mbox_alloc_msg_NPA_AQ_ENQ(&pfvf->mbox);
 	if (!aq) {
 		/* Shared mbox memory buffer is full, flush it and retry */
-		err = otx2_sync_mbox_msg(&pfvf->mbox);
+		err = otx2_sync_mbox_aq(pfvf);
 		if (err)
 			return err;
 		aq = otx2_mbox_alloc_msg_NPA_AQ_ENQ(&pfvf->mbox);
@@ -760,6 +1646,7 @@ static int otx2_aura_init(struct otx2_nic *pfvf, int aura_id,
 	aq->aura.pool_addr = pool_id;
 	aq->aura.pool_caching = 1;
 	aq->aura.shift = ilog2(numptrs) - 8;
+	aq->aura.avg_level = 255; /* All buffers are free to start with */
 	aq->aura.count = numptrs;
 	/* In case where all RQ's auras points to a single pool,
 	 * buffer pointers are freed to Aura 0 only.
@@ -772,6 +1659,15 @@ static int otx2_aura_init(struct otx2_nic *pfvf, int aura_id,
 	aq->aura.fc_addr = pool->fc_addr->iova;
 	aq->aura.fc_hyst_bits = 0; /* Store count on all updates */
 
+	/* Backpressure the receive channel before RQ's aura runs out of
+	 * buffers, NIX0 BPID is the one used.
+	 */
+	if (aura_id < pfvf->hw.max_queues && pfvf->hw.rx_bp_ena) {
+		aq->aura.bp_ena = BIT(0);
+		aq->aura.nix0_bpid = pfvf->hw.rx_bpid;
+		aq->aura.bp = otx2_rx_free_level(READ_ONCE(rx_bp_level));
+	}
+
 	/* Fill AQ info */
 	aq->ctype = NPA_AQ_CTYPE_AURA;
 	aq->op = NPA_AQ_INSTOP_INIT;
@@ -794,12 +1690,17 @@ static int otx2_pool_init(struct otx2_nic *pfvf, u16 pool_id,
 		return err;
 
 	pool->rbsize = buf_size;
+	/* Buffers bigger than a page are carved out of compound pages
+	 * fitting a few of them, which bounds space wasted at the tail.
+	 */
+	pool->page_order = buf_size > PAGE_SIZE ? get_order(buf_size * 3) : 0;
+	pool->node = otx2_queue_node(pfvf, pool_id);
 
 	/* Initialize this pool's context via AF */
 	aq = otx2_mbox_alloc_msg_NPA_AQ_ENQ(&pfvf->mbox);
 	if (!aq) {
 		/* Shared mbox memory buffer is full, flush it and retry */
-		err = otx2_sync_mbox_msg(&pfvf->mbox);
+		err = otx2_sync_mbox_aq(pfvf);
 		if (err) {
 			qmem_free(pfvf->dev, pool->stack);
 			return err;
@@ -828,10 +1729,11 @@ static int otx2_pool_init(struct otx2_nic *pfvf, u16 pool_id,
 	return 0;
 }
 
-int otx2_sq_aura_pool_init(struct otx2_nic *pfvf)
+/* Init SQB auras and pools of SQs from 'start' to 'end' - 1 */
+int otx2_sq_aura_pool_init(struct otx2_nic *pfvf, int start, int end)
 {
 	struct otx2_qset *qset = &pfvf->qset;
-	int pool_id, stack_pages, num_sqbs;
+	int qidx, pool_id, stack_pages, num_sqbs;
 	struct otx2_hw *hw = &pfvf->hw;
 	struct otx2_pool *pool;
 	int err, ptr;
@@ -849,7 +1751,8 @@ int otx2_sq_aura_pool_init(struct otx2_nic *pfvf)
 	stack_pages =
 		(num_sqbs + hw->stack_pg_ptrs - 1) / hw->stack_pg_ptrs;
 
-	for (pool_id = hw->rx_queues; pool_id < hw->pool_cnt; pool_id++) {
+	for (qidx = start; qidx < end; qidx++) {
+		pool_id = otx2_get_sq_cq(pfvf, qidx);
 		/* Initialize aura context */
 		err = otx2_aura_init(pfvf, pool_id, pool_id, num_sqbs);
 		if (err)
@@ -863,15 +1766,16 @@ int otx2_sq_aura_pool_init(struct otx2_nic *pfvf)
 	}
 
 	/* Flush accumulated messages */
-	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	err = otx2_sync_mbox_aq(pfvf);
 	if (err)
 		goto fail;
 
 	/* Allocate pointers and free them to aura/pool */
-	for (pool_id = hw->rx_queues; pool_id < hw->pool_cnt; pool_id++) {
+	for (qidx = start; qidx < end; qidx++) {
+		pool_id = otx2_get_sq_cq(pfvf, qidx);
 		pool = &pfvf->qset.pool[pool_id];
 		for (ptr = 0; ptr < num_sqbs; ptr++) {
-			bufptr = otx2_alloc_rbuf(pfvf, pool);
+			bufptr = otx2_alloc_rbuf(pfvf, pool, GFP_KERNEL);
 			if (bufptr <= 0)
 				return bufptr;
 			otx2_aura_freeptr(pfvf, pool_id, bufptr);
@@ -881,14 +1785,16 @@ int otx2_sq_aura_pool_init(struct otx2_nic *pfvf)
 
 	return 0;
 fail:
-	otx2_aura_pool_free(pfvf);
+	for (qidx = start; qidx < end; qidx++)
+		otx2_pool_free(pfvf, otx2_get_sq_cq(pfvf, qidx));
 	return err;
 }
 
-int otx2_rq_aura_pool_init(struct otx2_nic *pfvf)
+/* Init receive buffer auras and pools of RQs from 'start' to 'end' - 1 */
+int otx2_rq_aura_pool_init(struct otx2_nic *pfvf, int start, int end)
 {
-	int stack_pages, pool_id, aura_id;
 	struct otx2_hw *hw = &pfvf->hw;
+	int stack_pages, pool_id;
 	struct otx2_pool *pool;
 	int err, ptr;
 	s64 bufptr;
@@ -896,44 +1802,234 @@ int otx2_rq_aura_pool_init(struct otx2_nic *pfvf)
 	stack_pages =
 		(RQ_QLEN + hw->stack_pg_ptrs - 1) / hw->stack_pg_ptrs;
 
-	for (aura_id = 0; aura_id < hw->rx_queues; aura_id++) {
-		pool_id = (hw->rqpool_cnt == hw->rx_queues) ? aura_id : 0;
+	for (pool_id = start; pool_id < end; pool_id++) {
 		/* Initialize aura context */
-		err = otx2_aura_init(pfvf, aura_id, pool_id, RQ_QLEN);
+		err = otx2_aura_init(pfvf, pool_id, pool_id, RQ_QLEN);
 		if (err)
 			goto fail;
-	}
 
-	for (pool_id = 0; pool_id < hw->rqpool_cnt; pool_id++) {
 		err = otx2_pool_init(pfvf, pool_id, stack_pages,
-				     RQ_QLEN, RCV_FRAG_LEN);
+				     RQ_QLEN, RCV_FRAG_LEN(hw->rbuf_len));
+		if (err)
+			goto fail;
+		err = otx2_page_cache_init(pfvf, &pfvf->qset.pool[pool_id]);
 		if (err)
 			goto fail;
 	}
 
 	/* Flush accumulated messages */
-	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	err = otx2_sync_mbox_aq(pfvf);
 	if (err)
 		goto fail;
 
 	/* Allocate pointers and free them to aura/pool */
-	for (pool_id = 0; pool_id < hw->rqpool_cnt; pool_id++) {
+	for (pool_id = start; pool_id < end; pool_id++) {
 		pool = &pfvf->qset.pool[pool_id];
 		for (ptr = 0; ptr < RQ_QLEN; ptr++) {
-			bufptr = otx2_alloc_rbuf(pfvf, pool);
+			bufptr = otx2_alloc_rbuf(pfvf, pool, GFP_KERNEL);
 			if (bufptr <= 0)
 				return bufptr;
-			otx2_aura_freeptr(pfvf, pool_id, bufptr);
+			otx2_aura_freeptr(pfvf, pool_id,
+					  bufptr + OTX2_HEAD_ROOM);
 		}
 		otx2_get_page(pool);
 	}
 
 	return 0;
 fail:
-	otx2_aura_pool_free(pfvf);
+	for (pool_id = start; pool_id < end; pool_id++)
+		otx2_pool_free(pfvf, pool_id);
+	return err;
+}
+
+/* Disable a single RQ/SQ/CQ context, unlike otx2_ctx_disable()
+ * which disables all contexts of the given type.
+ */
+static int otx2_nix_ctx_disable(struct otx2_nic *pfvf, int ctype, int qidx)
+{
+	struct nix_aq_enq_req *aq;
+
+	aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pfvf->mbox);
+	if (!aq)
+		return -ENOMEM;
+
+	if (ctype == NIX_AQ_CTYPE_RQ)
+		aq->rq_mask.ena = 1;
+	else if (ctype == NIX_AQ_CTYPE_SQ)
+		aq->sq_mask.ena = 1;
+	else
+		aq->cq_mask.ena = 1;
+
+	aq->qidx = qidx;
+	aq->ctype = ctype;
+	aq->op = NIX_AQ_INSTOP_WRITE;
+
+	return otx2_sync_mbox_msg(&pfvf->mbox);
+}
+
+static int otx2_npa_ctx_disable(struct otx2_nic *pfvf, int ctype, int id)
+{
+	struct npa_aq_enq_req *aq;
+
+	aq = otx2_mbox_alloc_msg_NPA_AQ_ENQ(&pfvf->mbox);
+	if (!aq)
+		return -ENOMEM;
+
+	if (ctype == NPA_AQ_CTYPE_AURA)
+		aq->aura_mask.ena = 1;
+	else
+		aq->pool_mask.ena = 1;
+
+	aq->aura_id = id;
+	aq->ctype = ctype;
+	aq->op = NPA_AQ_INSTOP_WRITE;
+
+	return otx2_sync_mbox_msg(&pfvf->mbox);
+}
+
+static void otx2_cq_free(struct otx2_nic *pfvf, int qidx)
+{
+	struct otx2_cq_queue *cq = &pfvf->qset.cq[qidx];
+
+	if (!cq->cqe)
+		return;
+
+	otx2_nix_ctx_disable(pfvf, NIX_AQ_CTYPE_CQ, qidx);
+	qmem_free(pfvf->dev, cq->cqe);
+	memset(cq, 0, sizeof(*cq));
+}
+
+static void otx2_queue_pool_free(struct otx2_nic *pfvf, int pool_id)
+{
+	if (pfvf->qset.pool[pool_id].stack) {
+		otx2_free_pool_ptrs(pfvf, pool_id);
+		otx2_npa_ctx_disable(pfvf, NPA_AQ_CTYPE_AURA, pool_id);
+		otx2_npa_ctx_disable(pfvf, NPA_AQ_CTYPE_POOL, pool_id);
+	}
+	otx2_pool_free(pfvf, pool_id);
+}
+
+/* Below APIs bring up or tear down a single queue while rest of the
+ * queues keep running. CINT of the queue is expected to be quiesced
+ * by the caller, NIX and NPA LFs stay as is.
+ */
+int otx2_txq_init(struct otx2_nic *pfvf, int qidx)
+{
+	int err;
+
+	err = otx2_sq_aura_pool_init(pfvf, qidx, qidx + 1);
+	if (err)
+		goto fail;
+
+	err = otx2_cq_init(pfvf, otx2_get_sq_cq(pfvf, qidx));
+	if (err)
+		goto fail;
+
+	err = otx2_sq_init(pfvf, qidx);
+	if (err)
+		goto fail;
+
+	err = otx2_sync_mbox_aq(pfvf);
+	if (err)
+		goto fail;
+
+	otx2_sq_start(pfvf, qidx);
+	return 0;
+fail:
+	otx2_txq_free(pfvf, qidx);
+	return err;
+}
+
+void otx2_txq_free(struct otx2_nic *pfvf, int qidx)
+{
+	struct otx2_snd_queue *sq = &pfvf->qset.sq[qidx];
+	int cq_idx = otx2_get_sq_cq(pfvf, qidx);
+	struct otx2_cq_queue *cq;
+
+	/* Stop XDP from queueing any more SQEs */
+	spin_lock_bh(&sq->xdp_lock);
+	sq->sqe_base = NULL;
+	spin_unlock_bh(&sq->xdp_lock);
+
+	if (sq->sqe)
+		otx2_nix_ctx_disable(pfvf, NIX_AQ_CTYPE_SQ, qidx);
+
+	/* Send completions refer SQ's sg list, so dequeue them first */
+	cq = &pfvf->qset.cq[cq_idx];
+	if (cq->cqe)
+		otx2_napi_handler(cq, pfvf, cq->cqe_cnt);
+
+	qmem_free(pfvf->dev, sq->sqe);
+	qmem_free(pfvf->dev, sq->jump);
+	qmem_free(pfvf->dev, sq->timestamps);
+	kfree(sq->sg);
+	sq->sqe = NULL;
+	sq->jump = NULL;
+	sq->timestamps = NULL;
+	sq->sg = NULL;
+
+	otx2_cq_free(pfvf, cq_idx);
+	otx2_queue_pool_free(pfvf, cq_idx);
+}
+
+/* A RQ comes up along with it's XDP SQ, if a program is attached */
+int otx2_rxq_init(struct otx2_nic *pfvf, int qidx)
+{
+	int err;
+
+	err = otx2_rq_aura_pool_init(pfvf, qidx, qidx + 1);
+	if (err)
+		goto fail;
+
+	err = otx2_cq_init(pfvf, qidx);
+	if (err)
+		goto fail;
+
+	err = otx2_rq_init(pfvf, qidx);
+	if (err)
+		goto fail;
+
+	err = otx2_sync_mbox_aq(pfvf);
+	if (err)
+		goto fail;
+
+	if (pfvf->xdp_prog) {
+		err = otx2_txq_init(pfvf, otx2_get_xdp_sq(pfvf, qidx));
+		if (err)
+			goto fail;
+	}
+
+	return 0;
+fail:
+	otx2_rxq_free(pfvf, qidx);
 	return err;
 }
 
+void otx2_rxq_free(struct otx2_nic *pfvf, int qidx)
+{
+	struct otx2_rcv_queue *rq = &pfvf->qset.rq[qidx];
+	struct otx2_cq_queue *cq = &pfvf->qset.cq[qidx];
+	int xdp_sq = otx2_get_xdp_sq(pfvf, qidx);
+
+	if (cq->cqe)
+		otx2_nix_ctx_disable(pfvf, NIX_AQ_CTYPE_RQ, qidx);
+
+	/* XDP_TX'ed buffers go back to RQ's aura upon send completion,
+	 * so XDP SQ has to be gone before the aura.
+	 */
+	if (pfvf->qset.sq[xdp_sq].sqe)
+		otx2_txq_free(pfvf, xdp_sq);
+
+	if (cq->cqe)
+		otx2_napi_handler(cq, pfvf, cq->cqe_cnt);
+
+	if (xdp_rxq_info_is_reg(&rq->xdp_rxq))
+		xdp_rxq_info_unreg(&rq->xdp_rxq);
+
+	otx2_cq_free(pfvf, qidx);
+	otx2_queue_pool_free(pfvf, qidx);
+}
+
 int otx2_config_npa(struct otx2_nic *pfvf)
 {
 	struct otx2_qset *qset = &pfvf->qset;
@@ -946,8 +2042,10 @@ int otx2_config_npa(struct otx2_nic *pfvf)
 	 * Aura - Alloc/frees pointers from/to pool for NIX DMA.
 	 */
 
-	/* Rx and Tx queues will have their own aura & pool in a 1:1 config */
-	hw->pool_cnt = hw->rx_queues + hw->tx_queues;
+	/* Rx and Tx queues will have their own aura & pool in a 1:1 config,
+	 * one per CQ of max no of RQs, SQs and XDP SQs.
+	 */
+	hw->pool_cnt = 3 * hw->max_queues;
 
 	qset->pool = devm_kzalloc(pfvf->dev, sizeof(struct otx2_pool) *
 				  hw->pool_cnt, GFP_KERNEL);
@@ -1056,32 +2154,6 @@ void otx2_ctx_disable(struct mbox *mbox, int type, bool npa)
 	WARN_ON(otx2_sync_mbox_msg(mbox));
 }
 
-static inline void otx2_nix_rq_op_stats(struct queue_stats *stats,
-					struct otx2_nic *pfvf, int qidx)
-{
-	u64 incr = (u64)qidx << 32;
-	atomic64_t *ptr;
-
-	ptr = (__force atomic64_t *)(pfvf->reg_base + NIX_LF_RQ_OP_OCTS);
-	stats->bytes = atomic64_fetch_add_relaxed(incr, ptr);
-
-	ptr = (__force atomic64_t *)(pfvf->reg_base + NIX_LF_RQ_OP_PKTS);
-	stats->pkts = atomic64_fetch_add_relaxed(incr, ptr);
-}
-
-static inline void otx2_nix_sq_op_stats(struct queue_stats *stats,
-					struct otx2_nic *pfvf, int qidx)
-{
-	u64 incr = (u64)qidx << 32;
-	atomic64_t *ptr;
-
-	ptr = (__force atomic64_t *)(pfvf->reg_base + NIX_LF_SQ_OP_OCTS);
-	stats->bytes = atomic64_fetch_add_relaxed(incr, ptr);
-
-	ptr = (__force atomic64_t *)(pfvf->reg_base + NIX_LF_SQ_OP_PKTS);
-	stats->pkts = atomic64_fetch_add_relaxed(incr, ptr);
-}
-
 /* Mbox message handlers */
 void mbox_handler_CGX_STATS(struct otx2_nic *pfvf,
 			    struct cgx_stats_rsp *rsp)
@@ -1128,6 +2200,8 @@ void mbox_handler_NIX_LF_ALLOC(struct otx2_nic *pfvf,
 		ether_addr_copy(pfvf->netdev->dev_addr, rsp->mac_addr);
 	pfvf->hw.lso_tsov4_idx = rsp->lso_tsov4_idx;
 	pfvf->hw.lso_tsov6_idx = rsp->lso_tsov6_idx;
+	pfvf->hw.lso_udp_tun_idx = rsp->lso_udp_tun_idx;
+	pfvf->hw.lso_ip_tun_idx = rsp->lso_ip_tun_idx;
 }
 EXPORT_SYMBOL(mbox_handler_NIX_LF_ALLOC);
 
@@ -11,13 +11,18 @@
 #ifndef OTX2_COMMON_H
 #define OTX2_COMMON_H
 
+#include <linux/net_tstamp.h>
+#include <linux/ptp_clock_kernel.h>
+#include <linux/timecounter.h>
 #include <mbox.h>
+#include <npc.h>
 
 #include "otx2_reg.h"
 #include "otx2_txrx.h"
 
 /* PCI device IDs */
 #define PCI_DEVID_OCTEONTX2_RVU_PF              0xA063
+#define PCI_DEVID_OCTEONTX2_RVU_VF		0xA064
 #define PCI_DEVID_OCTEONTX2_RVU_AFVF		0xA0F8
 
 /* PCI BAR nos */
@@ -33,6 +38,12 @@
 #define NIX_LF_ERR_VEC		0x81
 #define NIX_LF_POISON_VEC	0x82
 
+/* NIX transmit shaper rates, in Mbps */
+#define OTX2_MIN_TX_RATE	2
+#define OTX2_MAX_TX_RATE	100000
+/* Max burst in TLx_CIR/PIR, BURST_EXPONENT and BURST_MANTISSA */
+#define TLX_BURST_MAX		((0xFULL << 37) | (0xFFULL << 29))
+
 /* NIX TX stats */
 enum nix_stat_lf_tx {
 	TX_UCAST	= 0x0,
@@ -67,6 +78,9 @@ struct  otx2_dev_stats {
 	u64 rx_bcast_frames;
 	u64 rx_mcast_frames;
 	u64 rx_drops;
+	u64 rx_queue_drops; /* RQ drops, RED and no CQE or buffer space */
+	u64 rx_page_recycle_hits;
+	u64 rx_page_recycle_misses;
 
 	u64 tx_bytes;
 	u64 tx_frames;
@@ -74,12 +88,14 @@ struct  otx2_dev_stats {
 	u64 tx_bcast_frames;
 	u64 tx_mcast_frames;
 	u64 tx_drops;
+	u64 tx_linearized;
 };
 
 /* RSS configuration */
 struct otx2_rss_info {
 	bool enable;
 	u32 flowkey_cfg;
+	u8  flowkey_alg_idx; /* Hash algorithm AF picked for 'flowkey_cfg' */
 	u16 rss_size;
 	u8  ind_tbl[MAX_RSS_INDIR_TBL_SIZE];
 #define RSS_HASH_KEY_SIZE	44   /* 352 bit key */
@@ -92,6 +108,11 @@ struct  mbox {
 	struct otx2_mbox	mbox_up;
 	struct work_struct	mbox_up_wrk;
 	struct otx2_nic		*pfvf;
+	/* Serializes use of 'mbox', from allocating the first message
+	 * of a batch till its responses are read. PF also sends its
+	 * VFs' messages to AF over it.
+	 */
+	struct mutex		lock;
 };
 
 struct otx2_hw {
@@ -100,13 +121,18 @@ struct otx2_hw {
 	struct otx2_rss_info	rss_info;
 	u16                     rx_queues;
 	u16                     tx_queues;
+	u16			xdp_queues; /* One XDP SQ per RQ */
 	u16			max_queues;
 	u16			pool_cnt;
+	/* Per queue SW stats, these stay across interface down/up */
+	struct otx2_rq_stats	*rq_stats;
+	struct otx2_sq_stats	*sq_stats;
 
 	/* NPA */
 	u32			stack_pg_ptrs;  /* No of ptrs per stack page */
 	u32			stack_pg_bytes; /* Size of stack page */
 	u16			sqb_size;
+	u16			rbuf_len; /* Receive buffer data size */
 
 	/* MSI-X*/
 	u16			num_vec;
@@ -117,17 +143,119 @@ struct otx2_hw {
 	cpumask_var_t           *affinity_mask;
 
 	u8			cint_cnt; /* CQ interrupt count */
-	u16			rqpool_cnt;
 	u16		txschq_list[NIX_TXSCH_LVL_CNT][MAX_TXSCHQ_PER_FUNC];
+	/* Per traffic class shaper rates in Mbps, zero if not set */
+	u32			tc_min_rate[TC_MAX_QUEUE];
+	u32			tc_max_rate[TC_MAX_QUEUE];
 
 	/* For TSO segmentation */
 	u8			lso_tsov4_idx;
 	u8			lso_tsov6_idx;
+	u8			lso_udp_tun_idx;
+	u8			lso_ip_tun_idx;
+
+	/* Receive backpressure, for PAUSE/PFC */
+	bool			rx_bp_ena;
+	u16			rx_bpid;
 
 	u64			cgx_rx_stats[CGX_RX_STATS_COUNT];
 	u64			cgx_tx_stats[CGX_TX_STATS_COUNT];
 };
 
+/* Header fields in MCAM search key, an ntuple rule can match on */
+enum otx2_key_field {
+	OTX2_KF_DMAC,
+	OTX2_KF_SMAC,
+	OTX2_KF_ETYPE,
+	OTX2_KF_VLAN_TCI,
+	OTX2_KF_SIP4,
+	OTX2_KF_DIP4,
+	OTX2_KF_TOS,
+	OTX2_KF_TCP_SPORT,
+	OTX2_KF_TCP_DPORT,
+	OTX2_KF_UDP_SPORT,
+	OTX2_KF_UDP_DPORT,
+	OTX2_KF_MAX,
+};
+
+struct otx2_flow {
+	struct ethtool_rx_flow_spec	flow_spec;
+	struct list_head		list;
+};
+
+struct otx2_flow_config {
+#define OTX2_MAX_NTUPLE_FLOWS	32
+	/* Search key layout as per NPC KEX profile, bit offset
+	 * of each field in the key or -1 if it's not extracted.
+	 */
+	bool			kex_valid;
+	s16			chan_bit;
+	s16			ltype_bit[NPC_MAX_LID];
+	s16			field_bit[OTX2_KF_MAX];
+	/* Contiguous MCAM entries, rule at 'location' uses
+	 * 'entry + location'. AF frees them along with NIX LF.
+	 */
+	bool			entry_valid;
+	u16			entry;
+	u32			nr_flows;
+	struct list_head	flow_list; /* Sorted by location */
+};
+
+/* tc flower rule offloaded to a MCAM entry with a hit counter */
+struct otx2_tc_flow {
+	struct list_head	list;
+	unsigned long		cookie;
+	u16			prio;
+	bool			installed;
+	bool			vlan_pop;
+	u16			entry;
+	u16			cntr;
+	u64			last_pkts; /* Counter value last reported */
+	unsigned long		lastused;
+	struct mcam_entry	entry_data;
+};
+
+struct otx2_tc_info {
+#define OTX2_MAX_TC_FLOWS	256
+	u32			nr_flows;
+	struct list_head	flow_list; /* Sorted by prio */
+};
+
+/* Admin set config of a VF, enforced by PF as it relays VF's
+ * messages to AF. Also the VF's resources PF needs to know of.
+ */
+struct otx2_vf_config {
+	struct otx2_nic		*pf;
+	struct work_struct	mbox_wrk; /* VF => PF requests */
+	struct work_struct	mbox_up_wrk; /* Acks to PF => VF notices */
+	struct work_struct	link_event_wrk;
+	struct work_struct	flr_wrk;
+	u8			mac[ETH_ALEN];
+	bool			trusted;
+	u32			min_tx_rate; /* In Mbps, zero if not set */
+	u32			max_tx_rate;
+	bool			nixlf_valid;
+	u16			rq_cnt;
+	u16			sq_cnt;
+	bool			tl2_valid;
+	u16			tl2_schq;
+};
+
+/* PHC backed by the RVU PTP block, which AF owns. Clock is read
+ * via mbox, so it's kept in a timecounter to save mbox round trips.
+ * PTP block is shared by all ports, so each PF's PHC is adjusted
+ * in its timecounter alone and leaves the PTP block untouched.
+ */
+struct otx2_ptp {
+	struct ptp_clock_info	ptp_info;
+	struct ptp_clock	*ptp_clock;
+	struct otx2_nic		*nic;
+
+	struct cyclecounter	cycle_counter;
+	struct timecounter	time_counter;
+	struct mutex		lock; /* Serializes timecounter updates */
+};
+
 struct otx2_nic {
 	void __iomem		*reg_base;
 	struct pci_dev		*pdev;
@@ -146,7 +274,29 @@ struct otx2_nic {
 	u16			tx_chan_base;
 	u8			cq_time_wait;
 	u32			cq_ecount_wait;
+	u16			rx_copybreak; /* Max pkt size put in CQE */
+	u16			tx_copybreak; /* Max pkt size put in SQE */
+	bool			rx_red_ena; /* RED on CQ and aura levels */
+	bool			adaptive_coalesce;
 	struct work_struct	reset_task;
+	struct bpf_prog		*xdp_prog;
+	struct otx2_flow_config	flow_cfg;
+	struct otx2_tc_info	tc_info;
+	struct work_struct	rx_mode_work;
+
+	/* SR-IOV, PF <=> VF mailbox */
+	int			num_vfs;
+	struct otx2_vf_config	*vf_configs;
+	struct otx2_mbox	pfvf_mbox;
+	struct otx2_mbox	pfvf_mbox_up;
+	struct workqueue_struct *pfvf_mbox_wq;
+	struct cgx_link_user_info linfo; /* Last link event from AF */
+
+	/* PTP timestamping */
+	struct otx2_ptp		*ptp;
+	struct hwtstamp_config	tstamp;
+	bool			hw_rx_tstamp;
+	bool			hw_tx_tstamp;
 
 	int (*register_mbox_intr)(struct otx2_nic *);
 };
@@ -221,7 +371,7 @@ static inline void otx2_aura_freeptr(struct otx2_nic *pfvf,
 	otx2_write128(val, pfvf->reg_base + NPA_LF_AURA_OP_FREE0);
 }
 
-/* Update page ref count */
+/* Update page ref count with the buffers carved out of it so far */
 static inline void otx2_get_page(struct otx2_pool *pool)
 {
 	if (!pool->page)
@@ -230,7 +380,61 @@ static inline void otx2_get_page(struct otx2_pool *pool)
 	if (pool->pageref)
 		page_ref_add(pool->page, pool->pageref);
 	pool->pageref = 0;
-	pool->page = NULL;
+}
+
+/* XDP_TX transmits straight out of receive buffers, so device
+ * needs read access to them as well when a program is attached.
+ */
+static inline enum dma_data_direction otx2_rx_dma_dir(struct otx2_nic *pfvf)
+{
+	return pfvf->xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+}
+
+/* RQ, SQ and CQ contexts, and auras backing them, are at fixed
+ * offsets so that queues can be added or removed while the rest
+ * keep running. Stack's SQs start at 0 and XDP SQs at 'max_queues'.
+ * RQs' CQs start at 0 and a SQ's CQ is at 'max_queues' + SQ index.
+ * Every CQ has the aura/pool of same index, with either receive
+ * buffers of the RQ or SQBs of the SQ.
+ */
+static inline int otx2_get_xdp_sq(struct otx2_nic *pfvf, int rq)
+{
+	return pfvf->hw.max_queues + rq;
+}
+
+static inline int otx2_get_sq_cq(struct otx2_nic *pfvf, int sq)
+{
+	return pfvf->hw.max_queues + sq;
+}
+
+/* Small packets are received into CQE, not done with XDP which
+ * needs packets in receive buffers.
+ */
+static inline bool otx2_rx_imm_ena(struct otx2_nic *pfvf)
+{
+	return pfvf->rx_copybreak && !pfvf->xdp_prog;
+}
+
+/* Receive buffers hold a whole frame of the MTU they are set up for,
+ * so that jumbo frames don't get split across many buffers.
+ */
+static inline u16 otx2_get_rbuf_len(int mtu)
+{
+	int frs = mtu + OTX2_ETH_HLEN + OTX2_HW_TIMESTAMP_LEN;
+
+	return max_t(int, DMA_BUFFER_LEN, ALIGN(frs, 128));
+}
+
+/* Each stack SQ has a SMQ of its own at the same index, XDP SQs
+ * share the one after them. TL4 level has one per traffic class.
+ */
+static inline int otx2_txschq_cnt(struct otx2_nic *pfvf, int lvl)
+{
+	if (lvl == NIX_TXSCH_LVL_SMQ)
+		return pfvf->hw.max_queues + 1;
+	if (lvl == NIX_TXSCH_LVL_TL4)
+		return max_t(int, netdev_get_num_tc(pfvf->netdev), 1);
+	return 1;
 }
 
 /* Mbox APIs */
@@ -290,16 +494,29 @@ void otx2_disable_msix(struct otx2_nic *pfvf);
 int otx2_attach_npa_nix(struct otx2_nic *pfvf);
 int otx2_detach_resources(struct mbox *mbox);
 int otx2_config_npa(struct otx2_nic *pfvf);
-int otx2_sq_aura_pool_init(struct otx2_nic *pfvf);
-int otx2_rq_aura_pool_init(struct otx2_nic *pfvf);
+int otx2_sq_aura_pool_init(struct otx2_nic *pfvf, int start, int end);
+int otx2_rq_aura_pool_init(struct otx2_nic *pfvf, int start, int end);
 void otx2_aura_pool_free(struct otx2_nic *pfvf);
 void otx2_free_aura_ptr(struct otx2_nic *pfvf, int type);
 int otx2_config_nix(struct otx2_nic *pfvf);
+int otx2_nix_config_bp(struct otx2_nic *pfvf, bool enable);
+int otx2_nix_sync_bp(struct otx2_nic *pfvf);
+int otx2_config_pause_frm(struct otx2_nic *pfvf, bool tx_pause,
+			  bool rx_pause);
 int otx2_config_nix_queues(struct otx2_nic *pfvf);
-int otx2_txschq_config(struct otx2_nic *pfvf, int lvl);
+int otx2_rxq_init(struct otx2_nic *pfvf, int qidx);
+void otx2_rxq_free(struct otx2_nic *pfvf, int qidx);
+int otx2_txq_init(struct otx2_nic *pfvf, int qidx);
+void otx2_txq_free(struct otx2_nic *pfvf, int qidx);
+u64 otx2_get_txschq_rate_regval(u32 rate);
+int otx2_txschq_config(struct otx2_nic *pfvf, int lvl, int idx);
+int otx2_set_tx_maxrate(struct net_device *netdev, int qidx, u32 rate);
 int otx2_txsch_alloc(struct otx2_nic *pfvf);
 int otx2_txschq_stop(struct otx2_nic *pfvf);
-dma_addr_t otx2_alloc_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool);
+dma_addr_t otx2_alloc_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool,
+			   gfp_t gfp);
+void otx2_put_rbuf(struct otx2_nic *pfvf, struct otx2_pool *pool,
+		   void *va, u64 iova);
 int otx2_rxtx_enable(struct otx2_nic *pfvf, bool enable);
 void otx2_ctx_disable(struct mbox *mbox, int type, bool npa);
 
@@ -309,17 +526,27 @@ void otx2_get_dev_stats(struct otx2_nic *pfvf);
 void otx2_get_stats64(struct net_device *netdev,
 		      struct rtnl_link_stats64 *stats);
 void otx2_set_irq_affinity(struct otx2_nic *pfvf);
+void otx2_set_cint_affinity(struct otx2_nic *pfvf, int cint);
+void otx2_set_xps_queue(struct otx2_nic *pfvf, int qidx);
+void otx2_config_irq_coalescing(struct otx2_nic *pfvf, int cint);
 int otx2_hw_set_mac_addr(struct otx2_nic *pfvf, struct net_device *netdev);
 int otx2_set_mac_address(struct net_device *netdev, void *p);
 int otx2_change_mtu(struct net_device *netdev, int new_mtu);
 int otx2_hw_set_mtu(struct otx2_nic *pfvf, int mtu);
+int otx2_enable_rxvlan(struct otx2_nic *pfvf, bool enable);
+netdev_features_t otx2_fix_features(struct net_device *netdev,
+				    netdev_features_t features);
 void otx2_tx_timeout(struct net_device *netdev);
+netdev_features_t otx2_features_check(struct sk_buff *skb,
+				      struct net_device *dev,
+				      netdev_features_t features);
 
 /* RSS configuration APIs*/
 int otx2_rss_init(struct otx2_nic *pfvf);
 int otx2_set_flowkey_cfg(struct otx2_nic *pfvf);
 void otx2_set_rss_key(struct otx2_nic *pfvf);
 int otx2_set_rss_table(struct otx2_nic *pfvf);
+int otx2_set_rss_table_default(struct otx2_nic *pfvf);
 
 /* Mbox handlers */
 void mbox_handler_MSIX_OFFSET(struct otx2_nic *pfvf,
@@ -335,13 +562,71 @@ void mbox_handler_CGX_STATS(struct otx2_nic *pfvf,
 
 /* Device stats APIs */
 void otx2_update_lmac_stats(struct otx2_nic *pfvf);
-int otx2_update_rq_stats(struct otx2_nic *pfvf, int qidx);
-int otx2_update_sq_stats(struct otx2_nic *pfvf, int qidx);
+int otx2_alloc_queue_stats(struct otx2_nic *pfvf);
+void otx2_get_rq_stats(struct otx2_nic *pfvf, int qidx,
+		       struct otx2_rq_stats *stats);
+void otx2_get_sq_stats(struct otx2_nic *pfvf, int qidx,
+		       struct otx2_sq_stats *stats);
 void otx2_set_ethtool_ops(struct net_device *netdev);
 void otx2vf_set_ethtool_ops(struct net_device *netdev);
+#ifdef CONFIG_DCB
+void otx2_set_dcbnl_ops(struct net_device *netdev);
+#else
+static inline void otx2_set_dcbnl_ops(struct net_device *netdev) {}
+#endif
 
 int otx2_open(struct net_device *netdev);
 int otx2_stop(struct net_device *netdev);
 int otx2_set_real_num_queues(struct net_device *netdev,
 			     int tx_queues, int rx_queues);
+int otx2_set_queue_count(struct otx2_nic *pfvf, int rx_queues, int tx_queues);
+int otx2_set_queue_size(struct otx2_nic *pfvf, u32 cqe_cnt, u32 sqe_cnt);
+
+static inline u64 otx2_mac_to_u64(const u8 *mac)
+{
+	u64 val = 0;
+	int i;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		val = (val << 8) | mac[i];
+	return val;
+}
+
+/* ntuple flow APIs */
+int otx2_get_kex_cfg(struct otx2_nic *pfvf);
+void otx2_mcam_set_chan(struct otx2_nic *pfvf, struct mcam_entry *entry);
+int otx2_mcam_set_ltype(struct otx2_nic *pfvf, struct mcam_entry *entry,
+			int lid, int ltype);
+int otx2_mcam_set_field(struct otx2_nic *pfvf, struct mcam_entry *entry,
+			int kf, u64 val, u64 mask);
+void otx2_mcam_flow_init(struct otx2_nic *pfvf);
+void otx2_mcam_flow_del(struct otx2_nic *pfvf);
+int otx2_restore_flows(struct otx2_nic *pfvf);
+int otx2_update_rss_flows(struct otx2_nic *pfvf);
+int otx2_get_flow(struct otx2_nic *pfvf, struct ethtool_rxnfc *nfc,
+		  u32 location);
+int otx2_get_all_flows(struct otx2_nic *pfvf, struct ethtool_rxnfc *nfc,
+		       u32 *rule_locs);
+int otx2_add_flow(struct otx2_nic *pfvf, struct ethtool_rx_flow_spec *fsp);
+int otx2_remove_flow(struct otx2_nic *pfvf, u32 location);
+
+/* tc flower APIs */
+int otx2_setup_tc(struct net_device *netdev, enum tc_setup_type type,
+		  void *type_data);
+void otx2_tc_init(struct otx2_nic *nic);
+int otx2_tc_restore_flows(struct otx2_nic *nic);
+
+/* PTP APIs */
+int otx2_ptp_init(struct otx2_nic *pfvf);
+void otx2_ptp_destroy(struct otx2_nic *pfvf);
+int otx2_ptp_clock_index(struct otx2_nic *pfvf);
+u64 otx2_ptp_tstamp2time(struct otx2_nic *pfvf, u64 tstamp);
+int otx2_config_hw_rx_tstamp(struct otx2_nic *pfvf, bool enable);
+int otx2_config_hw_tx_tstamp(struct otx2_nic *pfvf, bool enable);
+int otx2_ioctl(struct net_device *netdev, struct ifreq *req, int cmd);
+
+/* XDP APIs */
+int otx2_xdp(struct net_device *netdev, struct netdev_bpf *xdp);
+int otx2_xdp_xmit(struct net_device *netdev, struct xdp_buff *xdp);
+void otx2_xdp_flush(struct net_device *netdev);
 #endif /* OTX2_COMMON_H */
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Marvell OcteonTx2 RVU Ethernet driver
+ *
+ * Copyright (C) 2018 Marvell International Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/netdevice.h>
+#include <net/dcbnl.h>
+
+#include "otx2_common.h"
+
+/* Rx traffic is received on the LMAC's base channel alone, whose
+ * backpressure CGX sends out as PFC for priority 0. Other priorities
+ * would never be paused.
+ */
+#define OTX2_PFC_PRIO_CNT	1
+#define OTX2_PFC_PRIO_MASK	(BIT(OTX2_PFC_PRIO_CNT) - 1)
+
+/* PFC is configured in CGX, hence is common to all PFs/VFs using the
+ * LMAC and only the PF mapped to it can change it. With 'set' clear,
+ * current config is read into 'pfc_en'.
+ */
+static int otx2_cgx_pfc(struct otx2_nic *pfvf, bool set, u8 *pfc_en)
+{
+	struct cgx_pfc_cfg *req, *rsp;
+	int err = -ENOMEM;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_CGX_CFG_PFC(&pfvf->mbox);
+	if (!req)
+		goto unlock;
+
+	req->set = set;
+	req->pfc_en = *pfc_en;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		goto unlock;
+
+	rsp = (struct cgx_pfc_cfg *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp)) {
+		err = PTR_ERR(rsp);
+		goto unlock;
+	}
+
+	err = rsp->hdr.rc;
+	if (!err && !set)
+		*pfc_en = rsp->pfc_en;
+	if (!err && set && netif_running(pfvf->netdev))
+		err = otx2_nix_sync_bp(pfvf);
+unlock:
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+
+static int otx2_dcbnl_ieee_getpfc(struct net_device *dev,
+				  struct ieee_pfc *pfc)
+{
+	struct otx2_nic *pfvf = netdev_priv(dev);
+	u8 pfc_en = 0;
+	int err;
+
+	err = otx2_cgx_pfc(pfvf, false, &pfc_en);
+	if (err)
+		return err;
+
+	pfc->pfc_cap = OTX2_PFC_PRIO_CNT;
+	pfc->pfc_en = pfc_en & OTX2_PFC_PRIO_MASK;
+	return 0;
+}
+
+/* PFC frames are sent for the enabled priorities when RQs' CQs or
+ * auras backpressure the receive channel. This replaces 802.3x PAUSE.
+ */
+static int otx2_dcbnl_ieee_setpfc(struct net_device *dev,
+				  struct ieee_pfc *pfc)
+{
+	struct otx2_nic *pfvf = netdev_priv(dev);
+
+	if (pfc->pfc_en & ~OTX2_PFC_PRIO_MASK)
+		return -EOPNOTSUPP;
+
+	return otx2_cgx_pfc(pfvf, true, &pfc->pfc_en);
+}
+
+static u8 otx2_dcbnl_getdcbx(struct net_device *dev)
+{
+	return DCB_CAP_DCBX_HOST | DCB_CAP_DCBX_VER_IEEE;
+}
+
+/* Only host managed, IEEE mode is supported */
+static u8 otx2_dcbnl_setdcbx(struct net_device *dev, u8 mode)
+{
+	if ((mode & DCB_CAP_DCBX_LLD_MANAGED) ||
+	    (mode & DCB_CAP_DCBX_VER_CEE) ||
+	    !(mode & DCB_CAP_DCBX_VER_IEEE) ||
+	    !(mode & DCB_CAP_DCBX_HOST))
+		return 1;
+
+	return 0;
+}
+
+static const struct dcbnl_rtnl_ops otx2_dcbnl_ops = {
+	.ieee_getpfc	= otx2_dcbnl_ieee_getpfc,
+	.ieee_setpfc	= otx2_dcbnl_ieee_setpfc,
+	.getdcbx	= otx2_dcbnl_getdcbx,
+	.setdcbx	= otx2_dcbnl_setdcbx,
+};
+
+void otx2_set_dcbnl_ops(struct net_device *netdev)
+{
+	netdev->dcbnl_ops = &otx2_dcbnl_ops;
+}
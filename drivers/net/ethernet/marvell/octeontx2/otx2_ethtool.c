@@ -39,6 +39,9 @@ static const struct otx2_stat otx2_dev_stats[] = {
 	OTX2_DEV_STAT(rx_bcast_frames),
 	OTX2_DEV_STAT(rx_mcast_frames),
 	OTX2_DEV_STAT(rx_drops),
+	OTX2_DEV_STAT(rx_queue_drops),
+	OTX2_DEV_STAT(rx_page_recycle_hits),
+	OTX2_DEV_STAT(rx_page_recycle_misses),
 
 	OTX2_DEV_STAT(tx_bytes),
 	OTX2_DEV_STAT(tx_frames),
@@ -46,15 +49,53 @@ static const struct otx2_stat otx2_dev_stats[] = {
 	OTX2_DEV_STAT(tx_bcast_frames),
 	OTX2_DEV_STAT(tx_mcast_frames),
 	OTX2_DEV_STAT(tx_drops),
+	OTX2_DEV_STAT(tx_linearized),
 };
 
-static const struct otx2_stat otx2_queue_stats[] = {
-	{ "bytes", 0 },
-	{ "frames", 1 },
+#define OTX2_RQ_STAT(_name, stat) { \
+	.name = _name, \
+	.index = offsetof(struct otx2_rq_stats, stat) / sizeof(u64), \
+}
+
+#define OTX2_SQ_STAT(_name, stat) { \
+	.name = _name, \
+	.index = offsetof(struct otx2_sq_stats, stat) / sizeof(u64), \
+}
+
+static const struct otx2_stat otx2_rq_stats[] = {
+	OTX2_RQ_STAT("bytes", bytes),
+	OTX2_RQ_STAT("frames", pkts),
+	OTX2_RQ_STAT("mcast_frames", mcast),
+	OTX2_RQ_STAT("drops", drops),
+	OTX2_RQ_STAT("alloc_fail", alloc_fail),
+};
+
+static const struct otx2_stat otx2_sq_stats[] = {
+	OTX2_SQ_STAT("bytes", bytes),
+	OTX2_SQ_STAT("frames", pkts),
+	OTX2_SQ_STAT("drops", drops),
+	OTX2_SQ_STAT("linearized", linearized),
+	OTX2_SQ_STAT("ring_full", ring_full),
+};
+
+enum otx2_priv_flags {
+	OTX2_PRIV_FLAG_RX_RED,
+	OTX2_PRIV_FLAGS_LAST,
+};
+
+static const char otx2_priv_flags_strings[][ETH_GSTRING_LEN] = {
+	[OTX2_PRIV_FLAG_RX_RED] = "rx-red",
 };
 
 static const unsigned int otx2_n_dev_stats = ARRAY_SIZE(otx2_dev_stats);
-static const unsigned int otx2_n_queue_stats = ARRAY_SIZE(otx2_queue_stats);
+static const unsigned int otx2_n_rq_stats = ARRAY_SIZE(otx2_rq_stats);
+static const unsigned int otx2_n_sq_stats = ARRAY_SIZE(otx2_sq_stats);
+
+static unsigned int otx2_n_queue_stats(struct otx2_nic *pfvf)
+{
+	return otx2_n_rq_stats * pfvf->hw.rx_queues +
+	       otx2_n_sq_stats * pfvf->hw.tx_queues;
+}
 
 static void otx2_get_drvinfo(struct net_device *netdev,
 			     struct ethtool_drvinfo *info)
@@ -72,16 +113,16 @@ static void otx2_get_qset_strings(struct otx2_nic *pfvf, u8 **data, int qset)
 	int qidx, stats;
 
 	for (qidx = 0; qidx < pfvf->hw.rx_queues; qidx++) {
-		for (stats = 0; stats < otx2_n_queue_stats; stats++) {
+		for (stats = 0; stats < otx2_n_rq_stats; stats++) {
 			sprintf(*data, "rxq%d: %s", qidx + start_qidx,
-				otx2_queue_stats[stats].name);
+				otx2_rq_stats[stats].name);
 			*data += ETH_GSTRING_LEN;
 		}
 	}
 	for (qidx = 0; qidx < pfvf->hw.tx_queues; qidx++) {
-		for (stats = 0; stats < otx2_n_queue_stats; stats++) {
+		for (stats = 0; stats < otx2_n_sq_stats; stats++) {
 			sprintf(*data, "txq%d: %s", qidx + start_qidx,
-				otx2_queue_stats[stats].name);
+				otx2_sq_stats[stats].name);
 			*data += ETH_GSTRING_LEN;
 		}
 	}
@@ -92,6 +133,12 @@ static void otx2_get_strings(struct net_device *netdev, u32 sset, u8 *data)
 	struct otx2_nic *pfvf = netdev_priv(netdev);
 	int stats;
 
+	if (sset == ETH_SS_PRIV_FLAGS) {
+		memcpy(data, otx2_priv_flags_strings,
+		       sizeof(otx2_priv_flags_strings));
+		return;
+	}
+
 	if (sset != ETH_SS_STATS)
 		return;
 
@@ -115,30 +162,24 @@ static void otx2_get_strings(struct net_device *netdev, u32 sset, u8 *data)
 static void otx2_get_qset_stats(struct otx2_nic *pfvf,
 				struct ethtool_stats *stats, u64 **data)
 {
+	struct otx2_rq_stats rq_stats;
+	struct otx2_sq_stats sq_stats;
 	int stat, qidx;
 
 	if (!pfvf)
 		return;
 	for (qidx = 0; qidx < pfvf->hw.rx_queues; qidx++) {
-		if (!otx2_update_rq_stats(pfvf, qidx)) {
-			for (stat = 0; stat < otx2_n_queue_stats; stat++)
-				*((*data)++) = 0;
-			continue;
-		}
-		for (stat = 0; stat < otx2_n_queue_stats; stat++)
-			*((*data)++) = ((u64 *)&pfvf->qset.rq[qidx].stats)
-				[otx2_queue_stats[stat].index];
+		otx2_get_rq_stats(pfvf, qidx, &rq_stats);
+		for (stat = 0; stat < otx2_n_rq_stats; stat++)
+			*((*data)++) = ((u64 *)&rq_stats)
+				[otx2_rq_stats[stat].index];
 	}
 
 	for (qidx = 0; qidx < pfvf->hw.tx_queues; qidx++) {
-		if (!otx2_update_sq_stats(pfvf, qidx)) {
-			for (stat = 0; stat < otx2_n_queue_stats; stat++)
-				*((*data)++) = 0;
-			continue;
-		}
-		for (stat = 0; stat < otx2_n_queue_stats; stat++)
-			*((*data)++) = ((u64 *)&pfvf->qset.sq[qidx].stats)
-				[otx2_queue_stats[stat].index];
+		otx2_get_sq_stats(pfvf, qidx, &sq_stats);
+		for (stat = 0; stat < otx2_n_sq_stats; stat++)
+			*((*data)++) = ((u64 *)&sq_stats)
+				[otx2_sq_stats[stat].index];
 	}
 }
 
@@ -166,11 +207,13 @@ static int otx2_get_sset_count(struct net_device *netdev, int sset)
 	struct otx2_nic *pfvf = netdev_priv(netdev);
 	int qstats_count;
 
+	if (sset == ETH_SS_PRIV_FLAGS)
+		return OTX2_PRIV_FLAGS_LAST;
+
 	if (sset != ETH_SS_STATS)
 		return -EINVAL;
 
-	qstats_count = otx2_n_queue_stats *
-		       (pfvf->hw.rx_queues + pfvf->hw.tx_queues);
+	qstats_count = otx2_n_queue_stats(pfvf);
 	return otx2_n_dev_stats + qstats_count +
 		CGX_RX_STATS_COUNT + CGX_TX_STATS_COUNT;
 }
@@ -203,20 +246,28 @@ static int otx2_set_channels(struct net_device *dev,
 		return -EINVAL;
 	if (channel->tx_count > pfvf->hw.max_queues)
 		return -EINVAL;
+	/* Queue to traffic class mapping is owned by mqprio */
+	if (netdev_get_num_tc(dev) &&
+	    channel->tx_count != pfvf->hw.tx_queues) {
+		netdev_err(dev,
+			   "Remove mqprio qdisc to change Tx queue count\n");
+		return -EINVAL;
+	}
 
-	if (if_up)
-		otx2_stop(dev);
-
-	pfvf->hw.rx_queues = channel->rx_count;
-	pfvf->hw.tx_queues = channel->tx_count;
-	err = otx2_set_real_num_queues(dev, pfvf->hw.tx_queues,
-				       pfvf->hw.rx_queues);
-	pfvf->qset.cq_cnt = pfvf->hw.tx_queues +  pfvf->hw.rx_queues;
-	if (err)
-		return err;
-
-	if (if_up)
-		otx2_open(dev);
+	if (if_up) {
+		/* Only the queues being added or removed are touched */
+		err = otx2_set_queue_count(pfvf, channel->rx_count,
+					   channel->tx_count);
+		if (err)
+			return err;
+	} else {
+		err = otx2_set_real_num_queues(dev, channel->tx_count,
+					       channel->rx_count);
+		if (err)
+			return err;
+		pfvf->hw.rx_queues = channel->rx_count;
+		pfvf->hw.tx_queues = channel->tx_count;
+	}
 
 	netdev_info(dev, "Setting num Tx rings to %d, Rx rings to %d success\n",
 		    pfvf->hw.tx_queues, pfvf->hw.rx_queues);
@@ -248,9 +299,6 @@ static int otx2_set_ringparam(struct net_device *netdev,
 	if (ring->rx_mini_pending || ring->rx_jumbo_pending)
 		return -EINVAL;
 
-	if (if_up)
-		otx2_stop(netdev);
-
 	rx_count = clamp_t(u32, ring->rx_pending,
 			   Q_COUNT(Q_SIZE_MIN), Q_COUNT(Q_SIZE_MAX));
 	tx_count = clamp_t(u32, ring->tx_pending,
@@ -264,11 +312,12 @@ static int otx2_set_ringparam(struct net_device *netdev,
 	rx_size = Q_SIZE(rx_count, 3);
 
 	/* Assigned to the nearest possible exponent. */
+	if (if_up)
+		return otx2_set_queue_size(pfvf, Q_COUNT(rx_size),
+					   Q_COUNT(tx_size));
+
 	qs->sqe_cnt = Q_COUNT(tx_size);
 	qs->cqe_cnt = Q_COUNT(rx_size);
-
-	if (if_up)
-		otx2_open(netdev);
 	return 0;
 }
 
@@ -281,6 +330,7 @@ static int otx2_get_coalesce(struct net_device *netdev,
 	cmd->rx_max_coalesced_frames = pfvf->cq_ecount_wait + 1;
 	cmd->tx_coalesce_usecs = pfvf->cq_time_wait / 10;
 	cmd->tx_max_coalesced_frames = pfvf->cq_ecount_wait + 1;
+	cmd->use_adaptive_rx_coalesce = pfvf->adaptive_coalesce;
 
 	return 0;
 }
@@ -290,10 +340,11 @@ static int otx2_set_coalesce(struct net_device *netdev,
 {
 	struct otx2_nic *pfvf = netdev_priv(netdev);
 	bool if_up = netif_running(netdev);
+	int cint;
 
-	if (ec->use_adaptive_rx_coalesce || ec->use_adaptive_tx_coalesce ||
-	    ec->rx_coalesce_usecs_irq || ec->rx_max_coalesced_frames_irq ||
-	    ec->tx_coalesce_usecs_irq || ec->tx_max_coalesced_frames_irq ||
+	if (ec->use_adaptive_tx_coalesce || ec->rx_coalesce_usecs_irq ||
+	    ec->rx_max_coalesced_frames_irq || ec->tx_coalesce_usecs_irq ||
+	    ec->tx_max_coalesced_frames_irq ||
 	    ec->stats_block_coalesce_usecs || ec->pkt_rate_low ||
 	    ec->rx_coalesce_usecs_low || ec->rx_max_coalesced_frames_low ||
 	    ec->tx_coalesce_usecs_low || ec->tx_max_coalesced_frames_low ||
@@ -305,8 +356,10 @@ static int otx2_set_coalesce(struct net_device *netdev,
 	if (!ec->rx_max_coalesced_frames || !ec->tx_max_coalesced_frames)
 		return 0;
 
-	if (if_up)
-		otx2_stop(netdev);
+	/* With adaptive mode, net_dim picks the moderation profile and
+	 * below static values are applied only until its first decision.
+	 */
+	pfvf->adaptive_coalesce = !!ec->use_adaptive_rx_coalesce;
 
 	/* RQ and SQ are tied to CQ setting, so any of the below
 	 * values reflects on CQ.
@@ -349,8 +402,18 @@ static int otx2_set_coalesce(struct net_device *netdev,
 			 ec->rx_max_coalesced_frames - 1;
 	}
 
-	if (if_up)
-		otx2_open(netdev);
+	/* Coalescing config takes effect right away, no need
+	 * to restart the interface.
+	 */
+	if (!if_up)
+		return 0;
+
+	for (cint = 0; cint < pfvf->hw.cint_cnt; cint++) {
+		/* Don't let a pending net_dim decision override */
+		if (!pfvf->adaptive_coalesce)
+			cancel_work_sync(&pfvf->qset.napi[cint].dim.work);
+		otx2_config_irq_coalescing(pfvf, cint);
+	}
 
 	return 0;
 }
@@ -451,8 +514,10 @@ static int otx2_set_rss_hash_opts(struct otx2_nic *pfvf,
 	}
 
 	rss->flowkey_cfg = rss_cfg;
+	mutex_lock(&pfvf->mbox.lock);
 	otx2_set_flowkey_cfg(pfvf);
-	return 0;
+	mutex_unlock(&pfvf->mbox.lock);
+	return otx2_update_rss_flows(pfvf);
 }
 
 static int otx2_get_rxnfc(struct net_device *dev,
@@ -468,6 +533,17 @@ static int otx2_get_rxnfc(struct net_device *dev,
 		break;
 	case ETHTOOL_GRXFH:
 		return otx2_get_rss_hash_opts(pfvf, nfc);
+	case ETHTOOL_GRXCLSRLCNT:
+		nfc->rule_cnt = pfvf->flow_cfg.nr_flows;
+		nfc->data = OTX2_MAX_NTUPLE_FLOWS;
+		ret = 0;
+		break;
+	case ETHTOOL_GRXCLSRULE:
+		ret = otx2_get_flow(pfvf, nfc, nfc->fs.location);
+		break;
+	case ETHTOOL_GRXCLSRLALL:
+		ret = otx2_get_all_flows(pfvf, nfc, rules);
+		break;
 	default:
 		break;
 	}
@@ -483,6 +559,15 @@ static int otx2_set_rxnfc(struct net_device *dev, struct ethtool_rxnfc *nfc)
 	case ETHTOOL_SRXFH:
 		ret = otx2_set_rss_hash_opts(pfvf, nfc);
 		break;
+	case ETHTOOL_SRXCLSRLINS:
+		/* Only the default RSS context is supported */
+		if ((nfc->fs.flow_type & FLOW_RSS) && nfc->rss_context)
+			return -EINVAL;
+		ret = otx2_add_flow(pfvf, &nfc->fs);
+		break;
+	case ETHTOOL_SRXCLSRLDEL:
+		ret = otx2_remove_flow(pfvf, nfc->fs.location);
+		break;
 	default:
 		break;
 	}
@@ -553,7 +638,161 @@ static int otx2_set_rxfh(struct net_device *dev, const u32 *indir,
 		otx2_set_rss_key(pfvf);
 	}
 
+	mutex_lock(&pfvf->mbox.lock);
 	otx2_set_rss_table(pfvf);
+	mutex_unlock(&pfvf->mbox.lock);
+	return 0;
+}
+
+static int otx2_get_ts_info(struct net_device *netdev,
+			    struct ethtool_ts_info *info)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+
+	if (!pfvf->ptp)
+		return ethtool_op_get_ts_info(netdev, info);
+
+	info->so_timestamping = SOF_TIMESTAMPING_TX_SOFTWARE |
+				SOF_TIMESTAMPING_RX_SOFTWARE |
+				SOF_TIMESTAMPING_SOFTWARE |
+				SOF_TIMESTAMPING_TX_HARDWARE |
+				SOF_TIMESTAMPING_RX_HARDWARE |
+				SOF_TIMESTAMPING_RAW_HARDWARE;
+
+	info->phc_index = otx2_ptp_clock_index(pfvf);
+
+	info->tx_types = BIT(HWTSTAMP_TX_OFF) | BIT(HWTSTAMP_TX_ON);
+
+	info->rx_filters = BIT(HWTSTAMP_FILTER_NONE) |
+			   BIT(HWTSTAMP_FILTER_ALL);
+
+	return 0;
+}
+
+static int otx2_get_tunable(struct net_device *netdev,
+			    const struct ethtool_tunable *tuna, void *data)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		*(u32 *)data = pfvf->rx_copybreak;
+		return 0;
+	case ETHTOOL_TX_COPYBREAK:
+		*(u32 *)data = pfvf->tx_copybreak;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/* Packets up to rx_copybreak size are received into CQE instead of
+ * buffers, this changes CQE size of the NIX LF, hence interface is
+ * restarted. It's not in effect while an XDP program is attached.
+ */
+static int otx2_set_tunable(struct net_device *netdev,
+			    const struct ethtool_tunable *tuna,
+			    const void *data)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	bool if_up = netif_running(netdev);
+	u32 copybreak;
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		copybreak = *(u32 *)data;
+		if (copybreak > OTX2_MAX_RX_IMM_SIZE)
+			return -EINVAL;
+
+		copybreak = ALIGN(copybreak, 16);
+		if (copybreak == pfvf->rx_copybreak)
+			return 0;
+
+		if (if_up)
+			otx2_stop(netdev);
+		pfvf->rx_copybreak = copybreak;
+		if (if_up)
+			return otx2_open(netdev);
+		return 0;
+	case ETHTOOL_TX_COPYBREAK:
+		/* Frames up to this size are copied into the SQE */
+		copybreak = *(u32 *)data;
+		if (copybreak > OTX2_MAX_TX_IMM_SIZE)
+			return -EINVAL;
+		WRITE_ONCE(pfvf->tx_copybreak, copybreak);
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static void otx2_get_pauseparam(struct net_device *netdev,
+				struct ethtool_pauseparam *pause)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	struct cgx_pause_frm_cfg *req, *rsp;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_CGX_CFG_PAUSE_FRM(&pfvf->mbox);
+	if (!req)
+		goto unlock;
+
+	if (otx2_sync_mbox_msg(&pfvf->mbox))
+		goto unlock;
+
+	rsp = (struct cgx_pause_frm_cfg *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp) || rsp->hdr.rc)
+		goto unlock;
+
+	pause->rx_pause = rsp->rx_pause;
+	pause->tx_pause = rsp->tx_pause;
+unlock:
+	mutex_unlock(&pfvf->mbox.lock);
+}
+
+/* PAUSE frames are sent when RQs' CQs or auras backpressure the
+ * receive channel. Enabling PAUSE disables PFC and vice versa.
+ */
+static int otx2_set_pauseparam(struct net_device *netdev,
+			       struct ethtool_pauseparam *pause)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+
+	if (pause->autoneg)
+		return -EOPNOTSUPP;
+
+	return otx2_config_pause_frm(pfvf, pause->tx_pause, pause->rx_pause);
+}
+
+static u32 otx2_get_priv_flags(struct net_device *netdev)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	u32 flags = 0;
+
+	if (pfvf->rx_red_ena)
+		flags |= BIT(OTX2_PRIV_FLAG_RX_RED);
+
+	return flags;
+}
+
+/* RED levels are part of RQ context, so interface is restarted
+ * for RQs to be initialized again with or without them.
+ */
+static int otx2_set_priv_flags(struct net_device *netdev, u32 flags)
+{
+	bool rx_red = !!(flags & BIT(OTX2_PRIV_FLAG_RX_RED));
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	bool if_up = netif_running(netdev);
+
+	if (rx_red == pfvf->rx_red_ena)
+		return 0;
+
+	if (if_up)
+		netdev->netdev_ops->ndo_stop(netdev);
+	pfvf->rx_red_ena = rx_red;
+	if (if_up)
+		return netdev->netdev_ops->ndo_open(netdev);
 	return 0;
 }
 
@@ -574,6 +813,13 @@ static const struct ethtool_ops otx2_ethtool_ops = {
 	.get_rxfh_indir_size	= otx2_get_rxfh_indir_size,
 	.get_rxfh		= otx2_get_rxfh,
 	.set_rxfh		= otx2_set_rxfh,
+	.get_ts_info		= otx2_get_ts_info,
+	.get_tunable		= otx2_get_tunable,
+	.set_tunable		= otx2_set_tunable,
+	.get_priv_flags		= otx2_get_priv_flags,
+	.set_priv_flags		= otx2_set_priv_flags,
+	.get_pauseparam		= otx2_get_pauseparam,
+	.set_pauseparam		= otx2_set_pauseparam,
 };
 
 void otx2_set_ethtool_ops(struct net_device *netdev)
@@ -597,6 +843,12 @@ static void otx2vf_get_strings(struct net_device *netdev, u32 sset, u8 *data)
 	struct otx2_nic *vf = netdev_priv(netdev);
 	int stats;
 
+	if (sset == ETH_SS_PRIV_FLAGS) {
+		memcpy(data, otx2_priv_flags_strings,
+		       sizeof(otx2_priv_flags_strings));
+		return;
+	}
+
 	if (sset != ETH_SS_STATS)
 		return;
 
@@ -628,11 +880,13 @@ static int otx2vf_get_sset_count(struct net_device *netdev, int sset)
 {
 	struct otx2_nic *vf = netdev_priv(netdev);
 
+	if (sset == ETH_SS_PRIV_FLAGS)
+		return OTX2_PRIV_FLAGS_LAST;
+
 	if (sset != ETH_SS_STATS)
 		return -EINVAL;
 
-	return otx2_n_dev_stats +
-	       otx2_n_queue_stats * (vf->hw.rx_queues + vf->hw.tx_queues);
+	return otx2_n_dev_stats + otx2_n_queue_stats(vf);
 }
 
 static const struct ethtool_ops otx2vf_ethtool_ops = {
@@ -652,6 +906,8 @@ static const struct ethtool_ops otx2vf_ethtool_ops = {
 	.set_ringparam		= otx2_set_ringparam,
 	.get_coalesce		= otx2_get_coalesce,
 	.set_coalesce		= otx2_set_coalesce,
+	.get_priv_flags		= otx2_get_priv_flags,
+	.set_priv_flags		= otx2_set_priv_flags,
 };
 
 void otx2vf_set_ethtool_ops(struct net_device *netdev)
@@ -0,0 +1,728 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Marvell OcteonTx2 RVU Ethernet driver
+ *
+ * Copyright (C) 2018 Marvell International Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/ethtool.h>
+#include <linux/etherdevice.h>
+
+#include "otx2_common.h"
+
+/* Location of a header field, relative to start of the layer */
+struct otx2_hdr_field {
+	u8	lid;
+	u8	ltype;
+	u8	offset;
+	u8	len;
+};
+
+static const struct otx2_hdr_field otx2_hdr_fields[OTX2_KF_MAX] = {
+	[OTX2_KF_DMAC]		= { NPC_LID_LA, NPC_LT_LA_ETHER, 0, ETH_ALEN },
+	[OTX2_KF_SMAC]		= { NPC_LID_LA, NPC_LT_LA_ETHER, 6, ETH_ALEN },
+	[OTX2_KF_ETYPE]		= { NPC_LID_LA, NPC_LT_LA_ETHER, 12, 2 },
+	[OTX2_KF_VLAN_TCI]	= { NPC_LID_LB, NPC_LT_LB_CTAG, 2, 2 },
+	[OTX2_KF_SIP4]		= { NPC_LID_LC, NPC_LT_LC_IP, 12, 4 },
+	[OTX2_KF_DIP4]		= { NPC_LID_LC, NPC_LT_LC_IP, 16, 4 },
+	[OTX2_KF_TOS]		= { NPC_LID_LC, NPC_LT_LC_IP, 1, 1 },
+	[OTX2_KF_TCP_SPORT]	= { NPC_LID_LD, NPC_LT_LD_TCP, 0, 2 },
+	[OTX2_KF_TCP_DPORT]	= { NPC_LID_LD, NPC_LT_LD_TCP, 2, 2 },
+	[OTX2_KF_UDP_SPORT]	= { NPC_LID_LD, NPC_LT_LD_UDP, 0, 2 },
+	[OTX2_KF_UDP_DPORT]	= { NPC_LID_LD, NPC_LT_LD_UDP, 2, 2 },
+};
+
+/* NPC_PARSE_KEX_S nibbles, enabled ones are packed into the key
+ * in this order, ahead of the extracted layer data.
+ */
+#define NPC_PARSE_NIBBLE_CHAN		GENMASK_ULL(2, 0)
+#define NPC_PARSE_NIBBLE_LTYPE(lid)	(9 + (3 * (lid)))
+#define NPC_PARSE_NIBBLE_ENA_MASK	GENMASK_ULL(30, 0)
+
+/* NPC_AF_INTF()_LID()_LT()_LD()_CFG */
+#define NPC_LD_KEY_OFFSET(cfg)		((cfg) & 0x3F)
+#define NPC_LD_ENA(cfg)			((cfg) & BIT_ULL(7))
+#define NPC_LD_HDR_OFFSET(cfg)		(((cfg) >> 8) & 0xFF)
+#define NPC_LD_BYTESM1(cfg)		(((cfg) >> 16) & 0xF)
+
+/* Find where a header field lands in the search key. Extracted bytes
+ * are laid out in network order i.e first header byte in most
+ * significant bits, as with DMAC in the default unicast entry.
+ */
+static int otx2_kex_field_bit(struct npc_get_kex_cfg_rsp *kex,
+			      const struct otx2_hdr_field *field)
+{
+	int ld, start, len;
+	u64 cfg;
+
+	for (ld = 0; ld < NPC_MAX_LD; ld++) {
+		cfg = kex->intf_lid_lt_ld[NIX_INTF_RX][field->lid]
+					 [field->ltype][ld];
+		if (!NPC_LD_ENA(cfg))
+			continue;
+
+		start = NPC_LD_HDR_OFFSET(cfg);
+		len = NPC_LD_BYTESM1(cfg) + 1;
+		if (field->offset < start ||
+		    field->offset + field->len > start + len)
+			continue;
+
+		return (NPC_LD_KEY_OFFSET(cfg) * 8) +
+		       ((start + len - field->offset - field->len) * 8);
+	}
+	return -1;
+}
+
+static int otx2_kex_nibble_bit(u64 nibble_ena, int nibble)
+{
+	if (!(nibble_ena & BIT_ULL(nibble)))
+		return -1;
+	return hweight64(nibble_ena & (BIT_ULL(nibble) - 1)) * 4;
+}
+
+/* Fetch MCAM search key layout, once */
+int otx2_get_kex_cfg(struct otx2_nic *pfvf)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct npc_get_kex_cfg_rsp *kex;
+	struct msg_req *req;
+	u64 nibble_ena;
+	int lid, kf, err;
+
+	if (flow_cfg->kex_valid)
+		return 0;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_GET_KEX_CFG(&pfvf->mbox);
+	if (!req) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		goto out;
+
+	kex = (struct npc_get_kex_cfg_rsp *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(kex)) {
+		err = PTR_ERR(kex);
+		goto out;
+	}
+	err = kex->hdr.rc;
+	if (err)
+		goto out;
+
+	nibble_ena = kex->rx_keyx_cfg & NPC_PARSE_NIBBLE_ENA_MASK;
+
+	/* Rules always match on channel, without it they can't be
+	 * restricted to traffic meant for this PF/VF.
+	 */
+	if ((nibble_ena & NPC_PARSE_NIBBLE_CHAN) != NPC_PARSE_NIBBLE_CHAN) {
+		netdev_err(pfvf->netdev,
+			   "Channel not in MCAM key, ntuple not supported\n");
+		err = -EOPNOTSUPP;
+		goto out;
+	}
+	flow_cfg->chan_bit = otx2_kex_nibble_bit(nibble_ena, 0);
+
+	for (lid = 0; lid < NPC_MAX_LID; lid++)
+		flow_cfg->ltype_bit[lid] =
+			otx2_kex_nibble_bit(nibble_ena,
+					    NPC_PARSE_NIBBLE_LTYPE(lid));
+
+	for (kf = 0; kf < OTX2_KF_MAX; kf++)
+		flow_cfg->field_bit[kf] =
+			otx2_kex_field_bit(kex, &otx2_hdr_fields[kf]);
+
+	flow_cfg->kex_valid = true;
+out:
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+
+static int otx2_alloc_mcam_entries(struct otx2_nic *pfvf)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct npc_mcam_alloc_entry_req *req;
+	struct npc_mcam_alloc_entry_rsp *rsp;
+	struct npc_mcam_free_entry_req *free_req;
+	int err, idx;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_MCAM_ALLOC_ENTRY(&pfvf->mbox);
+	if (!req) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	/* Reserved default entries are at the end of MCAM, so any
+	 * entry allocated here takes priority over them. Contiguous
+	 * entries keep rules ordered by their location.
+	 */
+	req->contig = 1;
+	req->priority = NPC_MCAM_ANY_PRIO;
+	req->count = OTX2_MAX_NTUPLE_FLOWS;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (err)
+		goto out;
+
+	rsp = (struct npc_mcam_alloc_entry_rsp *)
+	       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp)) {
+		err = PTR_ERR(rsp);
+		goto out;
+	}
+	err = rsp->hdr.rc;
+	if (err)
+		goto out;
+
+	if (rsp->count == OTX2_MAX_NTUPLE_FLOWS) {
+		flow_cfg->entry = rsp->entry;
+		flow_cfg->entry_valid = true;
+		goto out;
+	}
+
+	/* AF hands out whatever is available, give it back */
+	netdev_err(pfvf->netdev, "Only %d of %d MCAM entries available\n",
+		   rsp->count, OTX2_MAX_NTUPLE_FLOWS);
+	for (idx = 0; idx < rsp->count; idx++) {
+		free_req = otx2_mbox_alloc_msg_NPC_MCAM_FREE_ENTRY(&pfvf->mbox);
+		if (!free_req)
+			break;
+		free_req->entry = rsp->entry + idx;
+	}
+	otx2_sync_mbox_msg(&pfvf->mbox);
+	err = -ENOSPC;
+out:
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+
+static void otx2_set_key(struct mcam_entry *entry, int bit, int len,
+			 u64 val, u64 mask)
+{
+	int kw = bit / 64, shift = bit % 64;
+	u64 field_mask = GENMASK_ULL(len - 1, 0);
+
+	val &= mask & field_mask;
+	mask &= field_mask;
+
+	entry->kw[kw] |= val << shift;
+	entry->kw_mask[kw] |= mask << shift;
+	if (shift + len > 64) {
+		entry->kw[kw + 1] |= val >> (64 - shift);
+		entry->kw_mask[kw + 1] |= mask >> (64 - shift);
+	}
+}
+
+int otx2_mcam_set_field(struct otx2_nic *pfvf, struct mcam_entry *entry,
+			int kf, u64 val, u64 mask)
+{
+	int bit = pfvf->flow_cfg.field_bit[kf];
+
+	if (!mask)
+		return 0;
+	if (bit < 0)
+		return -EOPNOTSUPP;
+
+	otx2_set_key(entry, bit, otx2_hdr_fields[kf].len * 8, val, mask);
+	return 0;
+}
+
+int otx2_mcam_set_ltype(struct otx2_nic *pfvf, struct mcam_entry *entry,
+			int lid, int ltype)
+{
+	int bit = pfvf->flow_cfg.ltype_bit[lid];
+
+	if (bit < 0)
+		return -EOPNOTSUPP;
+
+	otx2_set_key(entry, bit, 4, ltype, 0xF);
+	return 0;
+}
+
+/* Restrict a rule to packets received on this PF/VF's channel */
+void otx2_mcam_set_chan(struct otx2_nic *pfvf, struct mcam_entry *entry)
+{
+	otx2_set_key(entry, pfvf->flow_cfg.chan_bit, 12,
+		     pfvf->rx_chan_base, 0xFFF);
+}
+
+static int otx2_prepare_ipv4_flow(struct otx2_nic *pfvf,
+				  struct ethtool_rx_flow_spec *fsp,
+				  struct mcam_entry *entry)
+{
+	u32 flow_type = fsp->flow_type & ~(FLOW_EXT | FLOW_MAC_EXT | FLOW_RSS);
+	struct ethtool_tcpip4_spec *l4, *l4_mask;
+	struct ethtool_usrip4_spec *ip, *ip_mask;
+	int sport, dport, ltype, err;
+
+	err = otx2_mcam_set_ltype(pfvf, entry, NPC_LID_LC, NPC_LT_LC_IP);
+	if (err)
+		return err;
+
+	switch (flow_type) {
+	case TCP_V4_FLOW:
+	case UDP_V4_FLOW:
+		l4 = &fsp->h_u.tcp_ip4_spec;
+		l4_mask = &fsp->m_u.tcp_ip4_spec;
+
+		if (flow_type == TCP_V4_FLOW) {
+			ltype = NPC_LT_LD_TCP;
+			sport = OTX2_KF_TCP_SPORT;
+			dport = OTX2_KF_TCP_DPORT;
+		} else {
+			ltype = NPC_LT_LD_UDP;
+			sport = OTX2_KF_UDP_SPORT;
+			dport = OTX2_KF_UDP_DPORT;
+		}
+
+		if (otx2_mcam_set_ltype(pfvf, entry, NPC_LID_LD, ltype) ||
+		    otx2_mcam_set_field(pfvf, entry, OTX2_KF_SIP4,
+				   ntohl(l4->ip4src), ntohl(l4_mask->ip4src)) ||
+		    otx2_mcam_set_field(pfvf, entry, OTX2_KF_DIP4,
+				   ntohl(l4->ip4dst), ntohl(l4_mask->ip4dst)) ||
+		    otx2_mcam_set_field(pfvf, entry, OTX2_KF_TOS,
+				   l4->tos, l4_mask->tos) ||
+		    otx2_mcam_set_field(pfvf, entry, sport,
+				   ntohs(l4->psrc), ntohs(l4_mask->psrc)) ||
+		    otx2_mcam_set_field(pfvf, entry, dport,
+				   ntohs(l4->pdst), ntohs(l4_mask->pdst)))
+			return -EOPNOTSUPP;
+		break;
+	case IP_USER_FLOW:
+		ip = &fsp->h_u.usr_ip4_spec;
+		ip_mask = &fsp->m_u.usr_ip4_spec;
+
+		if (ip_mask->l4_4_bytes || ip_mask->ip_ver)
+			return -EOPNOTSUPP;
+
+		if (ip_mask->proto) {
+			if (ip_mask->proto != 0xFF)
+				return -EOPNOTSUPP;
+			if (ip->proto == IPPROTO_TCP)
+				ltype = NPC_LT_LD_TCP;
+			else if (ip->proto == IPPROTO_UDP)
+				ltype = NPC_LT_LD_UDP;
+			else if (ip->proto == IPPROTO_SCTP)
+				ltype = NPC_LT_LD_SCTP;
+			else if (ip->proto == IPPROTO_ICMP)
+				ltype = NPC_LT_LD_ICMP;
+			else
+				return -EOPNOTSUPP;
+			err = otx2_mcam_set_ltype(pfvf, entry, NPC_LID_LD, ltype);
+			if (err)
+				return err;
+		}
+
+		if (otx2_mcam_set_field(pfvf, entry, OTX2_KF_SIP4,
+				   ntohl(ip->ip4src), ntohl(ip_mask->ip4src)) ||
+		    otx2_mcam_set_field(pfvf, entry, OTX2_KF_DIP4,
+				   ntohl(ip->ip4dst), ntohl(ip_mask->ip4dst)) ||
+		    otx2_mcam_set_field(pfvf, entry, OTX2_KF_TOS,
+				   ip->tos, ip_mask->tos))
+			return -EOPNOTSUPP;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+/* Build MCAM search key and action for a rule */
+static int otx2_prepare_flow(struct otx2_nic *pfvf,
+			     struct ethtool_rx_flow_spec *fsp,
+			     struct mcam_entry *entry)
+{
+	u32 flow_type = fsp->flow_type & ~(FLOW_EXT | FLOW_MAC_EXT | FLOW_RSS);
+	struct ethhdr *eth, *eth_mask;
+	struct nix_rx_action action;
+	bool dmac_set = false;
+	u64 dmac_mask;
+	int err;
+
+	memset(entry, 0, sizeof(*entry));
+
+	otx2_mcam_set_chan(pfvf, entry);
+
+	switch (flow_type) {
+	case ETHER_FLOW:
+		eth = &fsp->h_u.ether_spec;
+		eth_mask = &fsp->m_u.ether_spec;
+
+		if (!is_zero_ether_addr(eth_mask->h_source))
+			return -EOPNOTSUPP;
+
+		dmac_mask = otx2_mac_to_u64(eth_mask->h_dest);
+		err = otx2_mcam_set_field(pfvf, entry, OTX2_KF_DMAC,
+				     otx2_mac_to_u64(eth->h_dest), dmac_mask);
+		if (err)
+			return err;
+		dmac_set = !!dmac_mask;
+
+		err = otx2_mcam_set_field(pfvf, entry, OTX2_KF_ETYPE,
+				     ntohs(eth->h_proto),
+				     ntohs(eth_mask->h_proto));
+		if (err)
+			return err;
+		break;
+	case TCP_V4_FLOW:
+	case UDP_V4_FLOW:
+	case IP_USER_FLOW:
+		err = otx2_prepare_ipv4_flow(pfvf, fsp, entry);
+		if (err)
+			return err;
+		break;
+	case TCP_V6_FLOW:
+	case UDP_V6_FLOW:
+	case SCTP_V6_FLOW:
+	case IPV6_USER_FLOW:
+	case SCTP_V4_FLOW:
+		/* Default MKEX profile extracts neither IPv6 addresses
+		 * nor SCTP ports into the search key.
+		 */
+		netdev_dbg(pfvf->netdev,
+			   "Flow type 0x%x not supported by MCAM key\n",
+			   flow_type);
+		return -EOPNOTSUPP;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	if (fsp->flow_type & FLOW_EXT) {
+		if (fsp->m_ext.vlan_etype || fsp->m_ext.data[0] ||
+		    fsp->m_ext.data[1])
+			return -EOPNOTSUPP;
+
+		if (fsp->m_ext.vlan_tci &&
+		    (otx2_mcam_set_ltype(pfvf, entry, NPC_LID_LB, NPC_LT_LB_CTAG) ||
+		     otx2_mcam_set_field(pfvf, entry, OTX2_KF_VLAN_TCI,
+				    ntohs(fsp->h_ext.vlan_tci),
+				    ntohs(fsp->m_ext.vlan_tci))))
+			return -EOPNOTSUPP;
+	}
+
+	if (fsp->flow_type & FLOW_MAC_EXT) {
+		dmac_mask = otx2_mac_to_u64(fsp->m_ext.h_dest);
+		err = otx2_mcam_set_field(pfvf, entry, OTX2_KF_DMAC,
+				     otx2_mac_to_u64(fsp->h_ext.h_dest),
+				     dmac_mask);
+		if (err)
+			return err;
+		dmac_set |= !!dmac_mask;
+	}
+
+	/* VFs share channel with their PF, so restrict a VF's rule
+	 * to packets destined to it.
+	 */
+	if ((pfvf->pcifunc & RVU_PFVF_FUNC_MASK) && !dmac_set) {
+		err = otx2_mcam_set_field(pfvf, entry, OTX2_KF_DMAC,
+				     otx2_mac_to_u64(pfvf->netdev->dev_addr),
+				     GENMASK_ULL(47, 0));
+		if (err)
+			return err;
+	}
+
+	*(u64 *)&action = 0x00;
+	action.pf_func = pfvf->pcifunc;
+	if (fsp->ring_cookie == RX_CLS_FLOW_DISC) {
+		action.op = NIX_RX_ACTIONOP_DROP;
+	} else if (fsp->flow_type & FLOW_RSS) {
+		action.op = NIX_RX_ACTIONOP_RSS;
+		action.index = DEFAULT_RSS_CONTEXT_GROUP;
+		action.flow_key_alg = pfvf->hw.rss_info.flowkey_alg_idx;
+	} else {
+		action.op = NIX_RX_ACTIONOP_UCAST;
+		action.index = ethtool_get_flow_spec_ring(fsp->ring_cookie);
+	}
+	entry->action = *(u64 *)&action;
+	return 0;
+}
+
+static int otx2_write_flow(struct otx2_nic *pfvf, struct otx2_flow *flow)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct npc_mcam_write_entry_req *req;
+	struct mcam_entry entry;
+	int err;
+
+	err = otx2_prepare_flow(pfvf, &flow->flow_spec, &entry);
+	if (err)
+		return err;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_MCAM_WRITE_ENTRY(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->entry_data = entry;
+	req->entry = flow_cfg->entry + flow->flow_spec.location;
+	req->intf = NIX_INTF_RX;
+	req->enable_entry = 1;
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+
+static int otx2_disable_flow(struct otx2_nic *pfvf, u32 location)
+{
+	struct npc_mcam_ena_dis_entry_req *req;
+	int err;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_MCAM_DIS_ENTRY(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->entry = pfvf->flow_cfg.entry + location;
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
+}
+
+static struct otx2_flow *otx2_find_flow(struct otx2_nic *pfvf, u32 location)
+{
+	struct otx2_flow *iter;
+
+	list_for_each_entry(iter, &pfvf->flow_cfg.flow_list, list) {
+		if (iter->flow_spec.location == location)
+			return iter;
+	}
+	return NULL;
+}
+
+static void otx2_add_flow_to_list(struct otx2_nic *pfvf,
+				  struct otx2_flow *flow)
+{
+	struct list_head *head = &pfvf->flow_cfg.flow_list;
+	struct otx2_flow *iter;
+
+	list_for_each_entry(iter, &pfvf->flow_cfg.flow_list, list) {
+		if (iter->flow_spec.location > flow->flow_spec.location)
+			break;
+		head = &iter->list;
+	}
+	list_add(&flow->list, head);
+}
+
+static int otx2_validate_flow(struct otx2_nic *pfvf,
+			      struct ethtool_rx_flow_spec *fsp)
+{
+	u64 ring = ethtool_get_flow_spec_ring(fsp->ring_cookie);
+
+	if (fsp->location >= OTX2_MAX_NTUPLE_FLOWS)
+		return -EINVAL;
+
+	if (fsp->ring_cookie == RX_CLS_FLOW_DISC)
+		return 0;
+
+	/* Steering to VFs is not supported */
+	if (ethtool_get_flow_spec_ring_vf(fsp->ring_cookie))
+		return -EOPNOTSUPP;
+
+	if (fsp->flow_type & FLOW_RSS)
+		return 0;
+
+	if (ring >= pfvf->hw.rx_queues)
+		return -EINVAL;
+	return 0;
+}
+
+int otx2_add_flow(struct otx2_nic *pfvf, struct ethtool_rx_flow_spec *fsp)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct ethtool_rx_flow_spec old_spec;
+	struct mcam_entry entry;
+	struct otx2_flow *flow;
+	bool new = false;
+	int err;
+
+	if (!(pfvf->netdev->features & NETIF_F_NTUPLE))
+		return -EOPNOTSUPP;
+
+	err = otx2_validate_flow(pfvf, fsp);
+	if (err)
+		return err;
+
+	err = otx2_get_kex_cfg(pfvf);
+	if (err)
+		return err;
+
+	/* Check the rule fits MCAM key before touching HW */
+	err = otx2_prepare_flow(pfvf, fsp, &entry);
+	if (err)
+		return err;
+
+	flow = otx2_find_flow(pfvf, fsp->location);
+	if (!flow) {
+		flow = kzalloc(sizeof(*flow), GFP_KERNEL);
+		if (!flow)
+			return -ENOMEM;
+		new = true;
+	} else {
+		old_spec = flow->flow_spec;
+	}
+	flow->flow_spec = *fsp;
+
+	/* With interface down, rule is installed on next open */
+	if (netif_running(pfvf->netdev)) {
+		if (!flow_cfg->entry_valid)
+			err = otx2_alloc_mcam_entries(pfvf);
+		if (!err)
+			err = otx2_write_flow(pfvf, flow);
+		if (err) {
+			if (new)
+				kfree(flow);
+			else
+				flow->flow_spec = old_spec;
+			return err;
+		}
+	}
+
+	if (new) {
+		otx2_add_flow_to_list(pfvf, flow);
+		flow_cfg->nr_flows++;
+	}
+	return 0;
+}
+
+int otx2_remove_flow(struct otx2_nic *pfvf, u32 location)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct otx2_flow *flow;
+	int err = 0;
+
+	if (location >= OTX2_MAX_NTUPLE_FLOWS)
+		return -EINVAL;
+
+	flow = otx2_find_flow(pfvf, location);
+	if (!flow)
+		return -ENOENT;
+
+	if (netif_running(pfvf->netdev) && flow_cfg->entry_valid)
+		err = otx2_disable_flow(pfvf, location);
+
+	list_del(&flow->list);
+	kfree(flow);
+	flow_cfg->nr_flows--;
+	return err;
+}
+
+int otx2_get_flow(struct otx2_nic *pfvf, struct ethtool_rxnfc *nfc,
+		  u32 location)
+{
+	struct otx2_flow *flow;
+
+	if (location >= OTX2_MAX_NTUPLE_FLOWS)
+		return -EINVAL;
+
+	flow = otx2_find_flow(pfvf, location);
+	if (!flow)
+		return -ENOENT;
+
+	nfc->fs = flow->flow_spec;
+	return 0;
+}
+
+int otx2_get_all_flows(struct otx2_nic *pfvf, struct ethtool_rxnfc *nfc,
+		       u32 *rule_locs)
+{
+	struct otx2_flow *flow;
+	u32 idx = 0;
+
+	nfc->data = OTX2_MAX_NTUPLE_FLOWS;
+	list_for_each_entry(flow, &pfvf->flow_cfg.flow_list, list) {
+		if (idx == nfc->rule_cnt)
+			return -EMSGSIZE;
+		rule_locs[idx++] = flow->flow_spec.location;
+	}
+	nfc->rule_cnt = idx;
+	return 0;
+}
+
+/* MCAM entries are freed by AF along with NIX LF, so on every
+ * open get new ones and install rules added so far.
+ */
+int otx2_restore_flows(struct otx2_nic *pfvf)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct otx2_flow *flow;
+	int err;
+
+	flow_cfg->entry_valid = false;
+	if (!flow_cfg->nr_flows)
+		return 0;
+
+	err = otx2_alloc_mcam_entries(pfvf);
+	if (err)
+		return err;
+
+	list_for_each_entry(flow, &flow_cfg->flow_list, list) {
+		/* Target queue may be gone after a channel count change */
+		err = otx2_validate_flow(pfvf, &flow->flow_spec);
+		if (!err)
+			err = otx2_write_flow(pfvf, flow);
+		if (err)
+			netdev_warn(pfvf->netdev,
+				    "Failed to restore ntuple rule %d\n",
+				    flow->flow_spec.location);
+	}
+	return 0;
+}
+
+/* Rules with RSS action carry the flow key algorithm index,
+ * reinstall them when hash fields are changed.
+ */
+int otx2_update_rss_flows(struct otx2_nic *pfvf)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	struct otx2_flow *flow;
+	int err;
+
+	if (!netif_running(pfvf->netdev) || !flow_cfg->entry_valid)
+		return 0;
+
+	list_for_each_entry(flow, &flow_cfg->flow_list, list) {
+		if (!(flow->flow_spec.flow_type & FLOW_RSS))
+			continue;
+		err = otx2_write_flow(pfvf, flow);
+		if (err)
+			return err;
+	}
+	return 0;
+}
+
+void otx2_mcam_flow_init(struct otx2_nic *pfvf)
+{
+	INIT_LIST_HEAD(&pfvf->flow_cfg.flow_list);
+	otx2_tc_init(pfvf);
+}
+EXPORT_SYMBOL(otx2_mcam_flow_init);
+
+/* Remove all rules, also from HW if they are installed */
+void otx2_mcam_flow_del(struct otx2_nic *pfvf)
+{
+	struct otx2_flow_config *flow_cfg = &pfvf->flow_cfg;
+	bool installed = netif_running(pfvf->netdev) && flow_cfg->entry_valid;
+	struct otx2_flow *iter, *tmp;
+
+	list_for_each_entry_safe(iter, tmp, &flow_cfg->flow_list, list) {
+		if (installed)
+			otx2_disable_flow(pfvf, iter->flow_spec.location);
+		list_del(&iter->list);
+		kfree(iter);
+	}
+	flow_cfg->nr_flows = 0;
+}
+EXPORT_SYMBOL(otx2_mcam_flow_del);
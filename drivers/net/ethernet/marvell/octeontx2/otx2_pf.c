@@ -16,6 +16,7 @@
 #include <linux/if_vlan.h>
 #include <net/ip.h>
 #include <linux/iommu.h>
+#include <linux/bpf.h>
 
 #include "otx2_reg.h"
 #include "otx2_common.h"
@@ -53,6 +54,12 @@ static void otx2_process_pfaf_mbox_msg(struct otx2_nic *pf,
 		return;
 	}
 
+	/* Responses to the VF requests relayed by this PF are
+	 * handed over to VFs as is, they don't carry PF's state.
+	 */
+	if (msg->pcifunc & RVU_PFVF_FUNC_MASK)
+		return;
+
 	switch (msg->id) {
 	case MBOX_MSG_READY:
 		pf->pcifunc = msg->pcifunc;
@@ -119,6 +126,7 @@ static int otx2_mbox_up_handler_CGX_LINK_EVENT(struct otx2_nic *pf,
 {
 	struct cgx_link_user_info *linfo = &msg->link_info;
 	struct net_device *netdev = pf->netdev;
+	int vf;
 
 	pr_info("%s NIC Link is %s\n",
 		netdev->name, linfo->link_up ? "UP" : "DOWN");
@@ -129,6 +137,12 @@ static int otx2_mbox_up_handler_CGX_LINK_EVENT(struct otx2_nic *pf,
 		netif_tx_stop_all_queues(netdev);
 		netif_carrier_off(netdev);
 	}
+
+	/* VFs share this PF's link, pass the event on to them */
+	pf->linfo = *linfo;
+	for (vf = 0; vf < pf->num_vfs; vf++)
+		queue_work(pf->pfvf_mbox_wq,
+			   &pf->vf_configs[vf].link_event_wrk);
 	return 0;
 }
 
@@ -319,6 +333,7 @@ static int otx2_pfaf_mbox_init(struct otx2_nic *pf)
 	int err;
 
 	mbox->pfvf = pf;
+	mutex_init(&mbox->lock);
 	pf->mbox_wq = alloc_workqueue("otx2_pfaf_mailbox",
 				      WQ_UNBOUND | WQ_HIGHPRI |
 				      WQ_MEM_RECLAIM, 1);
@@ -356,34 +371,802 @@ static int otx2_pfaf_mbox_init(struct otx2_nic *pf)
 	return err;
 }
 
+static inline u16 otx2_vf_pcifunc(struct otx2_nic *pf, int vf)
+{
+	return pf->pcifunc | ((vf + 1) & RVU_PFVF_FUNC_MASK);
+}
+
+/* Below otx2_vf_set_*_hw() push admin set config of a VF to AF,
+ * caller holds mbox lock.
+ */
+static int otx2_vf_set_mac_hw(struct otx2_nic *pf, int vf)
+{
+	struct otx2_vf_config *config = &pf->vf_configs[vf];
+	struct nix_set_mac_addr *req;
+
+	req = otx2_mbox_alloc_msg_NIX_SET_MAC_ADDR(&pf->mbox);
+	if (!req)
+		return -ENOMEM;
+
+	req->hdr.pcifunc = otx2_vf_pcifunc(pf, vf);
+	ether_addr_copy(req->mac_addr, config->mac);
+	return otx2_sync_mbox_msg(&pf->mbox);
+}
+
+static int otx2_vf_set_rate_hw(struct otx2_nic *pf, int vf)
+{
+	struct otx2_vf_config *config = &pf->vf_configs[vf];
+	struct nix_txschq_config *req;
+
+	req = otx2_mbox_alloc_msg_NIX_TXSCHQ_CFG(&pf->mbox);
+	if (!req)
+		return -ENOMEM;
+
+	/* Each VF has a TL2 of its own, shape all of VF's traffic there */
+	req->hdr.pcifunc = otx2_vf_pcifunc(pf, vf);
+	req->lvl = NIX_TXSCH_LVL_TL2;
+	req->num_regs = 2;
+	req->reg[0] = NIX_AF_TL2X_CIR(config->tl2_schq);
+	req->regval[0] = config->min_tx_rate ?
+		otx2_get_txschq_rate_regval(config->min_tx_rate) : 0;
+	req->reg[1] = NIX_AF_TL2X_PIR(config->tl2_schq);
+	req->regval[1] = config->max_tx_rate ?
+		otx2_get_txschq_rate_regval(config->max_tx_rate) : 0;
+	return otx2_sync_mbox_msg(&pf->mbox);
+}
+
+/* PF's verdict on a VF request, kept for the reply to VF */
+struct otx2_vf_msg {
+	u16	id;
+	int	rc;
+};
+
+/* Check a VF's request against the config admin has set for it,
+ * only requests known to be VF's business are relayed. Returns the
+ * error to reply VF with if request is not to be relayed.
+ * Requests which are let through may get altered, so this is to be
+ * run on PF's own copy of the request and not on VF's mailbox.
+ */
+static int otx2_vf_check_msg(struct otx2_nic *pf, int vf,
+			     struct mbox_msghdr *msg, int size)
+{
+	struct otx2_vf_config *config = &pf->vf_configs[vf];
+	struct nix_txschq_config *txschq;
+	struct nix_rx_mode *rx_mode;
+	int idx;
+	u64 reg;
+
+	if (size < (int)sizeof(*msg) || msg->id >= MBOX_MSG_MAX ||
+	    msg->sig != OTX2_MBOX_REQ_SIG)
+		return MBOX_MSG_INVALID;
+
+	switch (msg->id) {
+	case MBOX_MSG_NIX_SET_MAC_ADDR:
+		if (!config->trusted && !is_zero_ether_addr(config->mac))
+			return -EPERM;
+		break;
+	case MBOX_MSG_NIX_SET_RX_MODE:
+		if (size < (int)sizeof(*rx_mode))
+			return MBOX_MSG_INVALID;
+		rx_mode = (struct nix_rx_mode *)msg;
+		if (!config->trusted)
+			rx_mode->mode &= ~NIX_RX_MODE_PROMISC;
+		break;
+	case MBOX_MSG_NIX_TXSCHQ_CFG:
+		if (size < (int)sizeof(*txschq))
+			return MBOX_MSG_INVALID;
+		txschq = (struct nix_txschq_config *)msg;
+		if (txschq->lvl != NIX_TXSCH_LVL_TL2 ||
+		    (!config->min_tx_rate && !config->max_tx_rate))
+			break;
+		for (idx = 0; idx < txschq->num_regs &&
+		     idx < MAX_REGS_PER_MBOX_MSG; idx++) {
+			reg = txschq->reg[idx] & 0xFFFF;
+			if (reg == NIX_AF_TL2X_CIR(0) ||
+			    reg == NIX_AF_TL2X_PIR(0))
+				return -EPERM;
+		}
+		break;
+	case MBOX_MSG_PTP_OP:
+		if (size < (int)sizeof(struct ptp_req))
+			return MBOX_MSG_INVALID;
+		/* PTP block is shared by all ports, VFs only read it */
+		if (((struct ptp_req *)msg)->op != PTP_OP_GET_CLOCK)
+			return -EPERM;
+		break;
+	/* Requests VF driver makes to get and run its own resources */
+	case MBOX_MSG_READY:
+	case MBOX_MSG_ATTACH_RESOURCES:
+	case MBOX_MSG_DETACH_RESOURCES:
+	case MBOX_MSG_MSIX_OFFSET:
+	case MBOX_MSG_CGX_GET_LINKINFO:
+	case MBOX_MSG_CGX_START_RXTX:
+	case MBOX_MSG_CGX_STOP_RXTX:
+	case MBOX_MSG_NPA_LF_ALLOC:
+	case MBOX_MSG_NPA_LF_FREE:
+	case MBOX_MSG_NPA_AQ_ENQ:
+	case MBOX_MSG_NPA_HWCTX_DISABLE:
+	case MBOX_MSG_NIX_LF_ALLOC:
+	case MBOX_MSG_NIX_LF_FREE:
+	case MBOX_MSG_NIX_AQ_ENQ:
+	case MBOX_MSG_NIX_HWCTX_DISABLE:
+	case MBOX_MSG_NIX_TXSCH_ALLOC:
+	case MBOX_MSG_NIX_TXSCH_FREE:
+	case MBOX_MSG_NIX_VTAG_CFG:
+	case MBOX_MSG_NIX_RSS_FLOWKEY_CFG:
+	case MBOX_MSG_NIX_SET_HW_FRS:
+	case MBOX_MSG_NPC_GET_KEX_CFG:
+	case MBOX_MSG_NPC_MCAM_ALLOC_ENTRY:
+	case MBOX_MSG_NPC_MCAM_FREE_ENTRY:
+	case MBOX_MSG_NPC_MCAM_WRITE_ENTRY:
+	case MBOX_MSG_NPC_MCAM_DIS_ENTRY:
+		break;
+	default:
+		/* Anything else may affect the PF or other VFs */
+		return -EPERM;
+	}
+	return 0;
+}
+
+/* Take back the last request queued up in PF => AF mailbox */
+static void otx2_vf_unqueue_msg(struct otx2_nic *pf, int size)
+{
+	struct otx2_mbox_dev *mdev = &pf->mbox.mbox.dev[0];
+
+	spin_lock(&mdev->mbox_lock);
+	mdev->msg_size -= ALIGN(size, MBOX_MSG_ALIGN);
+	mdev->rsp_size -= ALIGN(sizeof(struct msg_rsp), MBOX_MSG_ALIGN);
+	mdev->num_msgs--;
+	spin_unlock(&mdev->mbox_lock);
+}
+
+/* Copy VF's requests to PF => AF mailbox, check the copies and send
+ * the ones which pass to AF. Verdict on each request is noted down
+ * in @msgs for the reply. Caller holds mbox lock.
+ */
+static int otx2_vf_forward_msgs(struct otx2_nic *pf, int vf,
+				struct otx2_vf_msg *msgs, int num_msgs)
+{
+	struct otx2_mbox *mbox = &pf->pfvf_mbox;
+	struct otx2_mbox_dev *mdev = &mbox->dev[vf];
+	int offset, end, id, size, fwd_cnt = 0;
+	struct mbox_msghdr *msg, *fwd;
+	u16 next_msgoff;
+
+	offset = mbox->rx_start + ALIGN(sizeof(struct mbox_hdr),
+					MBOX_MSG_ALIGN);
+	end = mbox->rx_start + mbox->rx_size;
+	for (id = 0; id < num_msgs; id++) {
+		/* Offsets are VF's to set, don't let them point
+		 * outside of VF's own mailbox region.
+		 */
+		if (offset + (int)sizeof(*msg) > end)
+			goto invalid;
+		msg = (struct mbox_msghdr *)(mdev->mbase + offset);
+		size = mbox->rx_start + READ_ONCE(msg->next_msgoff) - offset;
+		if (size <= 0 || offset + size > end)
+			goto invalid;
+
+		fwd = otx2_mbox_alloc_msg_rsp(&pf->mbox.mbox, 0, size,
+					      sizeof(struct msg_rsp));
+		if (!fwd) {
+			otx2_mbox_reset(&pf->mbox.mbox, 0);
+			return -ENOMEM;
+		}
+		next_msgoff = fwd->next_msgoff;
+		memcpy(fwd, msg, size);
+		fwd->next_msgoff = next_msgoff;
+		offset += size;
+
+		/* VF may still write to its mailbox, go by the copy */
+		msgs[id].id = fwd->id;
+		msgs[id].rc = otx2_vf_check_msg(pf, vf, fwd, size);
+		if (msgs[id].rc) {
+			otx2_vf_unqueue_msg(pf, size);
+			continue;
+		}
+		/* AF fills in PF bits, VF's ones are upto this PF */
+		fwd->pcifunc = otx2_vf_pcifunc(pf, vf);
+		fwd_cnt++;
+	}
+
+	if (!fwd_cnt)
+		return 0;
+	return otx2_sync_mbox_msg(&pf->mbox);
+
+invalid:
+	dev_warn(pf->dev, "VF%d mbox msg %d has bad offset\n", vf, id);
+	for (; id < num_msgs; id++)
+		msgs[id].id = MBOX_MSG_MAX;
+	otx2_mbox_reset(&pf->mbox.mbox, 0);
+	return MBOX_MSG_INVALID;
+}
+
+/* Note down VF's resources which admin config is applied to */
+static void otx2_vf_update_state(struct otx2_nic *pf, int vf,
+				 struct mbox_msghdr *req,
+				 struct mbox_msghdr *rsp)
+{
+	struct otx2_vf_config *config = &pf->vf_configs[vf];
+	struct nix_txsch_alloc_rsp *txsch;
+	struct nix_lf_alloc_req *lf_req;
+	struct nix_lf_alloc_rsp *lf_rsp;
+
+	if (rsp->rc)
+		return;
+
+	switch (rsp->id) {
+	case MBOX_MSG_NIX_LF_ALLOC:
+		lf_req = (struct nix_lf_alloc_req *)req;
+		lf_rsp = (struct nix_lf_alloc_rsp *)rsp;
+		config->nixlf_valid = true;
+		config->rq_cnt = lf_req->rq_cnt;
+		config->sq_cnt = lf_req->sq_cnt;
+		if (!is_zero_ether_addr(config->mac))
+			ether_addr_copy(lf_rsp->mac_addr, config->mac);
+		break;
+	case MBOX_MSG_NIX_TXSCH_ALLOC:
+		txsch = (struct nix_txsch_alloc_rsp *)rsp;
+		if (!txsch->schq[NIX_TXSCH_LVL_TL2])
+			break;
+		config->tl2_valid = true;
+		config->tl2_schq = txsch->schq_list[NIX_TXSCH_LVL_TL2][0];
+		break;
+	case MBOX_MSG_NIX_TXSCH_FREE:
+		config->tl2_valid = false;
+		break;
+	case MBOX_MSG_NIX_LF_FREE:
+	case MBOX_MSG_DETACH_RESOURCES:
+		config->nixlf_valid = false;
+		config->tl2_valid = false;
+		break;
+	}
+}
+
+/* Reply to VF with AF's responses to the relayed requests
+ * and with an error to the rest. Caller holds mbox lock.
+ */
+static void otx2_vf_reply_msgs(struct otx2_nic *pf, int vf,
+			       struct otx2_vf_msg *msgs, int num_msgs,
+			       int err)
+{
+	struct otx2_mbox *af_mbox = &pf->mbox.mbox;
+	struct otx2_mbox_dev *af_mdev = &af_mbox->dev[0];
+	struct otx2_mbox *mbox = &pf->pfvf_mbox;
+	int req_offset, af_offset, id, size, rc, acked = 0;
+	struct mbox_msghdr *req, *rsp, *af_rsp;
+	u16 next_msgoff;
+
+	req_offset = af_mbox->tx_start + ALIGN(sizeof(struct mbox_hdr),
+					       MBOX_MSG_ALIGN);
+	af_offset = af_mbox->rx_start + ALIGN(sizeof(struct mbox_hdr),
+					      MBOX_MSG_ALIGN);
+	for (id = 0; id < num_msgs; id++) {
+		rc = err ? err : msgs[id].rc;
+		if (!rc && acked == af_mdev->msgs_acked)
+			rc = -EIO;
+		if (rc) {
+			rsp = otx2_mbox_alloc_msg(mbox, vf,
+						  sizeof(struct msg_rsp));
+			if (!rsp)
+				return;
+			rsp->id = msgs[id].id;
+			rsp->sig = OTX2_MBOX_RSP_SIG;
+			rsp->pcifunc = otx2_vf_pcifunc(pf, vf);
+			rsp->rc = rc;
+			continue;
+		}
+
+		/* PF's copy of the request, as relayed to AF */
+		req = (struct mbox_msghdr *)(af_mdev->mbase + req_offset);
+		req_offset = af_mbox->tx_start + req->next_msgoff;
+
+		af_rsp = (struct mbox_msghdr *)(af_mdev->mbase + af_offset);
+		size = af_mbox->rx_start + af_rsp->next_msgoff - af_offset;
+		af_offset = af_mbox->rx_start + af_rsp->next_msgoff;
+		acked++;
+
+		rsp = otx2_mbox_alloc_msg(mbox, vf, size);
+		if (!rsp)
+			return;
+		next_msgoff = rsp->next_msgoff;
+		memcpy(rsp, af_rsp, size);
+		rsp->next_msgoff = next_msgoff;
+		otx2_vf_update_state(pf, vf, req, rsp);
+	}
+}
+
+static void otx2_pfvf_mbox_handler(struct work_struct *work)
+{
+	int vf, err, num_msgs, max_msgs;
+	struct otx2_vf_config *config;
+	bool nixlf_valid, tl2_valid;
+	struct otx2_mbox_dev *mdev;
+	struct mbox_hdr *req_hdr;
+	struct otx2_vf_msg *msgs;
+	struct otx2_nic *pf;
+
+	config = container_of(work, struct otx2_vf_config, mbox_wrk);
+	pf = config->pf;
+	vf = config - pf->vf_configs;
+	mdev = &pf->pfvf_mbox.dev[vf];
+
+	req_hdr = (struct mbox_hdr *)(mdev->mbase + pf->pfvf_mbox.rx_start);
+	num_msgs = READ_ONCE(req_hdr->num_msgs);
+	if (!num_msgs)
+		return;
+
+	/* No more messages than what fit in VF's mailbox region */
+	max_msgs = pf->pfvf_mbox.rx_size / MBOX_MSG_ALIGN;
+	num_msgs = min(num_msgs, max_msgs);
+	msgs = kcalloc(num_msgs, sizeof(*msgs), GFP_KERNEL);
+	if (!msgs)
+		return;
+
+	mutex_lock(&pf->mbox.lock);
+	nixlf_valid = config->nixlf_valid;
+	tl2_valid = config->tl2_valid;
+
+	err = otx2_vf_forward_msgs(pf, vf, msgs, num_msgs);
+	otx2_vf_reply_msgs(pf, vf, msgs, num_msgs, err);
+
+	/* Apply admin config to the resources VF has just got,
+	 * before VF gets to use them.
+	 */
+	if (config->nixlf_valid && !nixlf_valid &&
+	    !is_zero_ether_addr(config->mac) && otx2_vf_set_mac_hw(pf, vf))
+		dev_warn(pf->dev, "Failed to set VF%d MAC\n", vf);
+	if (config->tl2_valid && !tl2_valid &&
+	    (config->min_tx_rate || config->max_tx_rate) &&
+	    otx2_vf_set_rate_hw(pf, vf))
+		dev_warn(pf->dev, "Failed to set VF%d Tx rate\n", vf);
+	mutex_unlock(&pf->mbox.lock);
+	kfree(msgs);
+
+	otx2_mbox_msg_send(&pf->pfvf_mbox, vf);
+}
+
+static void otx2_pfvf_mbox_up_handler(struct work_struct *work)
+{
+	struct otx2_vf_config *config;
+	struct otx2_mbox_dev *mdev;
+	struct mbox_hdr *rsp_hdr;
+	struct mbox_msghdr *msg;
+	struct otx2_mbox *mbox;
+	struct otx2_nic *pf;
+	int offset, id, vf;
+
+	config = container_of(work, struct otx2_vf_config, mbox_up_wrk);
+	pf = config->pf;
+	vf = config - pf->vf_configs;
+	mbox = &pf->pfvf_mbox_up;
+	mdev = &mbox->dev[vf];
+
+	rsp_hdr = (struct mbox_hdr *)(mdev->mbase + mbox->rx_start);
+	if (!rsp_hdr->num_msgs)
+		return;
+
+	offset = mbox->rx_start + ALIGN(sizeof(*rsp_hdr), MBOX_MSG_ALIGN);
+
+	for (id = 0; id < rsp_hdr->num_msgs; id++) {
+		msg = (struct mbox_msghdr *)(mdev->mbase + offset);
+
+		if (msg->id >= MBOX_MSG_MAX) {
+			dev_err(pf->dev,
+				"Mbox msg with unknown ID 0x%x\n", msg->id);
+			goto end;
+		}
+
+		if (msg->sig != OTX2_MBOX_RSP_SIG) {
+			dev_err(pf->dev,
+				"Mbox msg with wrong signature %x, ID 0x%x\n",
+				msg->sig, msg->id);
+			goto end;
+		}
+
+		if (msg->rc)
+			dev_err(pf->dev,
+				"VF%d mbox msg response has err %d, ID 0x%x\n",
+				vf, msg->rc, msg->id);
+end:
+		offset = mbox->rx_start + msg->next_msgoff;
+		mdev->msgs_acked++;
+	}
+
+	otx2_mbox_reset(mbox, vf);
+}
+
+static void otx2_queue_vf_mbox_work(struct otx2_nic *pf, u64 intr, int first)
+{
+	struct mbox_hdr *hdr;
+	struct otx2_mbox *mbox;
+	int i, vf;
+
+	for (i = 0; i < 64; i++) {
+		if (!(intr & BIT_ULL(i)))
+			continue;
+		vf = first + i;
+		if (vf >= pf->num_vfs)
+			break;
+
+		/* Check for VF => PF requests */
+		mbox = &pf->pfvf_mbox;
+		hdr = (struct mbox_hdr *)(mbox->dev[vf].mbase +
+					  mbox->rx_start);
+		if (hdr->num_msgs)
+			queue_work(pf->pfvf_mbox_wq,
+				   &pf->vf_configs[vf].mbox_wrk);
+
+		/* Check for VF => PF responses to notifications */
+		mbox = &pf->pfvf_mbox_up;
+		hdr = (struct mbox_hdr *)(mbox->dev[vf].mbase +
+					  mbox->rx_start);
+		if (hdr->num_msgs)
+			queue_work(pf->pfvf_mbox_wq,
+				   &pf->vf_configs[vf].mbox_up_wrk);
+	}
+}
+
+static irqreturn_t otx2_pfvf_mbox_intr_handler(int irq, void *pf_irq)
+{
+	struct otx2_nic *pf = (struct otx2_nic *)pf_irq;
+	u64 intr;
+
+	/* Read latest mbox data */
+	smp_rmb();
+
+	/* VFs 64 to 127 */
+	if (pf->num_vfs > 64) {
+		intr = otx2_read64(pf, RVU_PF_VFPF_MBOX_INTX(1));
+		otx2_write64(pf, RVU_PF_VFPF_MBOX_INTX(1), intr);
+		otx2_queue_vf_mbox_work(pf, intr, 64);
+	}
+
+	/* VFs 0 to 63 */
+	intr = otx2_read64(pf, RVU_PF_VFPF_MBOX_INTX(0));
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INTX(0), intr);
+	otx2_queue_vf_mbox_work(pf, intr, 0);
+
+	return IRQ_HANDLED;
+}
+
+/* Pass on PF's last link event to VF */
+static void otx2_vf_link_event_task(struct work_struct *work)
+{
+	struct otx2_vf_config *config;
+	struct cgx_link_info_msg *req;
+	struct mbox_msghdr *msghdr;
+	struct otx2_nic *pf;
+	int vf;
+
+	config = container_of(work, struct otx2_vf_config, link_event_wrk);
+	pf = config->pf;
+	vf = config - pf->vf_configs;
+
+	/* No one to listen to link events till VF brings up its NIX LF */
+	if (!READ_ONCE(config->nixlf_valid))
+		return;
+
+	msghdr = otx2_mbox_alloc_msg_rsp(&pf->pfvf_mbox_up, vf, sizeof(*req),
+					 sizeof(struct msg_rsp));
+	if (!msghdr) {
+		dev_err(pf->dev, "Failed to create VF%d link event\n", vf);
+		return;
+	}
+
+	req = (struct cgx_link_info_msg *)msghdr;
+	req->hdr.id = MBOX_MSG_CGX_LINK_EVENT;
+	req->hdr.sig = OTX2_MBOX_REQ_SIG;
+	memcpy(&req->link_info, &pf->linfo, sizeof(req->link_info));
+
+	otx2_mbox_msg_send(&pf->pfvf_mbox_up, vf);
+	otx2_mbox_wait_for_rsp(&pf->pfvf_mbox_up, vf);
+}
+
+static void otx2_flr_handler(struct work_struct *work)
+{
+	struct otx2_vf_config *config;
+	struct otx2_nic *pf;
+	struct msg_req *req;
+	int vf, reg = 0;
+
+	config = container_of(work, struct otx2_vf_config, flr_wrk);
+	pf = config->pf;
+	vf = config - pf->vf_configs;
+
+	mutex_lock(&pf->mbox.lock);
+	req = otx2_mbox_alloc_msg_VF_FLR(&pf->mbox);
+	if (!req) {
+		mutex_unlock(&pf->mbox.lock);
+		return;
+	}
+	req->hdr.pcifunc = otx2_vf_pcifunc(pf, vf);
+
+	if (!otx2_sync_mbox_msg(&pf->mbox)) {
+		/* AF has freed all of VF's resources */
+		config->nixlf_valid = false;
+		config->tl2_valid = false;
+
+		if (vf >= 64) {
+			reg = 1;
+			vf = vf - 64;
+		}
+		/* Clear transaction pending bit */
+		otx2_write64(pf, RVU_PF_VFTRPENDX(reg), BIT_ULL(vf));
+		otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1SX(reg), BIT_ULL(vf));
+	}
+	mutex_unlock(&pf->mbox.lock);
+}
+
+static irqreturn_t otx2_pf_flr_intr_handler(int irq, void *pf_irq)
+{
+	struct otx2_nic *pf = (struct otx2_nic *)pf_irq;
+	int reg, dev, vf, start_vf, num_reg = 1;
+	u64 intr;
+
+	if (pf->num_vfs > 64)
+		num_reg = 2;
+
+	for (reg = 0; reg < num_reg; reg++) {
+		intr = otx2_read64(pf, RVU_PF_VFFLR_INTX(reg));
+		if (!intr)
+			continue;
+		start_vf = 64 * reg;
+		for (vf = 0; vf < 64; vf++) {
+			if (!(intr & BIT_ULL(vf)))
+				continue;
+			dev = vf + start_vf;
+			if (dev >= pf->num_vfs)
+				break;
+			queue_work(pf->pfvf_mbox_wq,
+				   &pf->vf_configs[dev].flr_wrk);
+			/* Clear and disable the interrupt */
+			otx2_write64(pf, RVU_PF_VFFLR_INTX(reg), BIT_ULL(vf));
+			otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1CX(reg),
+				     BIT_ULL(vf));
+		}
+	}
+	return IRQ_HANDLED;
+}
+
+static int otx2_register_vf_irq(struct otx2_nic *pf, int vec,
+				irq_handler_t handler, const char *name)
+{
+	struct otx2_hw *hw = &pf->hw;
+	char *irq_name;
+	int err;
+
+	irq_name = &hw->irq_name[vec * NAME_SIZE];
+	snprintf(irq_name, NAME_SIZE, "%s", name);
+	err = request_irq(pci_irq_vector(pf->pdev, vec), handler, 0,
+			  irq_name, pf);
+	if (err) {
+		dev_err(pf->dev,
+			"RVUPF: IRQ registration failed for %s\n", name);
+		return err;
+	}
+	hw->irq_allocated[vec] = true;
+	return 0;
+}
+
+static void otx2_free_vf_irq(struct otx2_nic *pf, int vec)
+{
+	if (!pf->hw.irq_allocated[vec])
+		return;
+	free_irq(pci_irq_vector(pf->pdev, vec), pf);
+	pf->hw.irq_allocated[vec] = false;
+}
+
+static int otx2_register_pfvf_mbox_intr(struct otx2_nic *pf, int numvfs)
+{
+	int err;
+
+	err = otx2_register_vf_irq(pf, RVU_PF_INT_VEC_VFPF_MBOX0,
+				   otx2_pfvf_mbox_intr_handler,
+				   "RVUPFVF Mbox0");
+	if (err)
+		return err;
+
+	if (numvfs > 64) {
+		err = otx2_register_vf_irq(pf, RVU_PF_INT_VEC_VFPF_MBOX1,
+					   otx2_pfvf_mbox_intr_handler,
+					   "RVUPFVF Mbox1");
+		if (err) {
+			otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFPF_MBOX0);
+			return err;
+		}
+	}
+
+	/* Enable mailbox interrupt for msgs coming from VFs.
+	 * First clear to avoid spurious interrupts, if any.
+	 */
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INTX(0), ~0ull);
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INTX(1), ~0ull);
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INT_ENA_W1SX(0), INTR_MASK(numvfs));
+	if (numvfs > 64)
+		otx2_write64(pf, RVU_PF_VFPF_MBOX_INT_ENA_W1SX(1),
+			     INTR_MASK(numvfs - 64));
+	return 0;
+}
+
+static void otx2_disable_pfvf_mbox_intr(struct otx2_nic *pf)
+{
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INT_ENA_W1CX(0), ~0ull);
+	otx2_write64(pf, RVU_PF_VFPF_MBOX_INT_ENA_W1CX(1), ~0ull);
+	otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFPF_MBOX0);
+	otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFPF_MBOX1);
+}
+
+static int otx2_register_flr_intr(struct otx2_nic *pf, int numvfs)
+{
+	int err;
+
+	err = otx2_register_vf_irq(pf, RVU_PF_INT_VEC_VFFLR0,
+				   otx2_pf_flr_intr_handler, "RVUPF FLR0");
+	if (err)
+		return err;
+
+	if (numvfs > 64) {
+		err = otx2_register_vf_irq(pf, RVU_PF_INT_VEC_VFFLR1,
+					   otx2_pf_flr_intr_handler,
+					   "RVUPF FLR1");
+		if (err) {
+			otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFFLR0);
+			return err;
+		}
+	}
+
+	/* Enable FLR interrupt for VFs, clear stale ones first */
+	otx2_write64(pf, RVU_PF_VFFLR_INTX(0), INTR_MASK(numvfs));
+	otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1SX(0), INTR_MASK(numvfs));
+	if (numvfs > 64) {
+		otx2_write64(pf, RVU_PF_VFFLR_INTX(1), INTR_MASK(numvfs - 64));
+		otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1SX(1),
+			     INTR_MASK(numvfs - 64));
+	}
+	return 0;
+}
+
+static void otx2_disable_flr_intr(struct otx2_nic *pf)
+{
+	otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1CX(0), ~0ull);
+	otx2_write64(pf, RVU_PF_VFFLR_INT_ENA_W1CX(1), ~0ull);
+	otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFFLR0);
+	otx2_free_vf_irq(pf, RVU_PF_INT_VEC_VFFLR1);
+}
+
+static void otx2_pfvf_mbox_destroy(struct otx2_nic *pf)
+{
+	/* Stop queueing link events to VFs before configs are gone */
+	rtnl_lock();
+	pf->num_vfs = 0;
+	rtnl_unlock();
+
+	/* Let VF mbox, link event and FLR work queued so far finish
+	 * before PF <=> VF mailbox is freed.
+	 */
+	if (pf->pfvf_mbox_wq) {
+		flush_workqueue(pf->pfvf_mbox_wq);
+		destroy_workqueue(pf->pfvf_mbox_wq);
+		pf->pfvf_mbox_wq = NULL;
+	}
+
+	if (pf->pfvf_mbox.hwbase)
+		iounmap((void __iomem *)pf->pfvf_mbox.hwbase);
+
+	otx2_mbox_destroy(&pf->pfvf_mbox);
+	otx2_mbox_destroy(&pf->pfvf_mbox_up);
+
+	kfree(pf->vf_configs);
+	pf->vf_configs = NULL;
+}
+
+static int otx2_pfvf_mbox_init(struct otx2_nic *pf, int numvfs)
+{
+	struct otx2_vf_config *config;
+	void __iomem *hwbase;
+	u64 base;
+	int err, vf;
+
+	/* VF <=> PF mailbox region is in PF's memory, VFs' BAR4
+	 * is set to point to it.
+	 */
+	base = otx2_read64(pf, RVU_PF_VF_BAR4_ADDR);
+	if (!base) {
+		dev_err(pf->dev, "PFVF mailbox region is not set up\n");
+		return -ENODEV;
+	}
+
+	pf->vf_configs = kcalloc(numvfs, sizeof(*config), GFP_KERNEL);
+	if (!pf->vf_configs)
+		return -ENOMEM;
+
+	/* VFs are serviced in parallel, so mailbox of one VF waiting
+	 * on AF doesn't hold up the rest.
+	 */
+	pf->pfvf_mbox_wq = alloc_workqueue("otx2_pfvf_mailbox",
+					   WQ_UNBOUND | WQ_HIGHPRI |
+					   WQ_MEM_RECLAIM, 0);
+	if (!pf->pfvf_mbox_wq) {
+		err = -ENOMEM;
+		goto free_configs;
+	}
+
+	/* Mailbox is a reserved memory (in RAM) region, shouldn't be
+	 * mapped as device memory to allow unaligned accesses.
+	 */
+	hwbase = ioremap_wc(base, MBOX_SIZE * numvfs);
+	if (!hwbase) {
+		dev_err(pf->dev, "Unable to map PFVF mailbox region\n");
+		err = -ENOMEM;
+		goto free_wq;
+	}
+
+	err = otx2_mbox_init(&pf->pfvf_mbox, hwbase, pf->pdev, pf->reg_base,
+			     MBOX_DIR_PFVF, numvfs);
+	if (err)
+		goto unmap;
+
+	err = otx2_mbox_init(&pf->pfvf_mbox_up, hwbase, pf->pdev,
+			     pf->reg_base, MBOX_DIR_PFVF_UP, numvfs);
+	if (err)
+		goto destroy;
+
+	for (vf = 0; vf < numvfs; vf++) {
+		config = &pf->vf_configs[vf];
+		config->pf = pf;
+		INIT_WORK(&config->mbox_wrk, otx2_pfvf_mbox_handler);
+		INIT_WORK(&config->mbox_up_wrk, otx2_pfvf_mbox_up_handler);
+		INIT_WORK(&config->link_event_wrk, otx2_vf_link_event_task);
+		INIT_WORK(&config->flr_wrk, otx2_flr_handler);
+	}
+	return 0;
+
+destroy:
+	otx2_mbox_destroy(&pf->pfvf_mbox);
+unmap:
+	iounmap(hwbase);
+free_wq:
+	destroy_workqueue(pf->pfvf_mbox_wq);
+	pf->pfvf_mbox_wq = NULL;
+free_configs:
+	kfree(pf->vf_configs);
+	pf->vf_configs = NULL;
+	return err;
+}
+
 static int otx2_cgx_config_linkevents(struct otx2_nic *pf, bool enable)
 {
 	struct msg_req *msg;
+	int err = -ENOMEM;
 
+	mutex_lock(&pf->mbox.lock);
 	if (enable)
 		msg = otx2_mbox_alloc_msg_CGX_START_LINKEVENTS(&pf->mbox);
 	else
 		msg = otx2_mbox_alloc_msg_CGX_STOP_LINKEVENTS(&pf->mbox);
 
-	if (!msg)
-		return -ENOMEM;
-
-	return otx2_sync_mbox_msg(&pf->mbox);
+	if (msg)
+		err = otx2_sync_mbox_msg(&pf->mbox);
+	mutex_unlock(&pf->mbox.lock);
+	return err;
 }
 
 static int otx2_cgx_config_loopback(struct otx2_nic *pf, bool enable)
 {
 	struct msg_req *msg;
+	int err = -ENOMEM;
 
+	mutex_lock(&pf->mbox.lock);
 	if (enable)
 		msg = otx2_mbox_alloc_msg_CGX_INTLBK_ENABLE(&pf->mbox);
 	else
 		msg = otx2_mbox_alloc_msg_CGX_INTLBK_DISABLE(&pf->mbox);
 
-	if (!msg)
-		return -ENOMEM;
-
-	return otx2_sync_mbox_msg(&pf->mbox);
+	if (msg)
+		err = otx2_sync_mbox_msg(&pf->mbox);
+	mutex_unlock(&pf->mbox.lock);
+	return err;
 }
 
 int otx2_set_real_num_queues(struct net_device *netdev,
@@ -419,69 +1202,204 @@ static irqreturn_t otx2_cq_intr_handler(int irq, void *cq_irq)
 	 */
 	otx2_write64(pf, NIX_LF_CINTX_ENA_W1C(qidx), BIT_ULL(0));
 
-	/* Schedule NAPI */
-	napi_schedule_irqoff(&cq_poll->napi);
+	/* Schedule NAPI */
+	napi_schedule_irqoff(&cq_poll->napi);
+
+	return IRQ_HANDLED;
+}
+
+static void otx2_disable_napi(struct otx2_nic *pf)
+{
+	struct otx2_qset *qset = &pf->qset;
+	struct otx2_cq_poll *cq_poll;
+	int qidx;
+
+	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++) {
+		cq_poll = &qset->napi[qidx];
+		napi_disable(&cq_poll->napi);
+		cancel_work_sync(&cq_poll->dim.work);
+		netif_napi_del(&cq_poll->napi);
+	}
+}
+
+/* RQ, SQ and XDP SQ of same index are mapped to the same CINT,
+ * 'cq_ids[0]' points to RQ's CQ, 'cq_ids[1]' to SQ's CQ and
+ * 'cq_ids[2]' to XDP SQ's CQ.
+ */
+static void otx2_cint_map_cqs(struct otx2_nic *pf, int cint)
+{
+	struct otx2_cq_poll *cq_poll = &pf->qset.napi[cint];
+
+	cq_poll->cq_ids[0] =
+		(cint < pf->hw.rx_queues) ? cint : CINT_INVALID_CQ;
+	cq_poll->cq_ids[1] = (cint < pf->hw.tx_queues) ?
+			      otx2_get_sq_cq(pf, cint) : CINT_INVALID_CQ;
+	cq_poll->cq_ids[2] = (cint < pf->hw.xdp_queues) ?
+			      otx2_get_sq_cq(pf, otx2_get_xdp_sq(pf, cint)) :
+			      CINT_INVALID_CQ;
+}
+
+static void otx2_cint_napi_add(struct otx2_nic *pf, int cint)
+{
+	struct otx2_cq_poll *cq_poll = &pf->qset.napi[cint];
+
+	cq_poll->cint_idx = cint;
+	otx2_cint_map_cqs(pf, cint);
+	cq_poll->dev = (void *)pf;
+	cq_poll->dim.mode = NET_DIM_CQ_PERIOD_MODE_START_FROM_CQE;
+	INIT_WORK(&cq_poll->dim.work, otx2_dim_work);
+	netif_napi_add(pf->netdev, &cq_poll->napi,
+		       otx2_poll, NAPI_POLL_WEIGHT);
+	napi_enable(&cq_poll->napi);
+}
+
+static int otx2_cint_irq_setup(struct otx2_nic *pf, int cint)
+{
+	int vec = pf->hw.nix_msixoff + NIX_LF_CINT_VEC_START + cint;
+	int err;
+
+	sprintf(&pf->hw.irq_name[vec * NAME_SIZE], "%s-rxtx-%d",
+		pf->netdev->name, cint);
+
+	err = request_irq(pci_irq_vector(pf->pdev, vec),
+			  otx2_cq_intr_handler, 0,
+			  &pf->hw.irq_name[vec * NAME_SIZE],
+			  &pf->qset.napi[cint]);
+	if (err) {
+		dev_err(pf->dev,
+			"RVUPF%d: IRQ registration failed for CQ%d\n",
+			rvu_get_pf(pf->pcifunc), cint);
+		return err;
+	}
+	pf->hw.irq_allocated[vec] = true;
+
+	/* Configure CQE interrupt coalescing parameters */
+	otx2_config_irq_coalescing(pf, cint);
+
+	/* Enable CQ IRQ */
+	otx2_write64(pf, NIX_LF_CINTX_INT(cint), BIT_ULL(0));
+	otx2_write64(pf, NIX_LF_CINTX_ENA_W1S(cint), BIT_ULL(0));
+	return 0;
+}
+
+/* Stop servicing a CINT, so that it's queues can be rebuilt */
+static void otx2_cint_quiesce(struct otx2_nic *pf, int cint)
+{
+	int vec = pf->hw.nix_msixoff + NIX_LF_CINT_VEC_START + cint;
+
+	otx2_write64(pf, NIX_LF_CINTX_ENA_W1C(cint), BIT_ULL(0));
+	synchronize_irq(pci_irq_vector(pf->pdev, vec));
+	napi_disable(&pf->qset.napi[cint].napi);
+	/* NAPI may have re-enabled the interrupt before exiting */
+	otx2_write64(pf, NIX_LF_CINTX_ENA_W1C(cint), BIT_ULL(0));
+}
 
-	return IRQ_HANDLED;
+static void otx2_cint_resume(struct otx2_nic *pf, int cint)
+{
+	napi_enable(&pf->qset.napi[cint].napi);
+	/* Interrupt is level triggered, fires again if CQEs are pending */
+	otx2_write64(pf, NIX_LF_CINTX_INT(cint), BIT_ULL(0));
+	otx2_write64(pf, NIX_LF_CINTX_ENA_W1S(cint), BIT_ULL(0));
 }
 
-static void otx2_disable_napi(struct otx2_nic *pf)
+/* Release a quiesced CINT which has no queues mapped anymore */
+static void otx2_cint_free(struct otx2_nic *pf, int cint)
 {
-	struct otx2_qset *qset = &pf->qset;
-	struct otx2_cq_poll *cq_poll;
-	int qidx;
+	struct otx2_cq_poll *cq_poll = &pf->qset.napi[cint];
+	int vec = pf->hw.nix_msixoff + NIX_LF_CINT_VEC_START + cint;
+	int irq = pci_irq_vector(pf->pdev, vec);
+
+	irq_set_affinity_hint(irq, NULL);
+	free_cpumask_var(pf->hw.affinity_mask[vec]);
+	free_irq(irq, cq_poll);
+	pf->hw.irq_allocated[vec] = false;
+
+	cancel_work_sync(&cq_poll->dim.work);
+	netif_napi_del(&cq_poll->napi);
+	memset(cq_poll, 0, sizeof(*cq_poll));
+}
 
-	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++) {
-		cq_poll = &qset->napi[qidx];
-		napi_disable(&cq_poll->napi);
-		netif_napi_del(&cq_poll->napi);
+/* Only CQ IRQs are freed when interface goes down, mailbox IRQs
+ * stay registered so that AF and VFs are serviced meanwhile.
+ */
+static void otx2_free_cint_irqs(struct otx2_nic *pf)
+{
+	int cint, vec, irq;
+
+	for (cint = 0; cint < pf->hw.cint_cnt; cint++) {
+		vec = pf->hw.nix_msixoff + NIX_LF_CINT_VEC_START + cint;
+		if (!pf->hw.irq_allocated[vec])
+			continue;
+		irq = pci_irq_vector(pf->pdev, vec);
+		irq_set_affinity_hint(irq, NULL);
+		free_cpumask_var(pf->hw.affinity_mask[vec]);
+		free_irq(irq, &pf->qset.napi[cint]);
+		pf->hw.irq_allocated[vec] = false;
 	}
 }
 
 static int otx2_init_hw_resources(struct otx2_nic *pf)
 {
-	int err, lvl;
+	int err, lvl, idx;
 
+	mutex_lock(&pf->mbox.lock);
 	/* NPA init */
 	err = otx2_config_npa(pf);
 	if (err)
-		return err;
+		goto exit;
 
 	/* NIX init */
 	err = otx2_config_nix(pf);
 	if (err)
-		return err;
+		goto exit;
+
+	/* Receive channel backpressure, needed by CQ and aura init.
+	 * It's left on only if PAUSE or PFC is enabled.
+	 */
+	err = otx2_nix_config_bp(pf, true);
+	if (!err)
+		err = otx2_nix_sync_bp(pf);
+	if (err)
+		goto exit;
 
 	/* Init Auras and pools used by NIX RQ, for free buffer ptrs */
-	err = otx2_rq_aura_pool_init(pf);
+	err = otx2_rq_aura_pool_init(pf, 0, pf->hw.rx_queues);
 	if (err)
-		return err;
+		goto exit;
 
 	/* Init Auras and pools used by NIX SQ, for queueing SQEs */
-	err = otx2_sq_aura_pool_init(pf);
+	err = otx2_sq_aura_pool_init(pf, 0, pf->hw.tx_queues);
 	if (err)
-		return err;
+		goto exit;
+
+	err = otx2_sq_aura_pool_init(pf, otx2_get_xdp_sq(pf, 0),
+				     otx2_get_xdp_sq(pf, pf->hw.xdp_queues));
+	if (err)
+		goto exit;
 
 	err = otx2_txsch_alloc(pf);
 	if (err)
-		return err;
+		goto exit;
 
 	err = otx2_config_nix_queues(pf);
 	if (err)
-		return err;
+		goto exit;
 
 	/* Initialize RSS */
 	err = otx2_rss_init(pf);
 	if (err)
-		return err;
+		goto exit;
 
 	for (lvl = 0; lvl < NIX_TXSCH_LVL_CNT; lvl++) {
-		err = otx2_txschq_config(pf, lvl);
-		if (err)
-			return err;
+		for (idx = 0; idx < otx2_txschq_cnt(pf, lvl); idx++) {
+			err = otx2_txschq_config(pf, lvl, idx);
+			if (err)
+				goto exit;
+		}
 	}
-
-	return 0;
+exit:
+	mutex_unlock(&pf->mbox.lock);
+	return err;
 }
 
 static void otx2_free_hw_resources(struct otx2_nic *pf)
@@ -493,6 +1411,7 @@ static void otx2_free_hw_resources(struct otx2_nic *pf)
 	int err, qidx, cqe_count;
 	struct msg_req *req;
 
+	mutex_lock(&mbox->lock);
 	/* Stop transmission */
 	err = otx2_txschq_stop(pf);
 	if (err)
@@ -500,11 +1419,6 @@ static void otx2_free_hw_resources(struct otx2_nic *pf)
 
 	/* Disable SQs */
 	otx2_ctx_disable(mbox, NIX_AQ_CTYPE_SQ, false);
-	for (qidx = 0; qidx < pf->hw.tx_queues; qidx++) {
-		sq = &qset->sq[qidx];
-		qmem_free(pf->dev, sq->sqe);
-		kfree(sq->sg);
-	}
 
 	/* Free SQB pointers */
 	otx2_free_aura_ptr(pf, NIX_AQ_CTYPE_SQ);
@@ -515,12 +1429,30 @@ static void otx2_free_hw_resources(struct otx2_nic *pf)
 	/*Dequeue all CQEs */
 	for (qidx = 0; qidx < qset->cq_cnt; qidx++) {
 		cq = &qset->cq[qidx];
+		if (!cq->cqe)
+			continue;
 		cqe_count = otx2_read64(pf, NIX_LF_CINTX_CNT(cq->cint_idx));
 		cqe_count &= 0xFFFFFFFF;
 		if (cqe_count)
 			otx2_napi_handler(cq, pf, cqe_count);
 	}
 
+	/* Send completions processed above refer SQ's sg list,
+	 * so free them only after all CQEs are dequeued.
+	 */
+	for (qidx = 0; qidx < 2 * pf->hw.max_queues; qidx++) {
+		sq = &qset->sq[qidx];
+		qmem_free(pf->dev, sq->sqe);
+		qmem_free(pf->dev, sq->jump);
+		qmem_free(pf->dev, sq->timestamps);
+		kfree(sq->sg);
+	}
+
+	for (qidx = 0; qidx < pf->hw.rx_queues; qidx++) {
+		if (xdp_rxq_info_is_reg(&qset->rq[qidx].xdp_rxq))
+			xdp_rxq_info_unreg(&qset->rq[qidx].xdp_rxq);
+	}
+
 	/* Free RQ buffer pointers*/
 	otx2_free_aura_ptr(pf, NIX_AQ_CTYPE_RQ);
 
@@ -545,6 +1477,7 @@ static void otx2_free_hw_resources(struct otx2_nic *pf)
 	req = otx2_mbox_alloc_msg_NPA_LF_FREE(mbox);
 	if (req)
 		WARN_ON(otx2_sync_mbox_msg(mbox));
+	mutex_unlock(&mbox->lock);
 }
 
 static netdev_tx_t otx2_xmit(struct sk_buff *skb, struct net_device *netdev)
@@ -557,6 +1490,14 @@ static netdev_tx_t otx2_xmit(struct sk_buff *skb, struct net_device *netdev)
 
 	/* Check for minimum packet length */
 	if (skb->len <= ETH_HLEN) {
+		struct otx2_sq_stats *sq_stats = &pf->hw.sq_stats[qidx];
+
+		/* SQEs staged for earlier packets still need to go out */
+		if (!skb->xmit_more)
+			otx2_sqe_flush(&pf->qset.sq[qidx]);
+		u64_stats_update_begin(&sq_stats->syncp);
+		sq_stats->drops++;
+		u64_stats_update_end(&sq_stats->syncp);
 		dev_kfree_skb(skb);
 		return NETDEV_TX_OK;
 	}
@@ -587,7 +1528,7 @@ int otx2_open(struct net_device *netdev)
 	struct otx2_nic *pf = netdev_priv(netdev);
 	struct otx2_cq_poll *cq_poll = NULL;
 	struct otx2_qset *qset = &pf->qset;
-	int err = 0, qidx, vec;
+	int err = 0, qidx;
 
 	netif_carrier_off(netdev);
 
@@ -595,12 +1536,21 @@ int otx2_open(struct net_device *netdev)
 	if (err)
 		return err;
 
-	pf->qset.cq_cnt = pf->hw.rx_queues + pf->hw.tx_queues;
+	/* With XDP, each RQ gets a dedicated SQ for XDP_TX
+	 * and for frames redirected to this device.
+	 */
+	pf->hw.xdp_queues = pf->xdp_prog ? pf->hw.rx_queues : 0;
+
+	/* Queues are laid out for the max count, so that they can be
+	 * added later on without a restart, see otx2_get_sq_cq().
+	 */
+	pf->qset.cq_cnt = 3 * pf->hw.max_queues;
 	/* RQ and SQs are mapped to different CQs,
 	 * so find out max CQ IRQs (i.e CINTs) needed.
 	 */
 	pf->hw.cint_cnt = max(pf->hw.rx_queues, pf->hw.tx_queues);
-	qset->napi = kcalloc(pf->hw.cint_cnt, sizeof(*cq_poll), GFP_KERNEL);
+	qset->napi = kcalloc_node(pf->hw.max_queues, sizeof(*cq_poll),
+				  GFP_KERNEL, dev_to_node(pf->dev));
 	if (!qset->napi)
 		return -ENOMEM;
 
@@ -613,37 +1563,29 @@ int otx2_open(struct net_device *netdev)
 	if (!qset->cq)
 		goto freemem;
 
-	qset->sq = kcalloc(pf->hw.tx_queues,
+	qset->sq = kcalloc(2 * pf->hw.max_queues,
 			   sizeof(struct otx2_snd_queue), GFP_KERNEL);
 	if (!qset->sq)
 		goto freemem;
 
-	qset->rq = kcalloc(pf->hw.rx_queues,
+	for (qidx = 0; qidx < 2 * pf->hw.max_queues; qidx++)
+		spin_lock_init(&qset->sq[qidx].xdp_lock);
+
+	qset->rq = kcalloc(pf->hw.max_queues,
 			   sizeof(struct otx2_rcv_queue), GFP_KERNEL);
 	if (!qset->rq)
 		goto freemem;
 
+	/* Size receive buffers to hold a whole frame */
+	pf->hw.rbuf_len = otx2_get_rbuf_len(netdev->mtu);
+
 	err = otx2_init_hw_resources(pf);
 	if (err)
 		goto freemem;
 
 	/* Register NAPI handler */
-	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++) {
-		cq_poll = &qset->napi[qidx];
-		cq_poll->cint_idx = qidx;
-		/* RQ0 & SQ0 are mapped to CINT0 and so on..
-		 * 'cq_ids[0]' points to RQ's CQ and
-		 * 'cq_ids[1]' points to SQ's CQ and
-		 */
-		cq_poll->cq_ids[0] =
-			(qidx <  pf->hw.rx_queues) ? qidx : CINT_INVALID_CQ;
-		cq_poll->cq_ids[1] = (qidx < pf->hw.tx_queues) ?
-				      qidx + pf->hw.rx_queues : CINT_INVALID_CQ;
-		cq_poll->dev = (void *)pf;
-		netif_napi_add(netdev, &cq_poll->napi,
-			       otx2_poll, NAPI_POLL_WEIGHT);
-		napi_enable(&cq_poll->napi);
-	}
+	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++)
+		otx2_cint_napi_add(pf, qidx);
 
 	/* Check if MAC address from AF is valid or else set a random MAC */
 	if (is_zero_ether_addr(netdev->dev_addr)) {
@@ -666,33 +1608,31 @@ int otx2_open(struct net_device *netdev)
 	if (err)
 		goto cleanup;
 
-	/* Register CQ IRQ handlers */
-	vec = pf->hw.nix_msixoff + NIX_LF_CINT_VEC_START;
-	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++) {
-		sprintf(&pf->hw.irq_name[vec * NAME_SIZE], "%s-rxtx-%d",
-			pf->netdev->name, qidx);
+	/* Restore VLAN strip config, it's reset along with NIX LF */
+	if (netdev->features & NETIF_F_HW_VLAN_CTAG_RX) {
+		err = otx2_enable_rxvlan(pf, true);
+		if (err)
+			goto cleanup;
+	}
 
-		err = request_irq(pci_irq_vector(pf->pdev, vec),
-				  otx2_cq_intr_handler, 0,
-				  &pf->hw.irq_name[vec * NAME_SIZE],
-				  &qset->napi[qidx]);
-		if (err) {
-			dev_err(pf->dev,
-				"RVUPF%d: IRQ registration failed for CQ%d\n",
-				rvu_get_pf(pf->pcifunc), qidx);
+	/* Restore PTP Tx timestamping, it's reset along with NIX LF */
+	if (pf->tstamp.tx_type == HWTSTAMP_TX_ON) {
+		err = otx2_config_hw_tx_tstamp(pf, true);
+		if (err)
 			goto cleanup;
-		}
-		pf->hw.irq_allocated[vec] = true;
-		vec++;
+	}
 
-		/* Configure CQE interrupt coalescing parameters */
-		otx2_write64(pf, NIX_LF_CINTX_WAIT(qidx),
-			     ((u64)pf->cq_time_wait << 48) |
-			     pf->cq_ecount_wait);
+	/* Install ntuple rules, if any */
+	if (otx2_restore_flows(pf))
+		netdev_warn(netdev, "Failed to restore ntuple rules\n");
+	if (otx2_tc_restore_flows(pf))
+		netdev_warn(netdev, "Failed to restore tc flower rules\n");
 
-		/* Enable CQ IRQ */
-		otx2_write64(pf, NIX_LF_CINTX_INT(qidx), BIT_ULL(0));
-		otx2_write64(pf, NIX_LF_CINTX_ENA_W1S(qidx), BIT_ULL(0));
+	/* Register CQ IRQ handlers */
+	for (qidx = 0; qidx < pf->hw.cint_cnt; qidx++) {
+		err = otx2_cint_irq_setup(pf, qidx);
+		if (err)
+			goto cleanup;
 	}
 
 	otx2_set_irq_affinity(pf);
@@ -708,9 +1648,10 @@ int otx2_open(struct net_device *netdev)
 	return 0;
 
 cleanup:
+	otx2_free_cint_irqs(pf);
 	otx2_disable_napi(pf);
-	otx2_disable_msix(pf);
 freemem:
+	kfree(qset->rq);
 	kfree(qset->sq);
 	kfree(qset->cq);
 	kfree(qset->napi);
@@ -723,6 +1664,7 @@ int otx2_stop(struct net_device *netdev)
 	struct otx2_nic *pf = netdev_priv(netdev);
 	struct otx2_cq_poll *cq_poll = NULL;
 	struct otx2_qset *qset = &pf->qset;
+	u16 cqe_cnt, sqe_cnt;
 	int qidx, vec;
 
 	/* First stop packet Rx/Tx at CGX */
@@ -735,6 +1677,9 @@ int otx2_stop(struct net_device *netdev)
 	/* 'intf_down' may be checked on any cpu */
 	smp_wmb();
 
+	/* NIX LF goes away along with its Tx timestamping config */
+	pf->hw_tx_tstamp = false;
+
 	netif_carrier_off(netdev);
 	netif_tx_stop_all_queues(netdev);
 
@@ -753,32 +1698,210 @@ int otx2_stop(struct net_device *netdev)
 
 	netif_tx_disable(netdev);
 	otx2_free_hw_resources(pf);
-	otx2_disable_msix(pf);
+	otx2_free_cint_irqs(pf);
 
 	otx2_disable_napi(pf);
 
 	for (qidx = 0; qidx < netdev->num_tx_queues; qidx++)
 		netdev_tx_reset_queue(netdev_get_tx_queue(netdev, qidx));
 
+	kfree(qset->rq);
 	kfree(qset->sq);
 	kfree(qset->cq);
 	kfree(qset->napi);
+	/* Retain queue sizes configured via ethtool */
+	cqe_cnt = qset->cqe_cnt;
+	sqe_cnt = qset->sqe_cnt;
 	memset(qset, 0, sizeof(*qset));
+	qset->cqe_cnt = cqe_cnt;
+	qset->sqe_cnt = sqe_cnt;
 	return 0;
 }
 EXPORT_SYMBOL(otx2_stop);
 
+/* Change no of queues while interface is up. Only the queues being
+ * added or removed and their CINTs are touched, rest keep running.
+ */
+int otx2_set_queue_count(struct otx2_nic *pf, int rx_queues, int tx_queues)
+{
+	int old_rx = pf->hw.rx_queues, old_tx = pf->hw.tx_queues;
+	int old_cint = pf->hw.cint_cnt, cint_cnt;
+	struct net_device *netdev = pf->netdev;
+	struct netdev_queue *txq;
+	bool rq_chg, sq_chg;
+	int qidx, err;
+
+	cint_cnt = max(rx_queues, tx_queues);
+
+	mutex_lock(&pf->mbox.lock);
+	/* Bring up new queues, they get traffic only after they
+	 * are mapped to a CINT and stack is told about them.
+	 */
+	for (qidx = old_rx; qidx < rx_queues; qidx++) {
+		err = otx2_rxq_init(pf, qidx);
+		if (err)
+			goto free_new;
+	}
+
+	for (qidx = old_tx; qidx < tx_queues; qidx++) {
+		err = otx2_txq_init(pf, qidx);
+		if (err)
+			goto free_new;
+	}
+
+	/* Stop stack from queueing to the SQs being removed */
+	for (qidx = tx_queues; qidx < old_tx; qidx++) {
+		txq = netdev_get_tx_queue(netdev, qidx);
+		__netif_tx_lock_bh(txq);
+		netif_tx_stop_queue(txq);
+		__netif_tx_unlock_bh(txq);
+	}
+
+	err = otx2_set_real_num_queues(netdev, tx_queues, rx_queues);
+	if (err)
+		goto reset;
+
+	pf->hw.rx_queues = rx_queues;
+	pf->hw.tx_queues = tx_queues;
+	WRITE_ONCE(pf->hw.xdp_queues, pf->xdp_prog ? rx_queues : 0);
+
+	/* Steer flows away from the RQs being removed */
+	err = otx2_set_rss_table_default(pf);
+	if (err)
+		goto reset;
+
+	/* Wait for ndo_xdp_xmit callers still using old XDP SQ count */
+	synchronize_net();
+
+	for (qidx = 0; qidx < max(cint_cnt, old_cint); qidx++) {
+		rq_chg = (qidx < rx_queues) != (qidx < old_rx);
+		sq_chg = (qidx < tx_queues) != (qidx < old_tx);
+		if (!rq_chg && !sq_chg)
+			continue;
+
+		if (qidx >= old_cint) {
+			otx2_cint_napi_add(pf, qidx);
+			err = otx2_cint_irq_setup(pf, qidx);
+			if (err)
+				goto reset;
+			otx2_set_cint_affinity(pf, qidx);
+			pf->hw.cint_cnt = qidx + 1;
+			continue;
+		}
+
+		otx2_cint_quiesce(pf, qidx);
+		if (sq_chg && qidx >= tx_queues) {
+			otx2_txq_free(pf, qidx);
+			netdev_tx_reset_queue(netdev_get_tx_queue(netdev,
+								  qidx));
+		}
+		if (rq_chg && qidx >= rx_queues)
+			otx2_rxq_free(pf, qidx);
+		otx2_cint_map_cqs(pf, qidx);
+		if (sq_chg && qidx < tx_queues)
+			otx2_set_xps_queue(pf, qidx);
+
+		if (qidx < cint_cnt)
+			otx2_cint_resume(pf, qidx);
+		else
+			otx2_cint_free(pf, qidx);
+	}
+	pf->hw.cint_cnt = cint_cnt;
+
+	for (qidx = old_tx; qidx < tx_queues; qidx++)
+		netif_tx_wake_queue(netdev_get_tx_queue(netdev, qidx));
+
+	mutex_unlock(&pf->mbox.lock);
+	return 0;
+
+free_new:
+	for (qidx = old_tx; qidx < tx_queues; qidx++)
+		otx2_txq_free(pf, qidx);
+	for (qidx = old_rx; qidx < rx_queues; qidx++)
+		otx2_rxq_free(pf, qidx);
+	mutex_unlock(&pf->mbox.lock);
+	return err;
+reset:
+	mutex_unlock(&pf->mbox.lock);
+	/* Queues are half way through, start afresh */
+	schedule_work(&pf->reset_task);
+	return err;
+}
+
+/* Resize CQs and SQs one CINT at a time, queues mapped
+ * to other CINTs keep forwarding meanwhile.
+ */
+int otx2_set_queue_size(struct otx2_nic *pf, u32 cqe_cnt, u32 sqe_cnt)
+{
+	struct net_device *netdev = pf->netdev;
+	struct netdev_queue *txq = NULL;
+	int cint, err = 0;
+
+	pf->qset.cqe_cnt = cqe_cnt;
+	pf->qset.sqe_cnt = sqe_cnt;
+
+	mutex_lock(&pf->mbox.lock);
+	for (cint = 0; cint < pf->hw.cint_cnt; cint++) {
+		if (cint < pf->hw.tx_queues) {
+			txq = netdev_get_tx_queue(netdev, cint);
+			__netif_tx_lock_bh(txq);
+			netif_tx_stop_queue(txq);
+			__netif_tx_unlock_bh(txq);
+		}
+
+		otx2_cint_quiesce(pf, cint);
+
+		if (cint < pf->hw.tx_queues)
+			otx2_txq_free(pf, cint);
+		if (cint < pf->hw.rx_queues) {
+			otx2_rxq_free(pf, cint);
+			err = otx2_rxq_init(pf, cint);
+		}
+		if (!err && cint < pf->hw.tx_queues)
+			err = otx2_txq_init(pf, cint);
+
+		otx2_cint_resume(pf, cint);
+
+		if (cint < pf->hw.tx_queues) {
+			netdev_tx_reset_queue(txq);
+			netif_tx_wake_queue(txq);
+		}
+
+		if (err) {
+			mutex_unlock(&pf->mbox.lock);
+			schedule_work(&pf->reset_task);
+			return err;
+		}
+	}
+	mutex_unlock(&pf->mbox.lock);
+
+	return 0;
+}
+
+/* Called in atomic context, mbox lock can't be taken here */
 static void otx2_set_rx_mode(struct net_device *netdev)
 {
 	struct otx2_nic *pf = netdev_priv(netdev);
+
+	schedule_work(&pf->rx_mode_work);
+}
+
+static void otx2_rx_mode_wrk_handler(struct work_struct *work)
+{
+	struct otx2_nic *pf = container_of(work, struct otx2_nic,
+					   rx_mode_work);
+	struct net_device *netdev = pf->netdev;
 	struct nix_rx_mode *req;
 
 	if (!(netdev->flags & IFF_UP))
 		return;
 
+	mutex_lock(&pf->mbox.lock);
 	req = otx2_mbox_alloc_msg_NIX_SET_RX_MODE(&pf->mbox);
-	if (!req)
+	if (!req) {
+		mutex_unlock(&pf->mbox.lock);
 		return;
+	}
 
 	req->mode = NIX_RX_MODE_UCAST;
 
@@ -788,7 +1911,8 @@ static void otx2_set_rx_mode(struct net_device *netdev)
 	else if (netdev->flags & IFF_ALLMULTI)
 		req->mode |= NIX_RX_MODE_ALLMULTI;
 
-	otx2_sync_mbox_msg_busy_poll(&pf->mbox);
+	otx2_sync_mbox_msg(&pf->mbox);
+	mutex_unlock(&pf->mbox.lock);
 }
 
 static void otx2_reset_task(struct work_struct *work)
@@ -808,13 +1932,260 @@ static int otx2_set_features(struct net_device *netdev,
 {
 	struct otx2_nic *pf = netdev_priv(netdev);
 	netdev_features_t changed = features ^ netdev->features;
+	int err;
 
-	if ((changed & NETIF_F_LOOPBACK) && netif_running(netdev))
+	if ((changed & NETIF_F_HW_TC) && !(features & NETIF_F_HW_TC) &&
+	    pf->tc_info.nr_flows) {
+		netdev_err(netdev, "Can't disable TC hardware offload while flows are active\n");
+		return -EBUSY;
+	}
+
+	if ((changed & NETIF_F_NTUPLE) && !(features & NETIF_F_NTUPLE))
+		otx2_mcam_flow_del(pf);
+
+	if (!netif_running(netdev))
+		return 0;
+
+	if (changed & NETIF_F_HW_VLAN_CTAG_RX) {
+		err = otx2_enable_rxvlan(pf,
+					 features & NETIF_F_HW_VLAN_CTAG_RX);
+		if (err)
+			return err;
+	}
+
+	if (changed & NETIF_F_LOOPBACK)
 		return otx2_cgx_config_loopback(pf,
 						features & NETIF_F_LOOPBACK);
 	return 0;
 }
 
+static int otx2_xdp_setup(struct otx2_nic *pf, struct bpf_prog *prog)
+{
+	struct net_device *netdev = pf->netdev;
+	bool if_up = netif_running(netdev);
+	struct bpf_prog *old_prog;
+	bool restart;
+
+	if (prog && netdev->mtu > OTX2_MAX_XDP_MTU) {
+		netdev_warn(netdev,
+			    "Jumbo frames not yet supported with XDP, current MTU %d\n",
+			    netdev->mtu);
+		return -EOPNOTSUPP;
+	}
+
+	/* Attaching or detaching a program changes the number of SQs
+	 * and DMA direction of receive buffers, hence interface needs
+	 * a restart. Replacing a program is done on the fly.
+	 */
+	restart = if_up && (!pf->xdp_prog != !prog);
+	if (restart)
+		otx2_stop(netdev);
+
+	old_prog = xchg(&pf->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (restart)
+		return otx2_open(netdev);
+
+	return 0;
+}
+
+int otx2_xdp(struct net_device *netdev, struct netdev_bpf *xdp)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return otx2_xdp_setup(pf, xdp->prog);
+	case XDP_QUERY_PROG:
+		xdp->prog_attached = !!pf->xdp_prog;
+		xdp->prog_id = pf->xdp_prog ? pf->xdp_prog->aux->id : 0;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+EXPORT_SYMBOL(otx2_xdp);
+
+static int otx2_set_vf_mac(struct net_device *netdev, int vf, u8 *mac)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+	struct otx2_vf_config *config;
+	int ret = 0;
+
+	if (vf >= pf->num_vfs)
+		return -EINVAL;
+
+	/* Zero MAC lets VF choose its own MAC again */
+	if (!is_zero_ether_addr(mac) && !is_valid_ether_addr(mac))
+		return -EINVAL;
+
+	config = &pf->vf_configs[vf];
+	mutex_lock(&pf->mbox.lock);
+	ether_addr_copy(config->mac, mac);
+	if (config->nixlf_valid && !is_zero_ether_addr(mac))
+		ret = otx2_vf_set_mac_hw(pf, vf);
+	mutex_unlock(&pf->mbox.lock);
+
+	if (!ret && config->nixlf_valid)
+		dev_info(pf->dev, "Reload VF%d driver for MAC to take effect\n",
+			 vf);
+	return ret;
+}
+
+static int otx2_set_vf_rate(struct net_device *netdev, int vf,
+			    int min_tx_rate, int max_tx_rate)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+	struct otx2_vf_config *config;
+	int ret = 0;
+
+	if (vf >= pf->num_vfs)
+		return -EINVAL;
+
+	if (min_tx_rate < 0 || max_tx_rate < 0 ||
+	    max_tx_rate > OTX2_MAX_TX_RATE || min_tx_rate > OTX2_MAX_TX_RATE ||
+	    (max_tx_rate && min_tx_rate > max_tx_rate))
+		return -EINVAL;
+
+	config = &pf->vf_configs[vf];
+	mutex_lock(&pf->mbox.lock);
+	config->min_tx_rate = min_tx_rate;
+	config->max_tx_rate = max_tx_rate;
+	if (config->tl2_valid)
+		ret = otx2_vf_set_rate_hw(pf, vf);
+	mutex_unlock(&pf->mbox.lock);
+	return ret;
+}
+
+static int otx2_set_vf_trust(struct net_device *netdev, int vf, bool enable)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+
+	if (vf >= pf->num_vfs)
+		return -EINVAL;
+
+	/* Checked when VF's requests are relayed to AF */
+	mutex_lock(&pf->mbox.lock);
+	pf->vf_configs[vf].trusted = enable;
+	mutex_unlock(&pf->mbox.lock);
+	return 0;
+}
+
+static int otx2_get_vf_config(struct net_device *netdev, int vf,
+			      struct ifla_vf_info *ivi)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+	struct otx2_vf_config *config;
+
+	if (vf >= pf->num_vfs)
+		return -EINVAL;
+
+	config = &pf->vf_configs[vf];
+	ivi->vf = vf;
+	ether_addr_copy(ivi->mac, config->mac);
+	ivi->vlan_proto = htons(ETH_P_8021Q);
+	ivi->trusted = config->trusted;
+	ivi->min_tx_rate = config->min_tx_rate;
+	ivi->max_tx_rate = config->max_tx_rate;
+	ivi->linkstate = IFLA_VF_LINK_STATE_AUTO;
+	return 0;
+}
+
+/* Send the queued up context reads and add up the counters */
+static int otx2_vf_sync_ctx_stats(struct otx2_nic *pf, u8 ctype,
+				  struct ifla_vf_stats *stats)
+{
+	struct otx2_mbox *mbox = &pf->mbox.mbox;
+	struct otx2_mbox_dev *mdev = &mbox->dev[0];
+	struct nix_aq_enq_rsp *rsp;
+	int offset, id, err;
+
+	err = otx2_sync_mbox_msg(&pf->mbox);
+	if (err)
+		return err;
+
+	offset = mbox->rx_start + ALIGN(sizeof(struct mbox_hdr),
+					MBOX_MSG_ALIGN);
+	for (id = 0; id < mdev->msgs_acked; id++) {
+		rsp = (struct nix_aq_enq_rsp *)(mdev->mbase + offset);
+		offset = mbox->rx_start + rsp->hdr.next_msgoff;
+		if (rsp->hdr.id != MBOX_MSG_NIX_AQ_ENQ || rsp->hdr.rc)
+			continue;
+
+		if (ctype == NIX_AQ_CTYPE_RQ) {
+			stats->rx_packets += rsp->rq.pkts;
+			stats->rx_bytes += rsp->rq.octs;
+			stats->rx_dropped += rsp->rq.drop_pkts;
+		} else {
+			stats->tx_packets += rsp->sq.pkts;
+			stats->tx_bytes += rsp->sq.octs;
+			stats->tx_dropped += rsp->sq.dropped_pkts;
+		}
+	}
+	return 0;
+}
+
+/* VF's RQ and SQ contexts are read, as many as mbox fits at a time */
+static int otx2_vf_ctx_stats(struct otx2_nic *pf, int vf, u8 ctype, int cnt,
+			     struct ifla_vf_stats *stats)
+{
+	struct nix_aq_enq_req *aq;
+	int qidx, queued = 0, err;
+
+	for (qidx = 0; qidx < cnt; qidx++) {
+		aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pf->mbox);
+		if (!aq && queued) {
+			err = otx2_vf_sync_ctx_stats(pf, ctype, stats);
+			if (err)
+				return err;
+			queued = 0;
+			aq = otx2_mbox_alloc_msg_NIX_AQ_ENQ(&pf->mbox);
+		}
+		if (!aq)
+			return -ENOMEM;
+
+		aq->hdr.pcifunc = otx2_vf_pcifunc(pf, vf);
+		aq->qidx = qidx;
+		aq->ctype = ctype;
+		aq->op = NIX_AQ_INSTOP_READ;
+		queued++;
+	}
+
+	if (!queued)
+		return 0;
+	return otx2_vf_sync_ctx_stats(pf, ctype, stats);
+}
+
+static int otx2_get_vf_stats(struct net_device *netdev, int vf,
+			     struct ifla_vf_stats *vf_stats)
+{
+	struct otx2_nic *pf = netdev_priv(netdev);
+	struct otx2_vf_config *config;
+	int err = 0;
+
+	if (vf >= pf->num_vfs)
+		return -EINVAL;
+
+	memset(vf_stats, 0, sizeof(*vf_stats));
+	config = &pf->vf_configs[vf];
+
+	/* Counters are in VF's queue contexts, which exist only
+	 * while VF has a NIX LF.
+	 */
+	mutex_lock(&pf->mbox.lock);
+	if (config->nixlf_valid) {
+		err = otx2_vf_ctx_stats(pf, vf, NIX_AQ_CTYPE_RQ,
+					config->rq_cnt, vf_stats);
+		if (!err)
+			err = otx2_vf_ctx_stats(pf, vf, NIX_AQ_CTYPE_SQ,
+						config->sq_cnt, vf_stats);
+	}
+	mutex_unlock(&pf->mbox.lock);
+	return err;
+}
+
 static const struct net_device_ops otx2_netdev_ops = {
 	.ndo_open		= otx2_open,
 	.ndo_stop		= otx2_stop,
@@ -823,8 +2194,21 @@ static const struct net_device_ops otx2_netdev_ops = {
 	.ndo_change_mtu         = otx2_change_mtu,
 	.ndo_set_rx_mode        = otx2_set_rx_mode,
 	.ndo_get_stats64	= otx2_get_stats64,
+	.ndo_fix_features	= otx2_fix_features,
 	.ndo_set_features	= otx2_set_features,
 	.ndo_tx_timeout         = otx2_tx_timeout,
+	.ndo_features_check	= otx2_features_check,
+	.ndo_setup_tc		= otx2_setup_tc,
+	.ndo_set_tx_maxrate	= otx2_set_tx_maxrate,
+	.ndo_bpf		= otx2_xdp,
+	.ndo_xdp_xmit		= otx2_xdp_xmit,
+	.ndo_xdp_flush		= otx2_xdp_flush,
+	.ndo_set_vf_mac		= otx2_set_vf_mac,
+	.ndo_set_vf_rate	= otx2_set_vf_rate,
+	.ndo_set_vf_trust	= otx2_set_vf_trust,
+	.ndo_get_vf_config	= otx2_get_vf_config,
+	.ndo_get_vf_stats	= otx2_get_vf_stats,
+	.ndo_do_ioctl		= otx2_ioctl,
 };
 
 static int otx2_probe(struct pci_dev *pdev, const struct pci_device_id *id)
@@ -881,7 +2265,12 @@ static int otx2_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	hw->rx_queues = qcount;
 	hw->tx_queues = qcount;
 	hw->max_queues = qcount;
-	hw->rqpool_cnt = qcount;
+
+	err = otx2_alloc_queue_stats(pf);
+	if (err)
+		goto err_free_netdev;
+
+	otx2_mcam_flow_init(pf);
 
 	pf->register_mbox_intr = otx2_register_mbox_intr;
 
@@ -935,29 +2324,52 @@ static int otx2_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 
 	netdev->hw_features = (NETIF_F_RXCSUM | NETIF_F_IP_CSUM |
 			       NETIF_F_IPV6_CSUM | NETIF_F_RXHASH |
-			       NETIF_F_TSO | NETIF_F_TSO6);
+			       NETIF_F_SG | NETIF_F_TSO | NETIF_F_TSO6 |
+			       OTX2_GSO_TUNNEL_FEATURES |
+			       NETIF_F_HW_VLAN_CTAG_RX |
+			       NETIF_F_HW_VLAN_STAG_RX |
+			       NETIF_F_HW_VLAN_CTAG_TX |
+			       NETIF_F_HW_VLAN_STAG_TX);
 	netdev->features |= netdev->hw_features;
-	netdev->hw_features |= NETIF_F_LOOPBACK;
+	netdev->hw_features |= NETIF_F_LOOPBACK | NETIF_F_NTUPLE |
+			       NETIF_F_HW_TC;
+
+	netdev->vlan_features |= (NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM |
+				  NETIF_F_TSO | NETIF_F_TSO6);
+
+	/* Segmentation and checksum offload of tunneled packets */
+	netdev->hw_enc_features = (NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM |
+				   NETIF_F_SG | NETIF_F_TSO | NETIF_F_TSO6 |
+				   OTX2_GSO_TUNNEL_FEATURES);
 
 	netdev->gso_max_segs = OTX2_MAX_GSO_SEGS;
 
 	netdev->netdev_ops = &otx2_netdev_ops;
+	otx2_set_dcbnl_ops(netdev);
 
-	/* MTU range: 68 - 9190 */
+	/* MTU range: 68 - 9182 */
 	netdev->min_mtu = OTX2_MIN_MTU;
 	netdev->max_mtu = OTX2_MAX_MTU;
 
 	INIT_WORK(&pf->reset_task, otx2_reset_task);
+	INIT_WORK(&pf->rx_mode_work, otx2_rx_mode_wrk_handler);
+
+	/* PTP is optional, NIC works without HW timestamping */
+	err = otx2_ptp_init(pf);
+	if (err)
+		dev_info(dev, "PTP clock not available, err %d\n", err);
 
 	err = register_netdev(netdev);
 	if (err) {
 		dev_err(dev, "Failed to register netdevice\n");
-		goto err_detach_rsrc;
+		goto err_ptp_destroy;
 	}
 
 	otx2_set_ethtool_ops(netdev);
 	return 0;
 
+err_ptp_destroy:
+	otx2_ptp_destroy(pf);
 err_detach_rsrc:
 	otx2_detach_resources(&pf->mbox);
 err_irq:
@@ -973,6 +2385,80 @@ static int otx2_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	return err;
 }
 
+static int otx2_sriov_enable(struct pci_dev *pdev, int numvfs)
+{
+	struct net_device *netdev = pci_get_drvdata(pdev);
+	struct otx2_nic *pf = netdev_priv(netdev);
+	int ret;
+
+	/* With Rx timestamping on, CGX prepends a timestamp to all packets
+	 * received on the LMAC, VFs included, which VFs don't strip. Rx
+	 * timestamping config is done under rtnl, so hold it till
+	 * 'num_vfs' is set.
+	 */
+	rtnl_lock();
+	if (pf->hw_rx_tstamp) {
+		rtnl_unlock();
+		return -EBUSY;
+	}
+
+	/* Init PF <=> VF mailbox stuff */
+	ret = otx2_pfvf_mbox_init(pf, numvfs);
+	if (ret) {
+		rtnl_unlock();
+		return ret;
+	}
+
+	/* Interrupt handlers look up VFs upto 'num_vfs' */
+	pf->num_vfs = numvfs;
+	rtnl_unlock();
+
+	ret = otx2_register_pfvf_mbox_intr(pf, numvfs);
+	if (ret)
+		goto free_mbox;
+
+	ret = otx2_register_flr_intr(pf, numvfs);
+	if (ret)
+		goto free_intr;
+
+	ret = pci_enable_sriov(pdev, numvfs);
+	if (ret)
+		goto free_flr;
+
+	return numvfs;
+free_flr:
+	otx2_disable_flr_intr(pf);
+free_intr:
+	otx2_disable_pfvf_mbox_intr(pf);
+free_mbox:
+	otx2_pfvf_mbox_destroy(pf);
+	return ret;
+}
+
+static int otx2_sriov_disable(struct pci_dev *pdev)
+{
+	struct net_device *netdev = pci_get_drvdata(pdev);
+	struct otx2_nic *pf = netdev_priv(netdev);
+
+	if (!pf->num_vfs)
+		return 0;
+
+	pci_disable_sriov(pdev);
+
+	otx2_disable_flr_intr(pf);
+	otx2_disable_pfvf_mbox_intr(pf);
+	otx2_pfvf_mbox_destroy(pf);
+	return 0;
+}
+
+static int otx2_sriov_configure(struct pci_dev *pdev, int numvfs)
+{
+	if (numvfs == 0)
+		return otx2_sriov_disable(pdev);
+
+	return otx2_sriov_enable(pdev, numvfs);
+}
+
 static void otx2_remove(struct pci_dev *pdev)
 {
 	struct net_device *netdev = pci_get_drvdata(pdev);
@@ -982,7 +2468,15 @@ static void otx2_remove(struct pci_dev *pdev)
 		return;
 
 	pf = netdev_priv(netdev);
+	otx2_sriov_disable(pdev);
 	unregister_netdev(netdev);
+	cancel_work_sync(&pf->rx_mode_work);
+	otx2_mcam_flow_del(pf);
+
+	/* Leave CGX without timestamps prepended to packets */
+	if (pf->hw_rx_tstamp)
+		otx2_config_hw_rx_tstamp(pf, false);
+	otx2_ptp_destroy(pf);
 
 	otx2_disable_mbox_intr(pf);
 	otx2_disable_msix(pf);
@@ -1001,6 +2495,7 @@ static struct pci_driver otx2_pf_driver = {
 	.id_table = otx2_pf_id_table,
 	.probe = otx2_probe,
 	.remove = otx2_remove,
+	.sriov_configure = otx2_sriov_configure,
 };
 
 static int __init otx2_rvupf_init_module(void)
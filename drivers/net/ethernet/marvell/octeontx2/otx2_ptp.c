@@ -0,0 +1,411 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Marvell OcteonTx2 RVU Ethernet driver
+ *
+ * Copyright (C) 2018 Marvell International Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/netdevice.h>
+#include <linux/pci.h>
+#include <linux/uaccess.h>
+
+#include "otx2_common.h"
+
+/* Cycle counter's mult is 1ns scaled by this shift, which sets the
+ * resolution of frequency adjustments. Timecounter is read often
+ * enough for the elapsed cycles times mult to not overflow.
+ */
+#define OTX2_PTP_CC_SHIFT	28
+#define OTX2_PTP_CC_MULT	BIT(OTX2_PTP_CC_SHIFT)
+#define OTX2_PTP_MAX_ADJ	1000000 /* ppb */
+#define OTX2_PTP_OVERFLOW_CHK	(10 * HZ)
+
+/* Current PTP clock, as read by AF. Zero if it couldn't be read */
+static u64 otx2_ptp_cc_read(const struct cyclecounter *cc)
+{
+	struct otx2_ptp *ptp = container_of(cc, struct otx2_ptp,
+					    cycle_counter);
+	struct otx2_nic *pfvf = ptp->nic;
+	struct ptp_req *req;
+	struct ptp_rsp *rsp;
+	u64 clk = 0;
+
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_PTP_OP(&pfvf->mbox);
+	if (!req)
+		goto out;
+
+	req->op = PTP_OP_GET_CLOCK;
+	if (otx2_sync_mbox_msg(&pfvf->mbox))
+		goto out;
+
+	rsp = (struct ptp_rsp *)otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0,
+						  &req->hdr);
+	if (!IS_ERR(rsp) && !rsp->hdr.rc)
+		clk = rsp->clk;
+out:
+	mutex_unlock(&pfvf->mbox.lock);
+	return clk;
+}
+
+/* Adjust frequency of this port's timecounter, 'scaled_ppm' is parts
+ * per million with a 16 bit fractional part.
+ */
+static int otx2_ptp_adjfine(struct ptp_clock_info *ptp_info, long scaled_ppm)
+{
+	struct otx2_ptp *ptp = container_of(ptp_info, struct otx2_ptp,
+					    ptp_info);
+	bool neg_adj = false;
+	u64 adj;
+
+	if (scaled_ppm < 0) {
+		neg_adj = true;
+		scaled_ppm = -scaled_ppm;
+	}
+
+	/* mult * scaled_ppm / (10^6 * 2^16) */
+	adj = div_u64((u64)scaled_ppm << (OTX2_PTP_CC_SHIFT - 16), 1000000);
+
+	mutex_lock(&ptp->lock);
+	/* Account for the time elapsed so far at the old rate */
+	timecounter_read(&ptp->time_counter);
+	ptp->cycle_counter.mult = neg_adj ? OTX2_PTP_CC_MULT - adj :
+					    OTX2_PTP_CC_MULT + adj;
+	mutex_unlock(&ptp->lock);
+
+	return 0;
+}
+
+static int otx2_ptp_adjtime(struct ptp_clock_info *ptp_info, s64 delta)
+{
+	struct otx2_ptp *ptp = container_of(ptp_info, struct otx2_ptp,
+					    ptp_info);
+
+	mutex_lock(&ptp->lock);
+	timecounter_adjtime(&ptp->time_counter, delta);
+	mutex_unlock(&ptp->lock);
+
+	return 0;
+}
+
+static int otx2_ptp_gettime(struct ptp_clock_info *ptp_info,
+			    struct timespec64 *ts)
+{
+	struct otx2_ptp *ptp = container_of(ptp_info, struct otx2_ptp,
+					    ptp_info);
+	u64 nsec;
+
+	mutex_lock(&ptp->lock);
+	nsec = timecounter_read(&ptp->time_counter);
+	mutex_unlock(&ptp->lock);
+
+	*ts = ns_to_timespec64(nsec);
+
+	return 0;
+}
+
+static int otx2_ptp_settime(struct ptp_clock_info *ptp_info,
+			    const struct timespec64 *ts)
+{
+	struct otx2_ptp *ptp = container_of(ptp_info, struct otx2_ptp,
+					    ptp_info);
+	u64 nsec;
+
+	nsec = timespec64_to_ns(ts);
+
+	mutex_lock(&ptp->lock);
+	timecounter_init(&ptp->time_counter, &ptp->cycle_counter, nsec);
+	mutex_unlock(&ptp->lock);
+
+	return 0;
+}
+
+/* Keeps elapsed cycles since the last timecounter read in range */
+static long otx2_ptp_do_aux_work(struct ptp_clock_info *ptp_info)
+{
+	struct otx2_ptp *ptp = container_of(ptp_info, struct otx2_ptp,
+					    ptp_info);
+
+	mutex_lock(&ptp->lock);
+	timecounter_read(&ptp->time_counter);
+	mutex_unlock(&ptp->lock);
+
+	return OTX2_PTP_OVERFLOW_CHK;
+}
+
+static int otx2_ptp_enable(struct ptp_clock_info *ptp_info,
+			   struct ptp_clock_request *rq, int on)
+{
+	return -EOPNOTSUPP;
+}
+
+int otx2_ptp_init(struct otx2_nic *pfvf)
+{
+	struct otx2_ptp *ptp_ptr;
+	struct cyclecounter *cc;
+	struct ptp_req *req;
+	struct ptp_rsp *rsp;
+	int err;
+
+	/* Check if AF has a PTP block to serve the clock */
+	mutex_lock(&pfvf->mbox.lock);
+	req = otx2_mbox_alloc_msg_PTP_OP(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->op = PTP_OP_GET_CLOCK;
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (!err) {
+		rsp = (struct ptp_rsp *)
+		       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+		err = IS_ERR(rsp) ? PTR_ERR(rsp) : rsp->hdr.rc;
+	}
+	mutex_unlock(&pfvf->mbox.lock);
+	if (err)
+		return err;
+
+	ptp_ptr = kzalloc(sizeof(*ptp_ptr), GFP_KERNEL);
+	if (!ptp_ptr)
+		return -ENOMEM;
+
+	ptp_ptr->nic = pfvf;
+	mutex_init(&ptp_ptr->lock);
+
+	/* PTP block counts in nanoseconds */
+	cc = &ptp_ptr->cycle_counter;
+	cc->read = otx2_ptp_cc_read;
+	cc->mask = CYCLECOUNTER_MASK(64);
+	cc->mult = OTX2_PTP_CC_MULT;
+	cc->shift = OTX2_PTP_CC_SHIFT;
+
+	timecounter_init(&ptp_ptr->time_counter, &ptp_ptr->cycle_counter,
+			 ktime_to_ns(ktime_get_real()));
+
+	ptp_ptr->ptp_info = (struct ptp_clock_info) {
+		.owner          = THIS_MODULE,
+		.name           = "OcteonTX2 PTP",
+		.max_adj        = OTX2_PTP_MAX_ADJ,
+		.n_ext_ts       = 0,
+		.n_pins         = 0,
+		.pps            = 0,
+		.adjfine        = otx2_ptp_adjfine,
+		.adjtime        = otx2_ptp_adjtime,
+		.gettime64      = otx2_ptp_gettime,
+		.settime64      = otx2_ptp_settime,
+		.enable         = otx2_ptp_enable,
+		.do_aux_work    = otx2_ptp_do_aux_work,
+	};
+
+	ptp_ptr->ptp_clock = ptp_clock_register(&ptp_ptr->ptp_info, pfvf->dev);
+	if (IS_ERR_OR_NULL(ptp_ptr->ptp_clock)) {
+		err = ptp_ptr->ptp_clock ?
+		      PTR_ERR(ptp_ptr->ptp_clock) : -ENODEV;
+		kfree(ptp_ptr);
+		return err;
+	}
+
+	ptp_schedule_worker(ptp_ptr->ptp_clock, OTX2_PTP_OVERFLOW_CHK);
+	pfvf->ptp = ptp_ptr;
+	return 0;
+}
+EXPORT_SYMBOL(otx2_ptp_init);
+
+void otx2_ptp_destroy(struct otx2_nic *pfvf)
+{
+	struct otx2_ptp *ptp = pfvf->ptp;
+
+	if (!ptp)
+		return;
+
+	ptp_clock_unregister(ptp->ptp_clock);
+	kfree(ptp);
+	pfvf->ptp = NULL;
+}
+EXPORT_SYMBOL(otx2_ptp_destroy);
+
+int otx2_ptp_clock_index(struct otx2_nic *pfvf)
+{
+	if (!pfvf->ptp)
+		return -ENODEV;
+
+	return ptp_clock_index(pfvf->ptp->ptp_clock);
+}
+EXPORT_SYMBOL(otx2_ptp_clock_index);
+
+/* Converts a PTP block timestamp to PHC time in nanoseconds */
+u64 otx2_ptp_tstamp2time(struct otx2_nic *pfvf, u64 tstamp)
+{
+	if (!pfvf->ptp)
+		return 0;
+
+	return timecounter_cyc2time(&pfvf->ptp->time_counter, tstamp);
+}
+EXPORT_SYMBOL(otx2_ptp_tstamp2time);
+
+/* Have CGX prepend receive timestamps to packets, and NPC
+ * skip them while parsing.
+ */
+int otx2_config_hw_rx_tstamp(struct otx2_nic *pfvf, bool enable)
+{
+	struct msg_req *req;
+	struct msg_rsp *rsp;
+	int err;
+
+	mutex_lock(&pfvf->mbox.lock);
+	if (enable)
+		req = otx2_mbox_alloc_msg_CGX_PTP_RX_ENABLE(&pfvf->mbox);
+	else
+		req = otx2_mbox_alloc_msg_CGX_PTP_RX_DISABLE(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (!err) {
+		rsp = (struct msg_rsp *)
+		       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+		err = IS_ERR(rsp) ? PTR_ERR(rsp) : rsp->hdr.rc;
+	}
+	mutex_unlock(&pfvf->mbox.lock);
+	if (err)
+		return err;
+
+	pfvf->hw_rx_tstamp = enable;
+	return 0;
+}
+EXPORT_SYMBOL(otx2_config_hw_rx_tstamp);
+
+/* Enable NIX LF to capture transmit timestamps requested via
+ * SEND_MEM subdescriptors. Config is lost along with NIX LF.
+ */
+int otx2_config_hw_tx_tstamp(struct otx2_nic *pfvf, bool enable)
+{
+	struct msg_req *req;
+	struct msg_rsp *rsp;
+	int err;
+
+	mutex_lock(&pfvf->mbox.lock);
+	if (enable)
+		req = otx2_mbox_alloc_msg_NIX_LF_PTP_TX_ENABLE(&pfvf->mbox);
+	else
+		req = otx2_mbox_alloc_msg_NIX_LF_PTP_TX_DISABLE(&pfvf->mbox);
+	if (!req) {
+		mutex_unlock(&pfvf->mbox.lock);
+		return -ENOMEM;
+	}
+
+	err = otx2_sync_mbox_msg(&pfvf->mbox);
+	if (!err) {
+		rsp = (struct msg_rsp *)
+		       otx2_mbox_get_rsp(&pfvf->mbox.mbox, 0, &req->hdr);
+		err = IS_ERR(rsp) ? PTR_ERR(rsp) : rsp->hdr.rc;
+	}
+	mutex_unlock(&pfvf->mbox.lock);
+	if (err)
+		return err;
+
+	pfvf->hw_tx_tstamp = enable;
+	return 0;
+}
+EXPORT_SYMBOL(otx2_config_hw_tx_tstamp);
+
+static int otx2_config_hwtstamp(struct net_device *netdev, struct ifreq *ifr)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	struct hwtstamp_config config;
+	bool rx_tstamp, tx_tstamp;
+	int err;
+
+	if (!pfvf->ptp)
+		return -ENODEV;
+
+	if (copy_from_user(&config, ifr->ifr_data, sizeof(config)))
+		return -EFAULT;
+
+	/* Reserved for future extensions */
+	if (config.flags)
+		return -EINVAL;
+
+	switch (config.tx_type) {
+	case HWTSTAMP_TX_OFF:
+		tx_tstamp = false;
+		break;
+	case HWTSTAMP_TX_ON:
+		tx_tstamp = true;
+		break;
+	default:
+		return -ERANGE;
+	}
+
+	switch (config.rx_filter) {
+	case HWTSTAMP_FILTER_NONE:
+		rx_tstamp = false;
+		break;
+	case HWTSTAMP_FILTER_ALL:
+	case HWTSTAMP_FILTER_SOME:
+	case HWTSTAMP_FILTER_PTP_V1_L4_EVENT:
+	case HWTSTAMP_FILTER_PTP_V1_L4_SYNC:
+	case HWTSTAMP_FILTER_PTP_V1_L4_DELAY_REQ:
+	case HWTSTAMP_FILTER_PTP_V2_L4_EVENT:
+	case HWTSTAMP_FILTER_PTP_V2_L4_SYNC:
+	case HWTSTAMP_FILTER_PTP_V2_L4_DELAY_REQ:
+	case HWTSTAMP_FILTER_PTP_V2_L2_EVENT:
+	case HWTSTAMP_FILTER_PTP_V2_L2_SYNC:
+	case HWTSTAMP_FILTER_PTP_V2_L2_DELAY_REQ:
+	case HWTSTAMP_FILTER_PTP_V2_EVENT:
+	case HWTSTAMP_FILTER_PTP_V2_SYNC:
+	case HWTSTAMP_FILTER_PTP_V2_DELAY_REQ:
+	case HWTSTAMP_FILTER_NTP_ALL:
+		/* CGX timestamps every received packet */
+		config.rx_filter = HWTSTAMP_FILTER_ALL;
+		rx_tstamp = true;
+		break;
+	default:
+		return -ERANGE;
+	}
+
+	/* CGX would prepend the timestamp to VFs' packets as well */
+	if (rx_tstamp && pfvf->num_vfs)
+		return -EBUSY;
+
+	if (rx_tstamp != pfvf->hw_rx_tstamp) {
+		err = otx2_config_hw_rx_tstamp(pfvf, rx_tstamp);
+		if (err)
+			return err;
+	}
+
+	/* Tx config needs NIX LF, otherwise it's applied upon open */
+	if (netif_running(netdev) && tx_tstamp != pfvf->hw_tx_tstamp) {
+		err = otx2_config_hw_tx_tstamp(pfvf, tx_tstamp);
+		if (err)
+			return err;
+	}
+
+	pfvf->tstamp = config;
+
+	return copy_to_user(ifr->ifr_data, &config,
+			    sizeof(config)) ? -EFAULT : 0;
+}
+
+int otx2_ioctl(struct net_device *netdev, struct ifreq *req, int cmd)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	struct hwtstamp_config *cfg = &pfvf->tstamp;
+
+	switch (cmd) {
+	case SIOCSHWTSTAMP:
+		return otx2_config_hwtstamp(netdev, req);
+	case SIOCGHWTSTAMP:
+		return copy_to_user(req->ifr_data, cfg,
+				    sizeof(*cfg)) ? -EFAULT : 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+EXPORT_SYMBOL(otx2_ioctl);
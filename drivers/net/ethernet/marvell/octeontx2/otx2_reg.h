@@ -114,6 +114,8 @@
 #define	NIX_LF_RQ_OP_INT		(NIX_LFBASE | 0x900)
 #define	NIX_LF_RQ_OP_OCTS		(NIX_LFBASE | 0x910)
 #define	NIX_LF_RQ_OP_PKTS		(NIX_LFBASE | 0x920)
+#define	NIX_LF_RQ_OP_DROP_OCTS		(NIX_LFBASE | 0x930)
+#define	NIX_LF_RQ_OP_DROP_PKTS		(NIX_LFBASE | 0x940)
 #define	NIX_LF_OP_IPSEC_DYNO_CN		(NIX_LFBASE | 0x980)
 #define	NIX_LF_SQ_OP_INT		(NIX_LFBASE | 0xa00)
 #define	NIX_LF_SQ_OP_OCTS		(NIX_LFBASE | 0xa10)
@@ -141,9 +143,17 @@
 #define NIX_AF_TL1X_TOPOLOGY(a)		(0xC80 | (a) << 16)
 #define NIX_AF_TL2X_PARENT(a)		(0xE88 | (a) << 16)
 #define NIX_AF_TL2X_SCHEDULE(a)		(0xE00 | (a) << 16)
+#define NIX_AF_TL2X_CIR(a)		(0xE20 | (a) << 16)
+#define NIX_AF_TL2X_PIR(a)		(0xE30 | (a) << 16)
+#define NIX_AF_TL3X_TOPOLOGY(a)		(0x1080 | (a) << 16)
 #define NIX_AF_TL3X_PARENT(a)		(0x1088 | (a) << 16)
+#define NIX_AF_TL4X_SCHEDULE(a)		(0x1200 | (a) << 16)
+#define NIX_AF_TL4X_CIR(a)		(0x1220 | (a) << 16)
+#define NIX_AF_TL4X_PIR(a)		(0x1230 | (a) << 16)
+#define NIX_AF_TL4X_TOPOLOGY(a)		(0x1280 | (a) << 16)
 #define NIX_AF_TL4X_PARENT(a)		(0x1288 | (a) << 16)
 #define NIX_AF_MDQX_SCHEDULE(a)		(0x1400 | (a) << 16)
+#define NIX_AF_MDQX_PIR(a)		(0x1430 | (a) << 16)
 #define NIX_AF_MDQX_PARENT(a)		(0x1480 | (a) << 16)
 #define NIX_AF_TL3_TL2X_LINKX_CFG(a, b)	(0x1700 | (a) << 16 | (b) << 3)
 
@@ -53,6 +53,15 @@ enum nix_xqe_type {
 	NIX_XQE_TYPE_SEND      = 0x8,
 };
 
+/* NIX send memory subdescriptor operations */
+enum nix_sendmemalg {
+	NIX_SENDMEMALG_SET	= 0x0,
+	NIX_SENDMEMALG_SETTSTMP	= 0x1,
+	NIX_SENDMEMALG_SETRSLT	= 0x2,
+	NIX_SENDMEMALG_ADD	= 0x8,
+	NIX_SENDMEMALG_SUB	= 0x9,
+};
+
 /* NIX CQE/SQE subdescriptor types */
 enum nix_subdc {
 	NIX_SUBDC_NOP  = 0x0,
@@ -229,6 +238,21 @@ struct nix_rx_sg_s {
 #endif
 };
 
+/* NIX CQE RX immediate subdescriptor, packet data follows it */
+struct nix_rx_imm_s {
+#if defined(__BIG_ENDIAN_BITFIELD)	/* W0 */
+	u64 subdc      : 4;
+	u64 rsvd_59_19 : 41;
+	u64 apad       : 3;
+	u64 size       : 16;
+#else
+	u64 size       : 16;
+	u64 apad       : 3;
+	u64 rsvd_59_19 : 41;
+	u64 subdc      : 4;
+#endif
+};
+
 struct nix_send_comp_s {
 #if defined(__BIG_ENDIAN_BITFIELD)	/* W0 */
 	u64 rsvd_24_63  : 40;
@@ -334,6 +358,19 @@ struct nix_sqe_ext_s {
 #endif
 };
 
+/* NIX send immediate subdescriptor, packet data follows it */
+struct nix_sqe_imm_s {
+#if defined(__BIG_ENDIAN_BITFIELD)  /* W0 */
+	u64 subdc	: 4;
+	u64 rsvd_59_16	: 44;
+	u64 size	: 16;
+#else
+	u64 size	: 16;
+	u64 rsvd_59_16	: 44;
+	u64 subdc	: 4;
+#endif
+};
+
 struct nix_sqe_sg_s {
 #if defined(__BIG_ENDIAN_BITFIELD)  /* W0 */
 	u64 subdc	: 4;
@@ -360,4 +397,46 @@ struct nix_sqe_sg_s {
 #endif
 };
 
+/* NIX send jump subdescriptor structure */
+struct nix_sqe_jump_s {
+#if defined(__BIG_ENDIAN_BITFIELD)  /* W0 */
+	u64 subdc	: 4;
+	u64 rsvd_59	: 1;
+	u64 f		: 1;
+	u64 rsvd_57	: 1;
+	u64 ld_type	: 2;
+	u64 rsvd_54_7	: 48;
+	u64 sizem1	: 7;
+#else
+	u64 sizem1	: 7;
+	u64 rsvd_54_7	: 48;
+	u64 ld_type	: 2;
+	u64 rsvd_57	: 1;
+	u64 f		: 1;
+	u64 rsvd_59	: 1;
+	u64 subdc	: 4;
+#endif
+	u64 addr; /* W1 */
+};
+
+/* NIX send memory subdescriptor structure */
+struct nix_sqe_mem_s {
+#if defined(__BIG_ENDIAN_BITFIELD)  /* W0 */
+	u64 subdc	: 4;
+	u64 alg		: 4;
+	u64 dsz		: 2;
+	u64 wmem	: 1;
+	u64 rsvd_52_16	: 37;
+	u64 offset	: 16;
+#else
+	u64 offset	: 16;
+	u64 rsvd_52_16	: 37;
+	u64 wmem	: 1;
+	u64 dsz		: 2;
+	u64 alg		: 4;
+	u64 subdc	: 4;
+#endif
+	u64 addr; /* W1 */
+};
+
 #endif /* OTX2_STRUCT_H */
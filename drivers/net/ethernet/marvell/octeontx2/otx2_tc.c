@@ -0,0 +1,766 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Marvell OcteonTx2 RVU Ethernet driver
+ *
+ * Copyright (C) 2018 Marvell International Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/netdevice.h>
+#include <linux/etherdevice.h>
+#include <linux/pci.h>
+#include <net/pkt_cls.h>
+#include <net/tc_act/tc_gact.h>
+#include <net/tc_act/tc_mirred.h>
+#include <net/tc_act/tc_skbedit.h>
+#include <net/tc_act/tc_vlan.h>
+
+#include "otx2_common.h"
+
+/* NIX_AF_LF()_RX_VTAG_TYPE() used by 'vlan pop' rules, configured
+ * to strip the tag without capturing it. Type 0 is VLAN Rx offload.
+ */
+#define OTX2_TC_VTAG_TYPE_POP	1
+
+static int otx2_tc_vtag_pop_cfg(struct otx2_nic *nic)
+{
+	struct nix_vtag_config *req;
+	int err;
+
+	mutex_lock(&nic->mbox.lock);
+	req = otx2_mbox_alloc_msg_NIX_VTAG_CFG(&nic->mbox);
+	if (!req) {
+		mutex_unlock(&nic->mbox.lock);
+		return -ENOMEM;
+	}
+
+	req->cfg_type = 1; /* Rx vtag config */
+	req->vtag_size = VTAGSIZE_T4;
+	req->rx.vtag_type = OTX2_TC_VTAG_TYPE_POP;
+	req->rx.strip_vtag = 1;
+	req->rx.capture_vtag = 0;
+
+	err = otx2_sync_mbox_msg(&nic->mbox);
+	mutex_unlock(&nic->mbox.lock);
+	return err;
+}
+
+/* Find PF_FUNC of the VF whose netdev is 'dev', VFs can be
+ * a redirect target of their PF's rules only.
+ */
+static int otx2_tc_get_vf_func(struct otx2_nic *nic, struct net_device *dev,
+			       u16 *pcifunc)
+{
+	struct pci_dev *pdev;
+	int vf;
+
+	if (nic->pcifunc & RVU_PFVF_FUNC_MASK)
+		return -EOPNOTSUPP;
+
+	if (!dev->dev.parent || !dev_is_pci(dev->dev.parent))
+		return -EOPNOTSUPP;
+
+	pdev = to_pci_dev(dev->dev.parent);
+	if (!pdev->is_virtfn || pci_physfn(pdev) != nic->pdev)
+		return -EOPNOTSUPP;
+
+	for (vf = 0; vf < pci_num_vf(nic->pdev); vf++) {
+		if (pci_iov_virtfn_bus(nic->pdev, vf) == pdev->bus->number &&
+		    pci_iov_virtfn_devfn(nic->pdev, vf) == pdev->devfn) {
+			*pcifunc = nic->pcifunc | ((vf + 1) & RVU_PFVF_FUNC_MASK);
+			return 0;
+		}
+	}
+	return -EOPNOTSUPP;
+}
+
+static int otx2_tc_parse_actions(struct otx2_nic *nic,
+				 struct tc_cls_flower_offload *f,
+				 struct otx2_tc_flow *flow)
+{
+	struct mcam_entry *entry = &flow->entry_data;
+	struct nix_rx_action action;
+	const struct tc_action *a;
+	bool fwd = false;
+	u16 pcifunc;
+	LIST_HEAD(actions);
+	u32 mark;
+	int err;
+
+	if (!tcf_exts_has_actions(f->exts))
+		return -EINVAL;
+
+	*(u64 *)&action = 0x00;
+	action.op = NIX_RX_ACTIONOP_UCAST;
+	action.pf_func = nic->pcifunc;
+
+	tcf_exts_to_list(f->exts, &actions);
+	list_for_each_entry(a, &actions, list) {
+		if (is_tcf_gact_shot(a)) {
+			if (fwd)
+				return -EOPNOTSUPP;
+			action.op = NIX_RX_ACTIONOP_DROP;
+			fwd = true;
+		} else if (is_tcf_mirred_egress_redirect(a)) {
+			if (fwd)
+				return -EOPNOTSUPP;
+			err = otx2_tc_get_vf_func(nic, tcf_mirred_dev(a),
+						  &pcifunc);
+			if (err) {
+				netdev_err(nic->netdev,
+					   "Redirect is supported to own VFs only\n");
+				return err;
+			}
+			action.pf_func = pcifunc;
+			action.index = 0;
+			fwd = true;
+		} else if (is_tcf_skbedit_mark(a)) {
+			mark = tcf_skbedit_mark(a);
+			/* Reported as match id in CQE, which is 16bit */
+			if (!mark || mark > U16_MAX)
+				return -EOPNOTSUPP;
+			action.match_id = mark;
+		} else if (is_tcf_vlan(a)) {
+			/* Ingress pipeline can only strip tags */
+			if (tcf_vlan_action(a) != TCA_VLAN_ACT_POP)
+				return -EOPNOTSUPP;
+			flow->vlan_pop = true;
+			entry->vtag_action =
+				NPC_RX_VTAG0_VALID |
+				NPC_RX_VTAG0_TYPE(OTX2_TC_VTAG_TYPE_POP) |
+				NPC_RX_VTAG0_LID(NPC_LID_LB);
+		} else {
+			return -EOPNOTSUPP;
+		}
+	}
+
+	entry->action = *(u64 *)&action;
+	return 0;
+}
+
+static int otx2_tc_set_ip_proto(struct otx2_nic *nic,
+				struct mcam_entry *entry, u8 ip_proto)
+{
+	int ltype;
+
+	switch (ip_proto) {
+	case IPPROTO_TCP:
+		ltype = NPC_LT_LD_TCP;
+		break;
+	case IPPROTO_UDP:
+		ltype = NPC_LT_LD_UDP;
+		break;
+	case IPPROTO_SCTP:
+		ltype = NPC_LT_LD_SCTP;
+		break;
+	case IPPROTO_ICMP:
+		ltype = NPC_LT_LD_ICMP;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+	return otx2_mcam_set_ltype(nic, entry, NPC_LID_LD, ltype);
+}
+
+#define OTX2_TC_KEYS (BIT(FLOW_DISSECTOR_KEY_CONTROL) |		\
+		      BIT(FLOW_DISSECTOR_KEY_BASIC) |		\
+		      BIT(FLOW_DISSECTOR_KEY_ETH_ADDRS) |	\
+		      BIT(FLOW_DISSECTOR_KEY_VLAN) |		\
+		      BIT(FLOW_DISSECTOR_KEY_IPV4_ADDRS) |	\
+		      BIT(FLOW_DISSECTOR_KEY_PORTS) |		\
+		      BIT(FLOW_DISSECTOR_KEY_IP))
+
+static int otx2_tc_parse_match(struct otx2_nic *nic,
+			       struct tc_cls_flower_offload *f,
+			       struct mcam_entry *entry)
+{
+	struct flow_dissector *dissector = f->dissector;
+	u8 ip_proto = 0, ip_proto_mask = 0;
+	u16 n_proto = 0, n_proto_mask = 0;
+	int sport, dport;
+
+	if (dissector->used_keys & ~OTX2_TC_KEYS) {
+		netdev_err(nic->netdev, "Unsupported flower match keys 0x%x\n",
+			   dissector->used_keys);
+		return -EOPNOTSUPP;
+	}
+
+	otx2_mcam_set_chan(nic, entry);
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_BASIC)) {
+		struct flow_dissector_key_basic *key, *mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_BASIC,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_BASIC,
+						 f->mask);
+		n_proto = ntohs(key->n_proto);
+		n_proto_mask = ntohs(mask->n_proto);
+		ip_proto = key->ip_proto;
+		ip_proto_mask = mask->ip_proto;
+	}
+
+	/* IPv4 and ARP are identified by their layer type, rest by the
+	 * outer ethertype.
+	 */
+	if (n_proto_mask) {
+		if (n_proto_mask != 0xFFFF)
+			return -EOPNOTSUPP;
+		if (n_proto == ETH_P_IP) {
+			if (otx2_mcam_set_ltype(nic, entry, NPC_LID_LC,
+						NPC_LT_LC_IP))
+				return -EOPNOTSUPP;
+		} else if (n_proto == ETH_P_ARP) {
+			if (otx2_mcam_set_ltype(nic, entry, NPC_LID_LC,
+						NPC_LT_LC_ARP))
+				return -EOPNOTSUPP;
+		} else if (otx2_mcam_set_field(nic, entry, OTX2_KF_ETYPE,
+					       n_proto, n_proto_mask)) {
+			return -EOPNOTSUPP;
+		}
+	}
+
+	if (ip_proto_mask) {
+		if (ip_proto_mask != 0xFF || n_proto != ETH_P_IP ||
+		    otx2_tc_set_ip_proto(nic, entry, ip_proto))
+			return -EOPNOTSUPP;
+	}
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_ETH_ADDRS)) {
+		struct flow_dissector_key_eth_addrs *key, *mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_ETH_ADDRS,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_ETH_ADDRS,
+						 f->mask);
+		if (otx2_mcam_set_field(nic, entry, OTX2_KF_DMAC,
+					otx2_mac_to_u64(key->dst),
+					otx2_mac_to_u64(mask->dst)) ||
+		    otx2_mcam_set_field(nic, entry, OTX2_KF_SMAC,
+					otx2_mac_to_u64(key->src),
+					otx2_mac_to_u64(mask->src)))
+			return -EOPNOTSUPP;
+	}
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_VLAN)) {
+		struct flow_dissector_key_vlan *key, *mask;
+		u16 tci, tci_mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_VLAN,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_VLAN,
+						 f->mask);
+		tci = (key->vlan_priority << VLAN_PRIO_SHIFT) |
+		      (key->vlan_id & VLAN_VID_MASK);
+		tci_mask = (mask->vlan_priority << VLAN_PRIO_SHIFT) |
+			   (mask->vlan_id & VLAN_VID_MASK);
+		if (otx2_mcam_set_ltype(nic, entry, NPC_LID_LB,
+					NPC_LT_LB_CTAG) ||
+		    otx2_mcam_set_field(nic, entry, OTX2_KF_VLAN_TCI,
+					tci, tci_mask))
+			return -EOPNOTSUPP;
+	}
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_IPV4_ADDRS)) {
+		struct flow_dissector_key_ipv4_addrs *key, *mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_IPV4_ADDRS,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_IPV4_ADDRS,
+						 f->mask);
+		if (otx2_mcam_set_field(nic, entry, OTX2_KF_SIP4,
+					ntohl(key->src), ntohl(mask->src)) ||
+		    otx2_mcam_set_field(nic, entry, OTX2_KF_DIP4,
+					ntohl(key->dst), ntohl(mask->dst)))
+			return -EOPNOTSUPP;
+	}
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_IP)) {
+		struct flow_dissector_key_ip *key, *mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_IP,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_IP,
+						 f->mask);
+		if (mask->ttl ||
+		    otx2_mcam_set_field(nic, entry, OTX2_KF_TOS,
+					key->tos, mask->tos))
+			return -EOPNOTSUPP;
+	}
+
+	if (dissector_uses_key(dissector, FLOW_DISSECTOR_KEY_PORTS)) {
+		struct flow_dissector_key_ports *key, *mask;
+
+		key = skb_flow_dissector_target(dissector,
+						FLOW_DISSECTOR_KEY_PORTS,
+						f->key);
+		mask = skb_flow_dissector_target(dissector,
+						 FLOW_DISSECTOR_KEY_PORTS,
+						 f->mask);
+		if (ip_proto == IPPROTO_TCP) {
+			sport = OTX2_KF_TCP_SPORT;
+			dport = OTX2_KF_TCP_DPORT;
+		} else if (ip_proto == IPPROTO_UDP) {
+			sport = OTX2_KF_UDP_SPORT;
+			dport = OTX2_KF_UDP_DPORT;
+		} else {
+			return -EOPNOTSUPP;
+		}
+
+		if (otx2_mcam_set_field(nic, entry, sport,
+					ntohs(key->src), ntohs(mask->src)) ||
+		    otx2_mcam_set_field(nic, entry, dport,
+					ntohs(key->dst), ntohs(mask->dst)))
+			return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+/* Pick a MCAM entry that keeps rules ordered by their tc priority.
+ * AF allocates relative to a single reference entry, so place the
+ * rule above the first installed rule of lower priority, else below
+ * the last one of higher or same priority.
+ */
+static void otx2_tc_get_ref_entry(struct otx2_nic *nic,
+				  struct otx2_tc_flow *flow,
+				  struct npc_mcam_alloc_and_write_entry_req *req)
+{
+	struct otx2_tc_flow *iter;
+
+	req->priority = NPC_MCAM_ANY_PRIO;
+	list_for_each_entry(iter, &nic->tc_info.flow_list, list) {
+		if (iter == flow || !iter->installed)
+			continue;
+		if (iter->prio > flow->prio) {
+			req->priority = NPC_MCAM_HIGHER_PRIO;
+			req->ref_entry = iter->entry;
+			return;
+		}
+		req->priority = NPC_MCAM_LOWER_PRIO;
+		req->ref_entry = iter->entry;
+	}
+}
+
+static int otx2_tc_install_flow(struct otx2_nic *nic,
+				struct otx2_tc_flow *flow)
+{
+	struct npc_mcam_alloc_and_write_entry_req *req;
+	struct npc_mcam_alloc_and_write_entry_rsp *rsp;
+	int err;
+
+	if (flow->vlan_pop) {
+		err = otx2_tc_vtag_pop_cfg(nic);
+		if (err)
+			return err;
+	}
+
+	mutex_lock(&nic->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_MCAM_ALLOC_AND_WRITE_ENTRY(&nic->mbox);
+	if (!req) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	req->entry_data = flow->entry_data;
+	req->intf = NIX_INTF_RX;
+	req->enable_entry = 1;
+	req->alloc_cntr = 1;
+	otx2_tc_get_ref_entry(nic, flow, req);
+
+	err = otx2_sync_mbox_msg(&nic->mbox);
+	if (err)
+		goto out;
+
+	rsp = (struct npc_mcam_alloc_and_write_entry_rsp *)
+	       otx2_mbox_get_rsp(&nic->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp)) {
+		err = PTR_ERR(rsp);
+		goto out;
+	}
+	err = rsp->hdr.rc;
+	if (err)
+		goto out;
+
+	flow->entry = rsp->entry;
+	flow->cntr = rsp->cntr;
+	flow->last_pkts = 0;
+	flow->installed = true;
+out:
+	mutex_unlock(&nic->mbox.lock);
+	return err;
+}
+
+static void otx2_tc_uninstall_flow(struct otx2_nic *nic,
+				   struct otx2_tc_flow *flow)
+{
+	struct npc_mcam_free_entry_req *entry_req;
+	struct npc_mcam_oper_counter_req *cntr_req;
+
+	if (!flow->installed || !netif_running(nic->netdev))
+		return;
+
+	mutex_lock(&nic->mbox.lock);
+	entry_req = otx2_mbox_alloc_msg_NPC_MCAM_FREE_ENTRY(&nic->mbox);
+	if (entry_req)
+		entry_req->entry = flow->entry;
+
+	cntr_req = otx2_mbox_alloc_msg_NPC_MCAM_FREE_COUNTER(&nic->mbox);
+	if (cntr_req)
+		cntr_req->cntr = flow->cntr;
+
+	otx2_sync_mbox_msg(&nic->mbox);
+	mutex_unlock(&nic->mbox.lock);
+	flow->installed = false;
+}
+
+static struct otx2_tc_flow *otx2_tc_find_flow(struct otx2_nic *nic,
+					      unsigned long cookie)
+{
+	struct otx2_tc_flow *iter;
+
+	list_for_each_entry(iter, &nic->tc_info.flow_list, list) {
+		if (iter->cookie == cookie)
+			return iter;
+	}
+	return NULL;
+}
+
+static void otx2_tc_add_flow_to_list(struct otx2_nic *nic,
+				     struct otx2_tc_flow *flow)
+{
+	struct list_head *head = &nic->tc_info.flow_list;
+	struct otx2_tc_flow *iter;
+
+	list_for_each_entry(iter, &nic->tc_info.flow_list, list) {
+		if (iter->prio > flow->prio)
+			break;
+		head = &iter->list;
+	}
+	list_add(&flow->list, head);
+}
+
+static int otx2_tc_del_flow(struct otx2_nic *nic,
+			    struct tc_cls_flower_offload *f)
+{
+	struct otx2_tc_flow *flow;
+
+	flow = otx2_tc_find_flow(nic, f->cookie);
+	if (!flow)
+		return -EINVAL;
+
+	otx2_tc_uninstall_flow(nic, flow);
+	list_del(&flow->list);
+	kfree(flow);
+	nic->tc_info.nr_flows--;
+	return 0;
+}
+
+static int otx2_tc_add_flow(struct otx2_nic *nic,
+			    struct tc_cls_flower_offload *f)
+{
+	struct otx2_tc_flow *flow, *old;
+	int err;
+
+	/* Same filter being replaced, old rule stays till new one is in */
+	old = otx2_tc_find_flow(nic, f->cookie);
+	if (!old && nic->tc_info.nr_flows >= OTX2_MAX_TC_FLOWS)
+		return -ENOSPC;
+
+	err = otx2_get_kex_cfg(nic);
+	if (err)
+		return err;
+
+	flow = kzalloc(sizeof(*flow), GFP_KERNEL);
+	if (!flow)
+		return -ENOMEM;
+
+	flow->cookie = f->cookie;
+	flow->prio = f->common.prio >> 16;
+
+	err = otx2_tc_parse_match(nic, f, &flow->entry_data);
+	if (err)
+		goto free_flow;
+
+	err = otx2_tc_parse_actions(nic, f, flow);
+	if (err)
+		goto free_flow;
+
+	/* With interface down, rule is installed on next open */
+	if (netif_running(nic->netdev)) {
+		err = otx2_tc_install_flow(nic, flow);
+		if (err)
+			goto free_flow;
+	}
+
+	if (old)
+		otx2_tc_del_flow(nic, f);
+	otx2_tc_add_flow_to_list(nic, flow);
+	nic->tc_info.nr_flows++;
+	return 0;
+
+free_flow:
+	kfree(flow);
+	return err;
+}
+
+/* NPC counts only packets that hit the entry */
+static int otx2_tc_get_flow_stats(struct otx2_nic *nic,
+				  struct tc_cls_flower_offload *f)
+{
+	struct npc_mcam_oper_counter_req *req;
+	struct npc_mcam_oper_counter_rsp *rsp;
+	struct otx2_tc_flow *flow;
+	u64 pkts, stat;
+	int err;
+
+	flow = otx2_tc_find_flow(nic, f->cookie);
+	if (!flow)
+		return -EINVAL;
+
+	if (!flow->installed || !netif_running(nic->netdev))
+		return 0;
+
+	mutex_lock(&nic->mbox.lock);
+	req = otx2_mbox_alloc_msg_NPC_MCAM_COUNTER_STATS(&nic->mbox);
+	if (!req) {
+		err = -ENOMEM;
+		goto out;
+	}
+	req->cntr = flow->cntr;
+
+	err = otx2_sync_mbox_msg(&nic->mbox);
+	if (err)
+		goto out;
+
+	rsp = (struct npc_mcam_oper_counter_rsp *)
+	       otx2_mbox_get_rsp(&nic->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp)) {
+		err = PTR_ERR(rsp);
+		goto out;
+	}
+	err = rsp->hdr.rc;
+	if (err)
+		goto out;
+	stat = rsp->stat;
+	mutex_unlock(&nic->mbox.lock);
+
+	pkts = stat - flow->last_pkts;
+	if (pkts) {
+		flow->last_pkts = stat;
+		flow->lastused = jiffies;
+	}
+	tcf_exts_stats_update(f->exts, 0, pkts, flow->lastused);
+	return 0;
+out:
+	mutex_unlock(&nic->mbox.lock);
+	return err;
+}
+
+static int otx2_setup_tc_cls_flower(struct otx2_nic *nic,
+				    struct tc_cls_flower_offload *f)
+{
+	switch (f->command) {
+	case TC_CLSFLOWER_REPLACE:
+		return otx2_tc_add_flow(nic, f);
+	case TC_CLSFLOWER_DESTROY:
+		return otx2_tc_del_flow(nic, f);
+	case TC_CLSFLOWER_STATS:
+		return otx2_tc_get_flow_stats(nic, f);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int otx2_setup_tc_block_cb(enum tc_setup_type type,
+				  void *type_data, void *cb_priv)
+{
+	struct otx2_nic *nic = cb_priv;
+
+	if (!tc_cls_can_offload_and_chain0(nic->netdev, type_data))
+		return -EOPNOTSUPP;
+
+	switch (type) {
+	case TC_SETUP_CLSFLOWER:
+		return otx2_setup_tc_cls_flower(nic, type_data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int otx2_setup_tc_block(struct net_device *netdev,
+			       struct tc_block_offload *f)
+{
+	struct otx2_nic *nic = netdev_priv(netdev);
+
+	if (f->binder_type != TCF_BLOCK_BINDER_TYPE_CLSACT_INGRESS)
+		return -EOPNOTSUPP;
+
+	switch (f->command) {
+	case TC_BLOCK_BIND:
+		return tcf_block_cb_register(f->block, otx2_setup_tc_block_cb,
+					     nic, nic);
+	case TC_BLOCK_UNBIND:
+		tcf_block_cb_unregister(f->block, otx2_setup_tc_block_cb, nic);
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/* mqprio rates are in bytes per second */
+static int otx2_mqprio_get_rate(u64 rate, u32 *mbps)
+{
+	if (!rate) {
+		*mbps = 0;
+		return 0;
+	}
+
+	rate = div_u64(rate * 8, 1000000);
+	if (rate < OTX2_MIN_TX_RATE || rate > OTX2_MAX_TX_RATE)
+		return -EINVAL;
+	*mbps = rate;
+	return 0;
+}
+
+static int otx2_mqprio_validate(struct otx2_nic *nic,
+				struct tc_mqprio_qopt_offload *mqprio,
+				u32 *min_rate, u32 *max_rate)
+{
+	struct tc_mqprio_qopt *qopt = &mqprio->qopt;
+	int tc, i, err;
+	u16 start, end;
+
+	for (tc = 0; tc < qopt->num_tc; tc++) {
+		start = qopt->offset[tc];
+		end = start + qopt->count[tc];
+		if (!qopt->count[tc] || end > nic->hw.tx_queues)
+			return -EINVAL;
+
+		/* Each queue can belong to one traffic class only */
+		for (i = 0; i < tc; i++) {
+			if (start < qopt->offset[i] + qopt->count[i] &&
+			    qopt->offset[i] < end)
+				return -EINVAL;
+		}
+	}
+
+	if (!(mqprio->flags & TC_MQPRIO_F_SHAPER) ||
+	    mqprio->shaper != TC_MQPRIO_SHAPER_BW_RATE)
+		return 0;
+
+	for (tc = 0; tc < qopt->num_tc; tc++) {
+		if (mqprio->flags & TC_MQPRIO_F_MIN_RATE) {
+			err = otx2_mqprio_get_rate(mqprio->min_rate[tc],
+						   &min_rate[tc]);
+			if (err)
+				return err;
+		}
+		if (mqprio->flags & TC_MQPRIO_F_MAX_RATE) {
+			err = otx2_mqprio_get_rate(mqprio->max_rate[tc],
+						   &max_rate[tc]);
+			if (err)
+				return err;
+		}
+		if (max_rate[tc] && min_rate[tc] > max_rate[tc])
+			return -EINVAL;
+	}
+	return 0;
+}
+
+/* Each traffic class is given its own TL4 and SMQ, shaped by CIR
+ * and PIR as per the class's min and max rate. Scheduler tree is
+ * rebuilt on open, so reinit the interface if it's running.
+ */
+static int otx2_setup_tc_mqprio(struct net_device *netdev,
+				struct tc_mqprio_qopt_offload *mqprio)
+{
+	struct otx2_nic *nic = netdev_priv(netdev);
+	struct tc_mqprio_qopt *qopt = &mqprio->qopt;
+	u32 min_rate[TC_MAX_QUEUE] = { 0 };
+	u32 max_rate[TC_MAX_QUEUE] = { 0 };
+	bool if_up = netif_running(netdev);
+	int tc, err;
+
+	if (qopt->num_tc > TC_MAX_QUEUE)
+		return -EINVAL;
+
+	err = otx2_mqprio_validate(nic, mqprio, min_rate, max_rate);
+	if (err) {
+		netdev_err(netdev, "Invalid mqprio queue mapping or rates\n");
+		return err;
+	}
+
+	if (if_up)
+		otx2_stop(netdev);
+
+	if (!qopt->num_tc) {
+		netdev_reset_tc(netdev);
+	} else {
+		netdev_set_num_tc(netdev, qopt->num_tc);
+		for (tc = 0; tc < qopt->num_tc; tc++)
+			netdev_set_tc_queue(netdev, tc, qopt->count[tc],
+					    qopt->offset[tc]);
+	}
+	memcpy(nic->hw.tc_min_rate, min_rate, sizeof(min_rate));
+	memcpy(nic->hw.tc_max_rate, max_rate, sizeof(max_rate));
+	qopt->hw = TC_MQPRIO_HW_OFFLOAD_TCS;
+
+	if (if_up)
+		return otx2_open(netdev);
+	return 0;
+}
+
+int otx2_setup_tc(struct net_device *netdev, enum tc_setup_type type,
+		  void *type_data)
+{
+	switch (type) {
+	case TC_SETUP_BLOCK:
+		return otx2_setup_tc_block(netdev, type_data);
+	case TC_SETUP_QDISC_MQPRIO:
+		return otx2_setup_tc_mqprio(netdev, type_data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+EXPORT_SYMBOL(otx2_setup_tc);
+
+/* MCAM entries and counters are freed by AF along with NIX LF,
+ * reinstall offloaded rules on open, in order of their priority.
+ */
+int otx2_tc_restore_flows(struct otx2_nic *nic)
+{
+	struct otx2_tc_flow *flow;
+	int err, ret = 0;
+
+	list_for_each_entry(flow, &nic->tc_info.flow_list, list)
+		flow->installed = false;
+
+	list_for_each_entry(flow, &nic->tc_info.flow_list, list) {
+		err = otx2_tc_install_flow(nic, flow);
+		if (err) {
+			netdev_warn(nic->netdev,
+				    "Failed to restore tc flower rule, prio %d\n",
+				    flow->prio);
+			ret = err;
+		}
+	}
+	return ret;
+}
+
+void otx2_tc_init(struct otx2_nic *nic)
+{
+	INIT_LIST_HEAD(&nic->tc_info.flow_list);
+}
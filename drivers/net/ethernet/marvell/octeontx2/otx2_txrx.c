@@ -9,6 +9,8 @@
  */
 
 #include <linux/etherdevice.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
 #include <net/ip.h>
 
 #include "otx2_reg.h"
@@ -82,6 +84,45 @@ static void otx2_dma_unmap_skb_frags(struct otx2_nic *pfvf, struct sg_list *sg)
 	}
 }
 
+static void otx2_xdp_snd_pkt_handler(struct otx2_nic *pfvf,
+				     struct otx2_cq_queue *cq,
+				     struct sg_list *sg)
+{
+	void *data = (void *)sg->skb;
+
+	/* Frames redirected from other devices are freed back to their
+	 * owner, XDP_TX'ed receive buffers are still DMA mapped and are
+	 * recycled straight to the RQ's aura.
+	 */
+	if (data) {
+		dma_unmap_single_attrs(pfvf->dev, sg->dma_addr[0],
+				       sg->size[0], DMA_TO_DEVICE,
+				       DMA_ATTR_SKIP_CPU_SYNC);
+		page_frag_free(data);
+		sg->skb = (u64)NULL;
+	} else {
+		otx2_aura_freeptr(pfvf, cq->cint_idx, sg->dma_addr[0]);
+	}
+}
+
+/* Report PTP Tx timestamp HW wrote to SQE's slot, slot is left
+ * as is if the packet couldn't be timestamped.
+ */
+static void otx2_snd_tstamp(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
+			    struct sk_buff *skb)
+{
+	struct skb_shared_hwtstamps ts;
+	u64 tstamp;
+
+	tstamp = ((u64 *)sq->timestamps->base)[sq->cons_head];
+	if (tstamp == 1)
+		return;
+
+	memset(&ts, 0, sizeof(ts));
+	ts.hwtstamp = ns_to_ktime(otx2_ptp_tstamp2time(pfvf, tstamp));
+	skb_tstamp_tx(skb, &ts);
+}
+
 static void otx2_snd_pkt_handler(struct otx2_nic *pfvf,
 				 struct otx2_cq_queue *cq, void *cqe,
 				 int budget, int *tx_pkts, int *tx_bytes)
@@ -91,6 +132,7 @@ static void otx2_snd_pkt_handler(struct otx2_nic *pfvf,
 	struct sk_buff *skb = NULL;
 	struct otx2_snd_queue *sq;
 	struct sg_list *sg;
+	u16 end;
 
 	snd_comp = (struct nix_send_comp_s *)(cqe + sizeof(*cqe_hdr));
 	if (snd_comp->status) {
@@ -101,92 +143,363 @@ static void otx2_snd_pkt_handler(struct otx2_nic *pfvf,
 
 	/* Barrier, so that update to sq by other cpus is visible */
 	smp_mb();
-	sq = &pfvf->qset.sq[cq->cint_idx];
-	sg = &sq->sg[snd_comp->sqe_id];
-
-	skb = (struct sk_buff *)sg->skb;
-	if (skb) {
-		*tx_bytes += skb->len;
-		(*tx_pkts)++;
-		otx2_dma_unmap_skb_frags(pfvf, sg);
-		napi_consume_skb(skb, budget);
-		sg->skb = (u64)NULL;
+	sq = &pfvf->qset.sq[cq->cq_idx - pfvf->hw.max_queues];
+
+	if (cq->cq_type == CQ_XDP) {
+		otx2_xdp_snd_pkt_handler(pfvf, cq, &sq->sg[snd_comp->sqe_id]);
+		return;
 	}
+
+	/* Retire all SQEs upto and including the completed one */
+	end = (snd_comp->sqe_id + 1) & (sq->sqe_cnt - 1);
+	do {
+		sg = &sq->sg[sq->cons_head];
+		skb = (struct sk_buff *)sg->skb;
+		if (skb) {
+			*tx_bytes += skb->len;
+			(*tx_pkts)++;
+			otx2_dma_unmap_skb_frags(pfvf, sg);
+			if (skb_shinfo(skb)->tx_flags & SKBTX_IN_PROGRESS)
+				otx2_snd_tstamp(pfvf, sq, skb);
+			napi_consume_skb(skb, budget);
+			sg->skb = (u64)NULL;
+		}
+		sq->cons_head++;
+		sq->cons_head &= (sq->sqe_cnt - 1);
+	} while (sq->cons_head != end);
 }
 
+/* Hash covers L4 ports only if the packet has a L4 header
+ * whose ports are part of the configured flowkey.
+ */
 static inline void otx2_set_rxhash(struct otx2_nic *pfvf,
 				   struct nix_cqe_hdr_s *cqe_hdr,
+				   struct nix_rx_parse_s *parse,
 				   struct sk_buff *skb)
 {
 	enum pkt_hash_types hash_type = PKT_HASH_TYPE_NONE;
 	struct otx2_rss_info *rss;
-	u32 hash = 0;
+	u32 l4_key = 0;
 
 	if (!(pfvf->netdev->features & NETIF_F_RXHASH))
 		return;
 
 	rss = &pfvf->hw.rss_info;
-	if (rss->flowkey_cfg) {
-		if (rss->flowkey_cfg &
-		    ~(FLOW_KEY_TYPE_IPV4 | FLOW_KEY_TYPE_IPV6))
-			hash_type = PKT_HASH_TYPE_L4;
-		else
-			hash_type = PKT_HASH_TYPE_L3;
-		hash = cqe_hdr->flow_tag;
+	if (!rss->flowkey_cfg)
+		return;
+
+	switch (parse->ldtype) {
+	case NPC_LT_LD_TCP:
+		l4_key = FLOW_KEY_TYPE_TCP;
+		break;
+	case NPC_LT_LD_UDP:
+		l4_key = FLOW_KEY_TYPE_UDP;
+		break;
+	case NPC_LT_LD_SCTP:
+		l4_key = FLOW_KEY_TYPE_SCTP;
+		break;
 	}
-	skb_set_hash(skb, hash, hash_type);
+
+	if (rss->flowkey_cfg & l4_key)
+		hash_type = PKT_HASH_TYPE_L4;
+	else if (parse->lctype == NPC_LT_LC_IP ||
+		 parse->lctype == NPC_LT_LC_IP6)
+		hash_type = PKT_HASH_TYPE_L3;
+	else
+		return;
+
+	skb_set_hash(skb, cqe_hdr->flow_tag, hash_type);
 }
 
-static void otx2_skb_add_frag(struct otx2_nic *pfvf,
+/* NIX verifies outer and inner TCP/UDP checksums and packets with bad
+ * ones never get this far. So a checksum is known good if the layer
+ * carrying it is present, tunnelled packets with both outer UDP and
+ * inner TCP/UDP checksums verified get csum_level 1.
+ */
+static inline void otx2_set_rxcsum(struct otx2_nic *pfvf,
+				   struct nix_rx_parse_s *parse,
+				   struct sk_buff *skb)
+{
+	bool outer_l4, inner_l4;
+
+	if (!(pfvf->netdev->features & NETIF_F_RXCSUM))
+		return;
+
+	outer_l4 = parse->ldtype == NPC_LT_LD_TCP ||
+		   parse->ldtype == NPC_LT_LD_UDP;
+	inner_l4 = parse->lgtype == NPC_LT_LG_TU_TCP ||
+		   parse->lgtype == NPC_LT_LG_TU_UDP;
+
+	if (!outer_l4 && !inner_l4)
+		return;
+
+	skb->ip_summed = CHECKSUM_UNNECESSARY;
+	if (outer_l4 && inner_l4)
+		skb->csum_level = 1;
+}
+
+static void otx2_skb_add_frag(struct otx2_nic *pfvf, struct otx2_cq_queue *cq,
 			      struct sk_buff *skb, u64 iova, int len)
 {
 	struct page *page;
 	void *va;
 
-	dma_unmap_page_attrs(pfvf->dev, iova, RCV_FRAG_LEN,
-			     DMA_FROM_DEVICE, DMA_ATTR_SKIP_CPU_SYNC);
-
 	va = phys_to_virt(otx2_iova_to_phys(pfvf->iommu_domain, iova));
-	page = virt_to_page(va);
+	otx2_put_rbuf(pfvf, cq->rbpool, va, iova);
+	page = virt_to_head_page(va);
 	skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags, page,
-			va - page_address(page), len, RCV_FRAG_LEN);
+			va - page_address(page), len, cq->rbpool->rbsize);
+}
+
+/* With PTP Rx timestamping on, CGX prepends the 8 byte timestamp
+ * to packet data in the first buffer. Pick it up and move packet
+ * start past it.
+ */
+static inline u64 otx2_get_rxtstamp(struct otx2_nic *pfvf, u64 iova,
+				    int *offset, int *len)
+{
+	u64 tstamp;
+	void *va;
+
+	va = phys_to_virt(otx2_iova_to_phys(pfvf->iommu_domain, iova));
+	tstamp = be64_to_cpu(*(__be64 *)(va + *offset));
+	*offset += OTX2_HW_TIMESTAMP_LEN;
+	*len -= OTX2_HW_TIMESTAMP_LEN;
+	return tstamp;
 }
 
+/* 'iova' is the buffer pointer handed to NPA, packet data starts
+ * 'offset' bytes after it. OTX2_HEAD_ROOM bytes ahead of the pointer
+ * are reserved as headroom.
+ */
 static inline struct sk_buff *
-otx2_get_rcv_skb(struct otx2_nic *pfvf, u64 iova, int len, int apad)
+otx2_get_rcv_skb(struct otx2_nic *pfvf, struct otx2_cq_queue *cq,
+		 u64 iova, int len, int offset)
 {
 	struct sk_buff *skb;
 	void *va;
 
 	va = phys_to_virt(otx2_iova_to_phys(pfvf->iommu_domain, iova));
-	skb = build_skb(va, RCV_FRAG_LEN);
+	/* Buffer stays mapped, page is recycled once stack frees it */
+	otx2_put_rbuf(pfvf, cq->rbpool, va, iova);
+	skb = build_skb(va - OTX2_HEAD_ROOM, cq->rbpool->rbsize);
 	if (!skb) {
 		put_page(virt_to_page(va));
 		return NULL;
 	}
 
-	skb_reserve(skb, apad);
+	skb_reserve(skb, OTX2_HEAD_ROOM + offset);
 	skb_put(skb, len);
 
-	dma_unmap_page_attrs(pfvf->dev, iova - apad, RCV_FRAG_LEN,
-			     DMA_FROM_DEVICE, DMA_ATTR_SKIP_CPU_SYNC);
 	prefetch(skb->data);
 	return skb;
 }
 
+/* Packet data received into CQE, it follows the NIX_RX_IMM_S
+ * after 'apad' bytes of alignment pad.
+ */
+static struct sk_buff *otx2_get_imm_skb(struct otx2_nic *pfvf,
+					struct otx2_cq_queue *cq,
+					struct nix_rx_imm_s *imm, u64 *tstamp)
+{
+	struct napi_struct *napi = &pfvf->qset.napi[cq->cint_idx].napi;
+	void *data = (void *)imm + sizeof(*imm) + imm->apad;
+	int len = imm->size;
+	struct sk_buff *skb;
+
+	if (pfvf->hw_rx_tstamp) {
+		*tstamp = be64_to_cpu(*(__be64 *)data);
+		data += OTX2_HW_TIMESTAMP_LEN;
+		len -= OTX2_HW_TIMESTAMP_LEN;
+	}
+
+	skb = napi_alloc_skb(napi, len);
+	if (!skb)
+		return NULL;
+
+	skb_put_data(skb, data, len);
+	return skb;
+}
+
+/* Packet is dropped, give buffers holding rest of it back to the aura */
+static void otx2_free_rcv_sgs(struct otx2_nic *pfvf, struct otx2_cq_queue *cq,
+			      void *start, void *end)
+{
+	struct nix_rx_sg_s *sg;
+	u64 *iova;
+	int seg;
+
+	while ((start + sizeof(*sg)) < end) {
+		sg = (struct nix_rx_sg_s *)start;
+		if (sg->subdc != NIX_SUBDC_SG)
+			break;
+
+		iova = (void *)sg + sizeof(*sg);
+		for (seg = 0; seg < sg->segs; seg++)
+			otx2_aura_freeptr(pfvf, cq->cq_idx,
+					  iova[seg] & ~0x07ULL);
+
+		if (sg->segs == 1)
+			start += sizeof(*sg) + sizeof(u64);
+		else
+			start += sizeof(*sg) + (3 * sizeof(u64));
+	}
+}
+
+/* Queue a single segment frame to one of the XDP SQs.
+ * 'data' is the redirected frame to be freed upon completion, it's
+ * NULL for XDP_TX'ed receive buffers which are instead recycled
+ * to the RQ's aura via 'bufptr'.
+ */
+static bool otx2_xdp_sq_append_pkt(struct otx2_nic *pfvf, u16 qidx,
+				   u64 iova, int len, void *data, u64 bufptr)
+{
+	struct otx2_snd_queue *sq = &pfvf->qset.sq[qidx];
+	struct nix_sqe_hdr_s *sqe_hdr;
+	struct nix_sqe_sg_s *sg;
+	struct sg_list *list;
+	int offset;
+	u64 status;
+
+	spin_lock(&sq->xdp_lock);
+
+	/* SQ is being rebuilt, or there is no free SQB */
+	if (!sq->sqe_base || !(sq->num_sqbs - *sq->aura_fc_addr)) {
+		spin_unlock(&sq->xdp_lock);
+		return false;
+	}
+
+	memset(sq->sqe_base, 0, sq->sqe_size);
+	sqe_hdr = (struct nix_sqe_hdr_s *)(sq->sqe_base);
+	sqe_hdr->total = len;
+	/* Don't free Tx buffers to Aura */
+	sqe_hdr->df = 1;
+	sqe_hdr->aura = sq->aura_id;
+	/* Post a CQE Tx after pkt transmission */
+	sqe_hdr->pnc = 1;
+	sqe_hdr->sq = qidx;
+	sqe_hdr->sqe_id = sq->head;
+	offset = sizeof(*sqe_hdr);
+
+	sg = (struct nix_sqe_sg_s *)(sq->sqe_base + offset);
+	sg->ld_type = NIX_SEND_LDTYPE_LDD;
+	sg->subdc = NIX_SUBDC_SG;
+	sg->segs = 1;
+	sg->seg1_size = len;
+	*(u64 *)((void *)sg + sizeof(*sg)) = iova;
+	offset += sizeof(*sg) + sizeof(u64);
+
+	sqe_hdr->sizem1 = (offset / 16) - 1;
+
+	list = &sq->sg[sq->head];
+	list->skb = (u64)data;
+	list->num_segs = data ? 1 : 0;
+	list->dma_addr[0] = data ? iova : bufptr;
+	list->size[0] = len;
+
+	/* Packet data stores should finish before SQE is flushed to HW */
+	dma_wmb();
+
+	do {
+		memcpy(sq->lmt_addr, sqe_hdr, offset);
+		status = otx2_lmt_flush(sq->io_addr);
+	} while (status == 0);
+
+	sq->head++;
+	sq->head &= (sq->sqe_cnt - 1);
+
+	spin_unlock(&sq->xdp_lock);
+	return true;
+}
+
+/* Run the attached XDP program on a single buffer frame.
+ * Returns true if the frame was consumed by XDP, otherwise 'offset'
+ * and 'len' are updated as the program may have moved packet's head
+ * or tail and the frame goes up the stack.
+ */
+static bool otx2_xdp_rcv_pkt_handler(struct otx2_nic *pfvf,
+				     struct bpf_prog *prog,
+				     struct otx2_cq_queue *cq, u64 iova,
+				     int *offset, int *len, u32 *pool_ptrs)
+{
+	struct otx2_rcv_queue *rq = &pfvf->qset.rq[cq->cq_idx];
+	struct otx2_rq_stats *rq_stats;
+	struct xdp_buff xdp;
+	void *va;
+	u16 qidx;
+	u32 act;
+
+	va = phys_to_virt(otx2_iova_to_phys(pfvf->iommu_domain, iova));
+	xdp.data_hard_start = va - OTX2_HEAD_ROOM;
+	xdp.data = va + *offset;
+	xdp_set_data_meta_invalid(&xdp);
+	xdp.data_end = xdp.data + *len;
+	xdp.rxq = &rq->xdp_rxq;
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+
+	switch (act) {
+	case XDP_PASS:
+		*offset = xdp.data - va;
+		*len = xdp.data_end - xdp.data;
+		return false;
+	case XDP_TX:
+		/* Each RQ has a dedicated XDP SQ mapped to the same CINT */
+		qidx = otx2_get_xdp_sq(pfvf, cq->cint_idx);
+		if (otx2_xdp_sq_append_pkt(pfvf, qidx,
+					   iova + (xdp.data - va),
+					   xdp.data_end - xdp.data,
+					   NULL, iova))
+			return true;
+		trace_xdp_exception(pfvf->netdev, prog, act);
+		break;
+	case XDP_REDIRECT:
+		/* Ownership of the buffer moves to the target device */
+		otx2_put_rbuf(pfvf, cq->rbpool, va, iova);
+		(*pool_ptrs)++;
+		if (xdp_do_redirect(pfvf->netdev, &xdp, prog)) {
+			trace_xdp_exception(pfvf->netdev, prog, act);
+			put_page(virt_to_page(va));
+		}
+		return true;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* Fall through */
+	case XDP_ABORTED:
+		trace_xdp_exception(pfvf->netdev, prog, act);
+		/* Fall through */
+	case XDP_DROP:
+		break;
+	}
+
+	/* Buffer is still mapped, just give it back to the RQ's aura */
+	otx2_aura_freeptr(pfvf, cq->cq_idx, iova);
+
+	rq_stats = &pfvf->hw.rq_stats[cq->cq_idx];
+	u64_stats_update_begin(&rq_stats->syncp);
+	rq_stats->drops++;
+	u64_stats_update_end(&rq_stats->syncp);
+	return true;
+}
+
 static void otx2_rcv_pkt_handler(struct otx2_nic *pfvf,
 				 struct otx2_cq_queue *cq, void *cqe,
-				 int *pool_ptrs)
+				 u32 *pool_ptrs)
 {
 	struct nix_cqe_hdr_s *cqe_hdr = (struct nix_cqe_hdr_s *)cqe;
+	struct otx2_rq_stats *rq_stats = &pfvf->hw.rq_stats[cq->cq_idx];
 	struct otx2_qset *qset = &pfvf->qset;
 	struct nix_rx_parse_s *parse;
 	struct sk_buff *skb = NULL;
+	struct bpf_prog *xdp_prog;
+	int seg, len, offset;
+	struct nix_rx_imm_s *imm;
 	struct nix_rx_sg_s *sg;
 	void *start, *end;
-	int seg, len;
+	u64 tstamp = 0;
 	u16 *sg_lens;
 	u64 *iova;
+	u64 bufptr;
 
 	/* CQE_HDR_S for a Rx pkt is always followed by RX_PARSE_S */
 	parse = (struct nix_rx_parse_s *)(cqe + sizeof(*cqe_hdr));
@@ -195,16 +508,65 @@ static void otx2_rcv_pkt_handler(struct otx2_nic *pfvf,
 		dev_info(pfvf->dev,
 			 "RQ%d: Error pkt received errlev %x errcode %x\n",
 			 cq->cint_idx, parse->errlev, parse->errcode);
+		u64_stats_update_begin(&rq_stats->syncp);
+		rq_stats->drops++;
+		u64_stats_update_end(&rq_stats->syncp);
 		return;
 	}
 
+	u64_stats_update_begin(&rq_stats->syncp);
+	rq_stats->pkts++;
+	rq_stats->bytes += parse->pkt_lenm1 + 1;
+	u64_stats_update_end(&rq_stats->syncp);
+
 	start = cqe + sizeof(*cqe_hdr) + sizeof(*parse);
 	end = start + ((parse->desc_sizem1 + 1) * 16);
 
+	/* XDP is run only on frames which fit in a single buffer i.e
+	 * a single NIX_RX_SG_S with one segment.
+	 */
+	rcu_read_lock();
+	xdp_prog = READ_ONCE(pfvf->xdp_prog);
+	sg = (struct nix_rx_sg_s *)start;
+	if (xdp_prog && !parse->desc_sizem1 &&
+	    sg->subdc == NIX_SUBDC_SG && sg->segs == 1) {
+		iova = (void *)sg + sizeof(*sg);
+		len = sg->seg1_size;
+		offset = *iova & 0x07;
+		if (pfvf->hw_rx_tstamp)
+			tstamp = otx2_get_rxtstamp(pfvf, *iova & ~0x07ULL,
+						   &offset, &len);
+		if (otx2_xdp_rcv_pkt_handler(pfvf, xdp_prog, cq,
+					     *iova & ~0x07ULL, &offset,
+					     &len, pool_ptrs)) {
+			rcu_read_unlock();
+			return;
+		}
+		rcu_read_unlock();
+		skb = otx2_get_rcv_skb(pfvf, cq, *iova & ~0x07ULL,
+				       len, offset);
+		(*pool_ptrs)++;
+		goto skb_done;
+	}
+	rcu_read_unlock();
+
+	/* Small packets or start of bigger ones are in the CQE itself */
+	imm = (struct nix_rx_imm_s *)start;
+	if (imm->subdc == NIX_SUBDC_IMM) {
+		skb = otx2_get_imm_skb(pfvf, cq, imm, &tstamp);
+		start += ALIGN(sizeof(*imm) + imm->apad + imm->size, 16);
+		if (!skb) {
+			otx2_free_rcv_sgs(pfvf, cq, start, end);
+			u64_stats_update_begin(&rq_stats->syncp);
+			rq_stats->drops++;
+			u64_stats_update_end(&rq_stats->syncp);
+			return;
+		}
+	}
+
 	/* Run through the each NIX_RX_SG_S subdc and frame the skb */
 	while ((start + sizeof(*sg)) < end) {
 		sg = (struct nix_rx_sg_s *)start;
-		/* For a 128byte size CQE, NIX_RX_IMM_S is never expected */
 		if (sg->subdc != NIX_SUBDC_SG) {
 			dev_err(pfvf->dev, "RQ%d: Unexpected SUBDC %d\n",
 				cq->cq_idx, sg->subdc);
@@ -225,11 +587,18 @@ static void otx2_rcv_pkt_handler(struct otx2_nic *pfvf,
 			/* Starting IOVA's 2:0 bits give alignment
 			 * bytes after which packet data starts.
 			 */
-			if (!skb)
-				skb = otx2_get_rcv_skb(pfvf, *iova,
-						       len, *iova & 0x07);
-			else
-				otx2_skb_add_frag(pfvf, skb, *iova, len);
+			if (!skb) {
+				bufptr = *iova & ~0x07ULL;
+				offset = *iova & 0x07;
+				if (pfvf->hw_rx_tstamp)
+					tstamp = otx2_get_rxtstamp(pfvf, bufptr,
+								   &offset,
+								   &len);
+				skb = otx2_get_rcv_skb(pfvf, cq, bufptr,
+						       len, offset);
+			} else {
+				otx2_skb_add_frag(pfvf, cq, skb, *iova, len);
+			}
 			iova++;
 			(*pool_ptrs)++;
 		}
@@ -244,15 +613,42 @@ static void otx2_rcv_pkt_handler(struct otx2_nic *pfvf,
 			start += sizeof(*sg) + (3 * sizeof(u64));
 	}
 
+skb_done:
 	if (!skb)
 		return;
 
-	otx2_set_rxhash(pfvf, cqe_hdr, skb);
+	otx2_set_rxhash(pfvf, cqe_hdr, parse, skb);
+	otx2_set_rxcsum(pfvf, parse, skb);
+
+	if (tstamp)
+		skb_hwtstamps(skb)->hwtstamp =
+			ns_to_ktime(otx2_ptp_tstamp2time(pfvf, tstamp));
+
+	/* Outer VLAN tag stripped by HW, it's captured from layer LB
+	 * unless stripped by a tc 'vlan pop' rule.
+	 */
+	if (parse->vtag0_gone && parse->vtag0_valid) {
+		if (parse->lbtype == NPC_LT_LB_STAG ||
+		    parse->lbtype == NPC_LT_LB_QINQ)
+			__vlan_hwaccel_put_tag(skb, htons(ETH_P_8021AD),
+					       parse->vtag0_tci);
+		else
+			__vlan_hwaccel_put_tag(skb, htons(ETH_P_8021Q),
+					       parse->vtag0_tci);
+	}
+
+	/* Mark set by a tc flower rule */
+	if (parse->match_id)
+		skb->mark = parse->match_id;
 
 	skb_record_rx_queue(skb, cq->cq_idx);
 	skb->protocol = eth_type_trans(skb, pfvf->netdev);
-	if (pfvf->netdev->features & NETIF_F_RXCSUM)
-		skb->ip_summed = CHECKSUM_UNNECESSARY;
+
+	if (skb->pkt_type == PACKET_MULTICAST) {
+		u64_stats_update_begin(&rq_stats->syncp);
+		rq_stats->mcast++;
+		u64_stats_update_end(&rq_stats->syncp);
+	}
 
 	if (pfvf->netdev->features & NETIF_F_GRO)
 		napi_gro_receive(&qset->napi[cq->cint_idx].napi, skb);
@@ -262,17 +658,53 @@ static void otx2_rcv_pkt_handler(struct otx2_nic *pfvf,
 
 #define CQE_ADDR(CQ, idx) ((CQ)->cqe_base + ((CQ)->cqe_size * (idx)))
 
+/* Refill consumed buffers in batches, so that buffer allocation isn't
+ * interleaved with frees to NPA and the frees go out back to back.
+ * Whatever couldn't be allocated is retried in the next poll.
+ */
+static void otx2_refill_pool(struct otx2_nic *pfvf, struct otx2_cq_queue *cq)
+{
+	struct otx2_pool *rbpool = cq->rbpool;
+	s64 bufptrs[OTX2_REFILL_BATCH];
+	struct otx2_rq_stats *rq_stats;
+	int cnt, ptr;
+
+	while (cq->pool_ptrs) {
+		cnt = min_t(u32, cq->pool_ptrs, OTX2_REFILL_BATCH);
+		for (ptr = 0; ptr < cnt; ptr++) {
+			bufptrs[ptr] = otx2_alloc_rbuf(pfvf, rbpool, GFP_ATOMIC);
+			if (bufptrs[ptr] <= 0)
+				break;
+		}
+		/* Page refs must be in place before HW gets the buffers */
+		otx2_get_page(rbpool);
+
+		cnt = ptr;
+		for (ptr = 0; ptr < cnt; ptr++)
+			otx2_aura_freeptr(pfvf, cq->cq_idx,
+					  bufptrs[ptr] + OTX2_HEAD_ROOM);
+		cq->pool_ptrs -= cnt;
+
+		/* Out of memory, defer the rest to next poll */
+		if (cnt < OTX2_REFILL_BATCH && cq->pool_ptrs) {
+			rq_stats = &pfvf->hw.rq_stats[cq->cq_idx];
+			u64_stats_update_begin(&rq_stats->syncp);
+			rq_stats->alloc_fail++;
+			u64_stats_update_end(&rq_stats->syncp);
+			break;
+		}
+	}
+}
+
 int otx2_napi_handler(struct otx2_cq_queue *cq,
 		      struct otx2_nic *pfvf, int budget)
 {
-	struct otx2_pool *rbpool = cq->rbpool;
 	int processed_cqe = 0, workdone = 0;
-	int cq_head, cq_tail, pool_ptrs = 0;
 	struct nix_cqe_hdr_s *cqe_hdr;
 	int tx_pkts = 0, tx_bytes = 0;
 	struct netdev_queue *txq;
+	int cq_head, cq_tail;
 	u64 cq_status;
-	s64 bufptr;
 
 	cq_status = otx2_nix_cq_op_status(pfvf, cq->cq_idx);
 	if (cq_status & BIT_ULL(63)) {
@@ -292,8 +724,12 @@ int otx2_napi_handler(struct otx2_cq_queue *cq,
 	/* Since multiple CQs may be mapped to same CINT,
 	 * check if there are valid CQEs in this CQ.
 	 */
-	if (cq_head == cq_tail)
+	if (cq_head == cq_tail) {
+		/* Refill deferred from previous poll, if any */
+		if (cq->pool_ptrs)
+			otx2_refill_pool(pfvf, cq);
 		return 0;
+	}
 
 	while (cq_head != cq_tail) {
 		if (workdone >= budget)
@@ -307,7 +743,8 @@ int otx2_napi_handler(struct otx2_cq_queue *cq,
 		switch (cqe_hdr->cqe_type) {
 		case NIX_XQE_TYPE_RX:
 			/* Receive packet handler*/
-			otx2_rcv_pkt_handler(pfvf, cq, cqe_hdr, &pool_ptrs);
+			otx2_rcv_pkt_handler(pfvf, cq, cqe_hdr,
+					     &cq->pool_ptrs);
 			workdone++;
 			break;
 		case NIX_XQE_TYPE_SEND:
@@ -320,23 +757,20 @@ int otx2_napi_handler(struct otx2_cq_queue *cq,
 	otx2_write64(pfvf, NIX_LF_CQ_OP_DOOR,
 		     ((u64)cq->cq_idx << 32) | processed_cqe);
 
+	/* Flush frames queued up by XDP_REDIRECT */
+	if (cq->cq_type == CQ_RX && pfvf->xdp_prog)
+		xdp_do_flush_map();
+
 	if (tx_pkts) {
 		txq = netdev_get_tx_queue(pfvf->netdev, cq->cint_idx);
 		netdev_tx_completed_queue(txq, tx_pkts, tx_bytes);
 	}
 
-	if (!pool_ptrs)
-		return 0;
+	if (!cq->pool_ptrs)
+		return workdone;
 
 	/* Refill pool with new buffers */
-	while (pool_ptrs) {
-		bufptr = otx2_alloc_rbuf(pfvf, rbpool);
-		if (bufptr <= 0)
-			break;
-		otx2_aura_freeptr(pfvf, cq->cq_idx, bufptr);
-		pool_ptrs--;
-	}
-	otx2_get_page(rbpool);
+	otx2_refill_pool(pfvf, cq);
 
 	return workdone;
 }
@@ -348,6 +782,7 @@ int otx2_poll(struct napi_struct *napi, int budget)
 	struct otx2_cq_queue *cq;
 	struct otx2_qset *qset;
 	struct otx2_nic *pfvf;
+	bool refill_pending = false;
 
 	cq_poll = container_of(napi, struct otx2_cq_poll, napi);
 	pfvf = (struct otx2_nic *)cq_poll->dev;
@@ -358,12 +793,20 @@ int otx2_poll(struct napi_struct *napi, int budget)
 		if (cq_idx == CINT_INVALID_CQ)
 			continue;
 		cq = &qset->cq[cq_idx];
-		workdone = otx2_napi_handler(cq, pfvf, budget);
+		workdone = max(workdone, otx2_napi_handler(cq, pfvf, budget));
+		if (cq->pool_ptrs)
+			refill_pending = true;
 	}
 
 	/* Clear the IRQ */
 	otx2_write64(pfvf, NIX_LF_CINTX_INT(cq_poll->cint_idx), BIT_ULL(0));
 
+	/* Buffer allocation fell short, stay in polling mode. Otherwise,
+	 * if the aura runs dry, there won't be any Rx interrupt to retry.
+	 */
+	if (refill_pending && !pfvf->intf_down)
+		return budget;
+
 	if (workdone < budget) {
 		/* Exit polling */
 		napi_complete(napi);
@@ -372,6 +815,22 @@ int otx2_poll(struct napi_struct *napi, int budget)
 		if (pfvf->intf_down)
 			return workdone;
 
+		/* Feed Rx rate to net_dim, it schedules 'dim.work'
+		 * if a different moderation profile is to be applied.
+		 */
+		if (pfvf->adaptive_coalesce &&
+		    cq_poll->cq_ids[0] != CINT_INVALID_CQ) {
+			struct otx2_rq_stats *rq_stats;
+			struct net_dim_sample sample;
+
+			/* Stats are updated only by this NAPI instance */
+			rq_stats = &pfvf->hw.rq_stats[cq_poll->cq_ids[0]];
+			cq_poll->event_ctr++;
+			net_dim_sample(cq_poll->event_ctr, rq_stats->pkts,
+				       rq_stats->bytes, &sample);
+			net_dim(&cq_poll->dim, sample);
+		}
+
 		/* Re-enable interrupts */
 		otx2_write64(pfvf, NIX_LF_CINTX_ENA_W1S(cq_poll->cint_idx),
 			     BIT_ULL(0));
@@ -379,10 +838,35 @@ int otx2_poll(struct napi_struct *napi, int budget)
 	return workdone;
 }
 
+void otx2_dim_work(struct work_struct *work)
+{
+	struct net_dim *dim = container_of(work, struct net_dim, work);
+	struct net_dim_cq_moder moder;
+	struct otx2_cq_poll *cq_poll;
+	struct otx2_nic *pfvf;
+	u64 time_wait;
+
+	cq_poll = container_of(dim, struct otx2_cq_poll, dim);
+	pfvf = (struct otx2_nic *)cq_poll->dev;
+	moder = net_dim_get_profile(dim->mode, dim->profile_ix);
+
+	/* TIME_WAIT is in multiples of 100ns and ECOUNT_WAIT is the
+	 * number of CQEs after which interrupt is raised, minus one.
+	 */
+	time_wait = min_t(u64, moder.usec * 10, CQ_TIMER_THRESH_MAX);
+	otx2_write64(pfvf, NIX_LF_CINTX_WAIT(cq_poll->cint_idx),
+		     (time_wait << 48) | (moder.pkts ? moder.pkts - 1 : 0));
+
+	dim->state = NET_DIM_START_MEASURE;
+}
+
 #define MAX_SEGS_PER_SG	3
-/* Add SQE scatter/gather subdescriptor structure */
+/* Add SQE scatter/gather subdescriptor structure at 'base' + 'offset',
+ * 'base' is either the SQE or it's jump buffer.
+ */
 static bool otx2_sqe_add_sg(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
-			    struct sk_buff *skb, int num_segs, int *offset)
+			    struct sk_buff *skb, int num_segs,
+			    void *base, int *offset)
 {
 	struct nix_sqe_sg_s *sg = NULL;
 	u64 dma_addr, *iova = NULL;
@@ -393,7 +877,7 @@ static bool otx2_sqe_add_sg(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 
 	for (seg = 0; seg < num_segs; seg++) {
 		if ((seg % MAX_SEGS_PER_SG) == 0) {
-			sg = (struct nix_sqe_sg_s *)(sq->sqe_base + *offset);
+			sg = (struct nix_sqe_sg_s *)(base + *offset);
 			sg->ld_type = NIX_SEND_LDTYPE_LDD;
 			sg->subdc = NIX_SUBDC_SG;
 			sg->segs = 0;
@@ -425,20 +909,116 @@ static bool otx2_sqe_add_sg(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 	return true;
 }
 
+/* Small linear frames are copied into the SQE, saving a DMA map and
+ * unmap. Such an skb is freed right away, nothing to retire later.
+ */
+static bool otx2_sqe_add_imm(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
+			     struct sk_buff *skb, int *offset)
+{
+	struct nix_sqe_imm_s *imm;
+
+	if (skb->len > pfvf->tx_copybreak || skb_is_nonlinear(skb))
+		return false;
+
+	imm = (struct nix_sqe_imm_s *)(sq->sqe_base + *offset);
+	imm->subdc = NIX_SUBDC_IMM;
+	imm->size = skb->len;
+	memcpy((void *)imm + sizeof(*imm), skb->data, skb->len);
+	/* Next subdc always starts at a 16byte boundary */
+	*offset += ALIGN(sizeof(*imm) + skb->len, 16);
+
+	sq->sg[sq->head].num_segs = 0;
+	sq->sg[sq->head].skb = (u64)NULL;
+	return true;
+}
+
+/* Add SEND_MEM subdescriptor at 'base' + 'offset', HW writes PTP
+ * timestamp of the packet to the SQE's slot once it's sent out.
+ * Slot is preset to 1, which is never a valid timestamp.
+ */
+static void otx2_sqe_add_mem(struct otx2_snd_queue *sq, void *base,
+			     int *offset)
+{
+	u64 *tstamp = (u64 *)sq->timestamps->base + sq->head;
+	struct nix_sqe_mem_s *mem;
+
+	*tstamp = 1;
+	mem = (struct nix_sqe_mem_s *)(base + *offset);
+	mem->subdc = NIX_SUBDC_MEM;
+	mem->alg = NIX_SENDMEMALG_SETTSTMP;
+	mem->wmem = 1; /* Wait for the memory write */
+	mem->addr = sq->timestamps->iova + (sq->head * sizeof(u64));
+
+	*offset += sizeof(*mem);
+}
+
+/* SG subdescriptors don't fit in the SQE, add them to the SQE's
+ * jump buffer and a JUMP subdescriptor pointing to it.
+ */
+static bool otx2_sqe_add_jump(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
+			      struct sk_buff *skb, int num_segs, int *offset,
+			      bool tstamp)
+{
+	int jump_off = sq->head * OTX2_SQE_JUMP_SIZE;
+	void *jump_buf = sq->jump->base + jump_off;
+	struct nix_sqe_jump_s *jump;
+	int len = 0;
+
+	memset(jump_buf, 0, OTX2_SQE_JUMP_SIZE);
+	if (!otx2_sqe_add_sg(pfvf, sq, skb, num_segs, jump_buf, &len))
+		return false;
+
+	if (tstamp)
+		otx2_sqe_add_mem(sq, jump_buf, &len);
+
+	jump = (struct nix_sqe_jump_s *)(sq->sqe_base + *offset);
+	jump->subdc = NIX_SUBDC_JUMP;
+	jump->ld_type = NIX_SEND_LDTYPE_LDD;
+	jump->sizem1 = (len / 16) - 1;
+	jump->addr = sq->jump->iova + jump_off;
+
+	*offset += sizeof(*jump);
+	return true;
+}
+
+/* AF sets up a LSO format for each outer and inner IPv4/IPv6
+ * combination, separately for UDP and IP (GRE, IP-in-IP) tunnels.
+ */
+static u8 otx2_tun_lso_format(struct otx2_nic *pfvf, struct sk_buff *skb)
+{
+	int tun = 0;
+
+	if (ip_hdr(skb)->version == 6)
+		tun |= 0x2;
+	if (inner_ip_hdr(skb)->version == 6)
+		tun |= 0x1;
+
+	if (skb_shinfo(skb)->gso_type &
+	    (SKB_GSO_UDP_TUNNEL | SKB_GSO_UDP_TUNNEL_CSUM))
+		return pfvf->hw.lso_udp_tun_idx + tun;
+	return pfvf->hw.lso_ip_tun_idx + tun;
+}
+
 /* Add SQE extended header subdescriptor */
 static void otx2_sqe_add_ext(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 			     struct sk_buff *skb, int *offset)
 {
 	struct nix_sqe_ext_s *ext;
 
-	if (!skb_shinfo(skb)->gso_size)
+	if (!skb_shinfo(skb)->gso_size && !skb_vlan_tag_present(skb))
 		return;
 
 	ext = (struct nix_sqe_ext_s *)(sq->sqe_base + *offset);
 	ext->subdc = NIX_SUBDC_EXT;
-	if (skb_shinfo(skb)->gso_size) {
+	if (skb_shinfo(skb)->gso_size && skb->encapsulation) {
+		ext->lso = 1;
+		ext->lso_format = otx2_tun_lso_format(pfvf, skb);
+		ext->lso_sb = skb_inner_transport_offset(skb) +
+			      inner_tcp_hdrlen(skb);
+		ext->lso_mps = skb_shinfo(skb)->gso_size;
+	} else if (skb_shinfo(skb)->gso_size) {
 		ext->lso = 1;
-		/* Is this TSOv4 or TSOv6, other GSO offloads not supported */
+		/* Is this TSOv4 or TSOv6 */
 		if (skb_shinfo(skb)->gso_type & SKB_GSO_TCPV4)
 			ext->lso_format = pfvf->hw.lso_tsov4_idx;
 		else
@@ -447,9 +1027,58 @@ static void otx2_sqe_add_ext(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 		ext->lso_mps = skb_shinfo(skb)->gso_size;
 	}
 
+	/* Insert VLAN tag right after the MAC addresses. AF sets VLAN0
+	 * and VLAN1 insert TPIDs to 802.1ad and 802.1Q respectively.
+	 * Since insertion happens ahead of LSO, each segment gets the tag.
+	 */
+	if (skb_vlan_tag_present(skb)) {
+		if (skb->vlan_proto == htons(ETH_P_8021AD)) {
+			ext->vlan0_ins_ena = 1;
+			ext->vlan0_ins_ptr = ETH_ALEN * 2;
+			ext->vlan0_ins_tci = skb_vlan_tag_get(skb);
+		} else {
+			ext->vlan1_ins_ena = 1;
+			ext->vlan1_ins_ptr = ETH_ALEN * 2;
+			ext->vlan1_ins_tci = skb_vlan_tag_get(skb);
+		}
+	}
+
 	*offset += sizeof(*ext);
 }
 
+/* Checksum offload of tunneled packets. Inner L3/L4 checksums are
+ * always computed by HW, outer UDP checksum only when each TSO segment
+ * needs one, otherwise stack has already filled it in.
+ */
+static void otx2_sqe_add_tun_hdr(struct nix_sqe_hdr_s *sqe_hdr,
+				 struct sk_buff *skb)
+{
+	sqe_hdr->ol3ptr = skb_network_offset(skb);
+	sqe_hdr->ol4ptr = skb_transport_offset(skb);
+	if (ip_hdr(skb)->version == 4)
+		sqe_hdr->ol3type = NIX_SENDL3TYPE_IP4_CKSUM;
+	else
+		sqe_hdr->ol3type = NIX_SENDL3TYPE_IP6;
+	if (skb_shinfo(skb)->gso_type & SKB_GSO_UDP_TUNNEL_CSUM)
+		sqe_hdr->ol4type = NIX_SENDL4TYPE_UDP_CKSUM;
+
+	sqe_hdr->il3ptr = skb_inner_network_offset(skb);
+	sqe_hdr->il4ptr = skb_inner_transport_offset(skb);
+	if (inner_ip_hdr(skb)->version == 4)
+		sqe_hdr->il3type = NIX_SENDL3TYPE_IP4_CKSUM;
+	else
+		sqe_hdr->il3type = NIX_SENDL3TYPE_IP6;
+
+	/* Inner IPv6 may have extension headers ahead of L4, so tell
+	 * TCP from UDP by where the checksum field is. Checksumming
+	 * starts at the inner L4 header, see otx2_features_check().
+	 */
+	if (skb->csum_offset == offsetof(struct tcphdr, check))
+		sqe_hdr->il4type = NIX_SENDL4TYPE_TCP_CKSUM;
+	else if (skb->csum_offset == offsetof(struct udphdr, check))
+		sqe_hdr->il4type = NIX_SENDL4TYPE_UDP_CKSUM;
+}
+
 /* Add SQE header subdescriptor structure */
 static void otx2_sqe_add_hdr(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 			     struct nix_sqe_hdr_s *sqe_hdr,
@@ -461,12 +1090,15 @@ static void otx2_sqe_add_hdr(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 	/* Don't free Tx buffers to Aura */
 	sqe_hdr->df = 1;
 	sqe_hdr->aura = sq->aura_id;
-	/* Post a CQE Tx after pkt transmission */
-	sqe_hdr->pnc = 1;
 	sqe_hdr->sq = qidx;
 	/* Set SQE identifier which will be used later for freeing SKB */
 	sqe_hdr->sqe_id = sq->head;
 
+	if (skb->ip_summed == CHECKSUM_PARTIAL && skb->encapsulation) {
+		otx2_sqe_add_tun_hdr(sqe_hdr, skb);
+		return;
+	}
+
 	/* Offload TCP/UDP checksum to HW */
 	if (skb->ip_summed == CHECKSUM_PARTIAL) {
 		sqe_hdr->ol3ptr = skb_network_offset(skb);
@@ -489,20 +1121,76 @@ static void otx2_sqe_add_hdr(struct otx2_nic *pfvf, struct otx2_snd_queue *sq,
 	}
 }
 
+/* Check if there is room for new SQE.
+ * 'Num of SQBs freed to SQ's pool - SQ's Aura count' gives free SQB count.
+ * Aura count is updated by HW in memory, so instead of reading it for
+ * every packet, it's reread only once the free SQEs known from last read
+ * are used up.
+ */
+static bool otx2_sq_has_room(struct otx2_snd_queue *sq)
+{
+	s64 free_sqbs;
+
+	if (likely(sq->sqe_avail))
+		return true;
+
+	free_sqbs = sq->num_sqbs - (s64)READ_ONCE(*sq->aura_fc_addr);
+	if (free_sqbs <= 0)
+		return false;
+
+	sq->sqe_avail = free_sqbs * sq->sqe_per_sqb;
+	return true;
+}
+
+/* Flush SQEs staged so far to HW, each one goes out with a LMTST.
+ * Last of them posts a send completion, if not already, so that SQEs
+ * don't wait on further packets to get retired.
+ */
+void otx2_sqe_flush(struct otx2_snd_queue *sq)
+{
+	struct nix_sqe_hdr_s *sqe_hdr;
+	int idx, size;
+	u64 status;
+
+	if (!sq->sqe_pending)
+		return;
+
+	if (sq->comp_pending) {
+		sqe_hdr = sq->sqe_base - sq->sqe_size;
+		sqe_hdr->pnc = 1;
+		sq->comp_pending = 0;
+	}
+
+	/* Packet data stores should finish before SQEs are flushed to HW */
+	dma_wmb();
+
+	for (idx = 0; idx < sq->sqe_pending; idx++) {
+		sqe_hdr = sq->sqe->base + (idx * sq->sqe_size);
+		size = (sqe_hdr->sizem1 + 1) * 16;
+		do {
+			memcpy(sq->lmt_addr, sqe_hdr, size);
+			status = otx2_lmt_flush(sq->io_addr);
+		} while (status == 0);
+	}
+
+	sq->sqe_pending = 0;
+	sq->sqe_base = sq->sqe->base;
+}
+EXPORT_SYMBOL(otx2_sqe_flush);
+
 bool otx2_sq_append_skb(struct net_device *netdev, struct otx2_snd_queue *sq,
 			struct sk_buff *skb, u16 qidx)
 {
 	struct netdev_queue *txq = netdev_get_tx_queue(netdev, qidx);
 	struct otx2_nic *pfvf = netdev_priv(netdev);
+	struct otx2_sq_stats *sq_stats;
+	bool xmit_more = skb->xmit_more;
 	struct nix_sqe_hdr_s *sqe_hdr;
-	int offset, num_segs;
-	u64 status;
+	int offset, num_segs, max_segs;
+	bool mapped, tstamp, imm;
 
-	/* Check if there is room for new SQE.
-	 * 'Num of SQBs freed to SQ's pool - SQ's Aura count'
-	 * will give free SQE count.
-	 */
-	if (!(sq->num_sqbs - *sq->aura_fc_addr))
+	sq_stats = &pfvf->hw.sq_stats[qidx];
+	if (!otx2_sq_has_room(sq))
 		goto fail;
 
 	/* Set SQE's SEND_HDR */
@@ -513,13 +1201,17 @@ bool otx2_sq_append_skb(struct net_device *netdev, struct otx2_snd_queue *sq,
 
 	num_segs = skb_shinfo(skb)->nr_frags + 1;
 
-	/* If SKB doesn't fit in a single SQE, linearize it.
-	 * TODO: Consider adding JUMP descriptor instead.
-	 */
-	if (num_segs > OTX2_MAX_FRAGS_IN_SQE) {
+	/* If SKB doesn't fit even with a jump buffer, linearize it */
+	if (num_segs > OTX2_MAX_FRAGS_IN_JUMP) {
+		u64_stats_update_begin(&sq_stats->syncp);
+		sq_stats->linearized++;
+		u64_stats_update_end(&sq_stats->syncp);
 		if (__skb_linearize(skb)) {
+			u64_stats_update_begin(&sq_stats->syncp);
+			sq_stats->drops++;
+			u64_stats_update_end(&sq_stats->syncp);
 			dev_kfree_skb_any(skb);
-			return true;
+			goto out;
 		}
 		num_segs = skb_shinfo(skb)->nr_frags + 1;
 	}
@@ -527,49 +1219,144 @@ bool otx2_sq_append_skb(struct net_device *netdev, struct otx2_snd_queue *sq,
 	/* Add extended header if needed */
 	otx2_sqe_add_ext(pfvf, sq, skb, &offset);
 
+	/* HW Tx timestamp is taken only for non GSO packets, a SEND_MEM
+	 * after the SG subdescs takes room of one SG in the SQE.
+	 */
+	tstamp = pfvf->hw_tx_tstamp && !skb_shinfo(skb)->gso_size &&
+		 (skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP);
+	max_segs = OTX2_MAX_FRAGS_IN_SQE;
+	if (tstamp)
+		max_segs -= MAX_SEGS_PER_SG;
+
+	imm = !tstamp && otx2_sqe_add_imm(pfvf, sq, skb, &offset);
+
 	/* Add SG subdesc with data frags */
-	if (!otx2_sqe_add_sg(pfvf, sq, skb, num_segs, &offset)) {
+	if (imm) {
+		mapped = true;
+	} else if (num_segs > max_segs) {
+		mapped = otx2_sqe_add_jump(pfvf, sq, skb, num_segs, &offset,
+					   tstamp);
+	} else {
+		mapped = otx2_sqe_add_sg(pfvf, sq, skb, num_segs,
+					 sq->sqe_base, &offset);
+		if (mapped && tstamp)
+			otx2_sqe_add_mem(sq, sq->sqe_base, &offset);
+	}
+	if (!mapped) {
 		otx2_dma_unmap_skb_frags(pfvf, &sq->sg[sq->head]);
+		otx2_sqe_flush(sq);
 		return false;
 	}
 
+	if (tstamp)
+		skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
+	else
+		skb_tx_timestamp(skb);
+
 	sqe_hdr->sizem1 = (offset / 16) - 1;
 
-	netdev_tx_sent_queue(txq, skb->len);
+	u64_stats_update_begin(&sq_stats->syncp);
+	sq_stats->pkts++;
+	sq_stats->bytes += skb->len;
+	u64_stats_update_end(&sq_stats->syncp);
 
-	/* Packet data stores should finish before SQE is flushed to HW */
-	dma_wmb();
+	if (imm) {
+		/* Frame is already copied into the SQE, it neither needs
+		 * a send completion nor is accounted in BQL.
+		 */
+		dev_consume_skb_any(skb);
+	} else {
+		netdev_tx_sent_queue(txq, skb->len);
 
-	do {
-		memcpy(sq->lmt_addr, sqe_hdr, offset);
-		status = otx2_lmt_flush(sq->io_addr);
-	} while (status == 0);
+		/* Post a send completion once every 'comp_interval' SQEs,
+		 * it retires all SQEs queued since the previous one.
+		 */
+		if (++sq->comp_pending >= sq->comp_interval) {
+			sqe_hdr->pnc = 1;
+			sq->comp_pending = 0;
+		}
+	}
 
-	sq->head++;
-	sq->head &= (SQ_QLEN - 1);
+	/* Stage the SQE, it's flushed to HW along with the ones
+	 * that follow, unless stack has no more packets to send.
+	 */
+	sq->sqe_pending++;
+	sq->sqe_base += sq->sqe_size;
+	sq->sqe_avail--;
 
+	sq->head++;
+	sq->head &= (sq->sqe_cnt - 1);
+out:
+	if (!xmit_more || netif_xmit_stopped(txq) ||
+	    sq->sqe_pending == OTX2_SQE_BATCH)
+		otx2_sqe_flush(sq);
 	return true;
 fail:
+	otx2_sqe_flush(sq);
+	u64_stats_update_begin(&sq_stats->syncp);
+	sq_stats->ring_full++;
+	u64_stats_update_end(&sq_stats->syncp);
 	netdev_warn(pfvf->netdev, "SQ%d full, SQB count %d Aura count %lld\n",
 		    qidx, sq->num_sqbs, *sq->aura_fc_addr);
 	return false;
 }
 EXPORT_SYMBOL(otx2_sq_append_skb);
 
+/* ndo_xdp_xmit, frames redirected to this device go out
+ * on the XDP SQ of the current CPU.
+ */
+int otx2_xdp_xmit(struct net_device *netdev, struct xdp_buff *xdp)
+{
+	struct otx2_nic *pfvf = netdev_priv(netdev);
+	int qidx, len, xdp_queues;
+	u64 iova;
+
+	/* XDP SQs may be added or removed along with RQs */
+	xdp_queues = READ_ONCE(pfvf->hw.xdp_queues);
+	if (pfvf->intf_down || !xdp_queues)
+		return -ENETDOWN;
+
+	qidx = otx2_get_xdp_sq(pfvf, smp_processor_id() % xdp_queues);
+
+	len = xdp->data_end - xdp->data;
+	iova = dma_map_single_attrs(pfvf->dev, xdp->data, len, DMA_TO_DEVICE,
+				    DMA_ATTR_SKIP_CPU_SYNC);
+	if (dma_mapping_error(pfvf->dev, iova))
+		return -ENOMEM;
+
+	if (!otx2_xdp_sq_append_pkt(pfvf, qidx, iova, len, xdp->data, 0)) {
+		dma_unmap_single_attrs(pfvf->dev, iova, len, DMA_TO_DEVICE,
+				       DMA_ATTR_SKIP_CPU_SYNC);
+		return -ENOSPC;
+	}
+	return 0;
+}
+EXPORT_SYMBOL(otx2_xdp_xmit);
+
+/* ndo_xdp_flush, SQEs are already handed over to HW via LMTST
+ * in otx2_xdp_xmit(), so there is nothing left to be flushed.
+ */
+void otx2_xdp_flush(struct net_device *netdev)
+{
+}
+EXPORT_SYMBOL(otx2_xdp_flush);
+
 int otx2_rxtx_enable(struct otx2_nic *pfvf, bool enable)
 {
 	struct msg_req *msg;
+	int err = -ENOMEM;
 
 	if (pfvf->tx_chan_base < CGX_CHAN_BASE)
 		return 0;
 
+	mutex_lock(&pfvf->mbox.lock);
 	if (enable)
 		msg = otx2_mbox_alloc_msg_CGX_START_RXTX(&pfvf->mbox);
 	else
 		msg = otx2_mbox_alloc_msg_CGX_STOP_RXTX(&pfvf->mbox);
 
-	if (!msg)
-		return -ENOMEM;
-
-	return otx2_sync_mbox_msg(&pfvf->mbox);
+	if (msg)
+		err = otx2_sync_mbox_msg(&pfvf->mbox);
+	mutex_unlock(&pfvf->mbox.lock);
+	return err;
 }
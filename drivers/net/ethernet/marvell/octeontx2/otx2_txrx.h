@@ -14,6 +14,9 @@
 #include <linux/etherdevice.h>
 #include <linux/iommu.h>
 #include <linux/if_vlan.h>
+#include <linux/net_dim.h>
+#include <linux/u64_stats_sync.h>
+#include <net/xdp.h>
 
 #define LBK_CHAN_BASE	0x000
 #define SDP_CHAN_BASE	0x700
@@ -22,15 +25,60 @@
 #define RQ_QLEN		1024
 #define SQ_QLEN		1024
 #define DMA_BUFFER_LEN	1536 /* In multiples of 128bytes */
-#define RCV_FRAG_LEN	(SKB_DATA_ALIGN(DMA_BUFFER_LEN + NET_SKB_PAD) + \
+/* Headroom reserved ahead of packet data in every receive buffer,
+ * so that XDP programs and the stack can push headers without a copy.
+ * Kept as a multiple of 128 bytes so that pointers handed to NPA
+ * stay aligned.
+ */
+#define OTX2_HEAD_ROOM	XDP_PACKET_HEADROOM
+/* Space taken by a receive buffer holding 'x' bytes of packet data */
+#define RCV_FRAG_LEN(x)	(SKB_DATA_ALIGN(OTX2_HEAD_ROOM + (x)) + \
 			 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
 
+/* Max packet data received into a 512 byte CQE as NIX_RX_IMM_S,
+ * leaving room for a NIX_RX_SG_S pointing to rest of the packet.
+ * It's programmed in units of 16 bytes.
+ */
+#define OTX2_MAX_RX_IMM_SIZE	384
+
 #define	OTX2_ETH_HLEN		(VLAN_ETH_HLEN + VLAN_HLEN)
+/* PTP timestamp CGX prepends to received packets */
+#define OTX2_HW_TIMESTAMP_LEN	8
 #define OTX2_MIN_MTU		ETH_MIN_MTU
-#define OTX2_MAX_MTU		(9212 - OTX2_ETH_HLEN)
+#define OTX2_MAX_MTU		(9212 - OTX2_ETH_HLEN - \
+				 OTX2_HW_TIMESTAMP_LEN)
+/* XDP needs the whole frame in a single receive buffer */
+#define OTX2_MAX_XDP_MTU	(DMA_BUFFER_LEN - OTX2_ETH_HLEN - \
+				 OTX2_HW_TIMESTAMP_LEN)
 
 #define OTX2_MAX_GSO_SEGS	255
+/* Tunnels for which HW has TSO formats, see otx2_tun_lso_format() */
+#define OTX2_GSO_TUNNEL_FEATURES	(NETIF_F_GSO_UDP_TUNNEL |	\
+					 NETIF_F_GSO_UDP_TUNNEL_CSUM |	\
+					 NETIF_F_GSO_GRE |		\
+					 NETIF_F_GSO_IPXIP4 |		\
+					 NETIF_F_GSO_IPXIP6)
 #define OTX2_MAX_FRAGS_IN_SQE	9
+/* SG subdescriptors of skbs with more frags than what fits in a SQE
+ * are put in a per SQE jump buffer, SQE points to it via JUMP subdesc.
+ */
+#define OTX2_MAX_FRAGS_IN_JUMP	(MAX_SKB_FRAGS + 1)
+/* SEND_MEM subdesc asking HW to write PTP Tx timestamp, it follows
+ * the SG subdescs, in the jump buffer if they are put there.
+ */
+#define OTX2_SQE_MEM_SIZE	16
+/* Max frame size copied into a 128 byte SQE as SEND_IMM, after
+ * SEND_HDR, SEND_EXT and SEND_IMM's own 8 bytes.
+ */
+#define OTX2_MAX_TX_IMM_SIZE	88
+#define OTX2_SQE_JUMP_SIZE	\
+	(DIV_ROUND_UP(OTX2_MAX_FRAGS_IN_JUMP, 3) * 32 + OTX2_SQE_MEM_SIZE)
+
+/* Max receive buffers refilled to an aura in one go */
+#define OTX2_REFILL_BATCH	32
+
+/* Max SQEs staged while stack indicates more packets are to follow */
+#define OTX2_SQE_BATCH		16
 
 #define CQ_CQE_THRESH_DEFAULT	0x0ULL /* IRQ triggered when
 					* NIX_LF_CINTX_CNT[QCOUNT]
@@ -39,57 +87,121 @@
 #define CQ_TIMER_THRESH_DEFAULT	0xAULL /* ~1usec i.e (0xA * 100nsec) */
 #define CQ_TIMER_THRESH_MAX     255
 
-struct queue_stats {
-	u64	bytes;
-	u64	pkts;
+/* Per queue SW counters, updated only by the queue's NAPI or xmit
+ * path. Readers take a consistent snapshot via 'syncp'.
+ */
+struct otx2_rq_stats {
+	u64			bytes;
+	u64			pkts;
+	u64			mcast;
+	u64			drops; /* Errored and XDP dropped frames */
+	u64			alloc_fail; /* Buffer refill failures */
+	struct u64_stats_sync	syncp;
+};
+
+struct otx2_sq_stats {
+	u64			bytes;
+	u64			pkts;
+	u64			drops;
+	u64			linearized; /* Skbs with too many frags */
+	u64			ring_full; /* No free SQE */
+	struct u64_stats_sync	syncp;
 };
 
 struct otx2_rcv_queue {
-	struct queue_stats	stats;
+	struct xdp_rxq_info	xdp_rxq;
 };
 
 struct sg_list {
 	u16	num_segs;
 	u64	skb;
-	u64	size[OTX2_MAX_FRAGS_IN_SQE];
-	u64	dma_addr[OTX2_MAX_FRAGS_IN_SQE];
+	u64	size[OTX2_MAX_FRAGS_IN_JUMP];
+	u64	dma_addr[OTX2_MAX_FRAGS_IN_JUMP];
 };
 
 struct otx2_snd_queue {
 	u8			aura_id;
 	u16			head;
+	u16			sqe_cnt;
 	u16			sqe_size;
 	u16			num_sqbs;
+	u16			sqe_per_sqb;
+	u16			sqe_pending; /* Staged in 'sqe' ahead of
+					      * 'sqe_base', yet to be
+					      * flushed to HW.
+					      */
+	u32			sqe_avail; /* Free SQEs as per last read
+					    * of 'aura_fc_addr'.
+					    */
+	u16			cons_head; /* Oldest SQE yet to be retired */
+	u16			comp_interval; /* SQEs per send completion */
+	u16			comp_pending; /* SQEs since last completion
+					       * request.
+					       */
 	u64			 io_addr;
 	u64			*aura_fc_addr;
 	u64			*lmt_addr;
 	void			*sqe_base;
 	struct qmem		*sqe;
+	struct qmem		*jump; /* Jump buffers, one per SQE */
+	struct qmem		*timestamps; /* PTP Tx timestamps, one per
+					      * SQE.
+					      */
 	struct sg_list		*sg;
-	struct queue_stats	stats;
+	/* Serializes XDP_TX and redirects, and also their check of
+	 * 'sqe_base' while the SQ is being rebuilt.
+	 */
+	spinlock_t		xdp_lock;
 };
 
 struct otx2_cq_poll {
 	void			*dev;
 #define CINT_INVALID_CQ		255
-#define MAX_CQS_PER_CNT		2 /* RQ + SQ */
+#define MAX_CQS_PER_CNT		3 /* RQ + SQ + XDP SQ */
 	u8			cint_idx;
 	u8			cq_ids[MAX_CQS_PER_CNT];
+	u16			event_ctr; /* NAPI polls, for net_dim */
 	struct napi_struct	napi;
+	struct net_dim		dim;
+};
+
+/* Pages whose buffers are all handed over to the stack, kept
+ * DMA mapped so that they can be reused once stack frees them.
+ */
+struct otx2_page_cache {
+	u16			head;
+	u16			tail;
+	u16			size; /* Power of 2, zero if disabled */
+	struct page		**pages;
+	dma_addr_t		*iova;
+	u64			hits;
+	u64			misses;
 };
 
 struct otx2_pool {
 	struct qmem		*stack;
 	struct qmem		*fc_addr;
 	u16			rbsize;
+	int			node; /* Buffer pages are allocated from */
+	u8			page_order;
 	u32			page_offset;
 	u16			pageref;
 	struct page		*page;
+	dma_addr_t		page_iova; /* 'page' is mapped as a whole */
+	struct otx2_page_cache	cache;
+};
+
+enum cq_type {
+	CQ_RX,
+	CQ_TX,
+	CQ_XDP,
 };
 
 struct otx2_cq_queue {
 	u8			cq_idx;
 	u8			cint_idx; /* CQ interrupt id */
+	u8			cq_type;
+	u32			pool_ptrs; /* Buffers to be refilled */
 	u16			cqe_cnt;
 	u16			cqe_size;
 	void			*cqe_base;
@@ -120,6 +232,8 @@ static inline u64 otx2_iova_to_phys(void *iommu_domain, dma_addr_t dma_addr)
 }
 
 int otx2_poll(struct napi_struct *napi, int budget);
+void otx2_dim_work(struct work_struct *work);
 bool otx2_sq_append_skb(struct net_device *netdev, struct otx2_snd_queue *sq,
 			struct sk_buff *skb, u16 qidx);
+void otx2_sqe_flush(struct otx2_snd_queue *sq);
 #endif /* OTX2_TXRX_H */
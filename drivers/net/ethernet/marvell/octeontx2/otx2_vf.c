@@ -21,6 +21,7 @@
 
 static const struct pci_device_id otx2_vf_id_table[] = {
 	{ PCI_DEVICE(PCI_VENDOR_ID_CAVIUM, PCI_DEVID_OCTEONTX2_RVU_AFVF) },
+	{ PCI_DEVICE(PCI_VENDOR_ID_CAVIUM, PCI_DEVID_OCTEONTX2_RVU_VF) },
 	{ }
 };
 
@@ -109,8 +110,136 @@ static void otx2vf_vfaf_mbox_handler(struct work_struct *work)
 	otx2_write64(af_mbox->pfvf, RVU_VF_INT, BIT_ULL(0));
 }
 
+static void otx2vf_link_event(struct otx2_nic *vf,
+			      struct cgx_link_user_info *linfo)
+{
+	struct net_device *netdev = vf->netdev;
+
+	pr_info("%s NIC Link is %s\n",
+		netdev->name, linfo->link_up ? "UP" : "DOWN");
+	if (linfo->link_up) {
+		netif_carrier_on(netdev);
+		netif_tx_start_all_queues(netdev);
+	} else {
+		netif_tx_stop_all_queues(netdev);
+		netif_carrier_off(netdev);
+	}
+}
+
+static int otx2vf_mbox_up_handler_CGX_LINK_EVENT(struct otx2_nic *vf,
+						 struct cgx_link_info_msg *msg,
+						 struct msg_rsp *rsp)
+{
+	/* Link events are relayed by PF while this VF's NIX LF is
+	 * around, which may be while interface is going down.
+	 */
+	if (!vf->intf_down)
+		otx2vf_link_event(vf, &msg->link_info);
+	return 0;
+}
+
+static int otx2vf_process_mbox_msg_up(struct otx2_nic *vf,
+				      struct mbox_msghdr *req)
+{
+	/* Check if valid, if not reply with a invalid msg */
+	if (req->sig != OTX2_MBOX_REQ_SIG) {
+		otx2_reply_invalid_msg(&vf->mbox.mbox_up, 0, 0, req->id);
+		return -ENODEV;
+	}
+
+	switch (req->id) {
+#define M(_name, _id, _req_type, _rsp_type)				\
+	case _id: {							\
+		struct _rsp_type *rsp;					\
+		int err;						\
+									\
+		rsp = (struct _rsp_type *)otx2_mbox_alloc_msg(		\
+			&vf->mbox.mbox_up, 0,				\
+			sizeof(struct _rsp_type));			\
+		if (!rsp)						\
+			return -ENOMEM;					\
+									\
+		rsp->hdr.id = _id;					\
+		rsp->hdr.sig = OTX2_MBOX_RSP_SIG;			\
+		rsp->hdr.pcifunc = 0;					\
+		rsp->hdr.rc = 0;					\
+									\
+		err = otx2vf_mbox_up_handler_ ## _name(			\
+			vf, (struct _req_type *)req, rsp);		\
+		return err;						\
+	}
+MBOX_UP_CGX_MESSAGES
+#undef M
+		break;
+	default:
+		otx2_reply_invalid_msg(&vf->mbox.mbox_up, 0, 0, req->id);
+		return -ENODEV;
+	}
+	return 0;
+}
+
 static void otx2vf_vfaf_mbox_up_handler(struct work_struct *work)
 {
+	struct mbox *vf_mbox = container_of(work, struct mbox, mbox_up_wrk);
+	struct otx2_mbox *mbox = &vf_mbox->mbox_up;
+	struct otx2_nic *vf = vf_mbox->pfvf;
+	struct otx2_mbox_dev *mdev = &mbox->dev[0];
+	struct mbox_hdr *rsp_hdr;
+	struct mbox_msghdr *msg;
+	int offset, id;
+	int err;
+
+	rsp_hdr = (struct mbox_hdr *)(mdev->mbase + mbox->rx_start);
+	if (rsp_hdr->num_msgs == 0)
+		return;
+
+	offset = mbox->rx_start + ALIGN(sizeof(*rsp_hdr), MBOX_MSG_ALIGN);
+
+	for (id = 0; id < rsp_hdr->num_msgs; id++) {
+		msg = (struct mbox_msghdr *)(mdev->mbase + offset);
+
+		err = otx2vf_process_mbox_msg_up(vf, msg);
+		if (err) {
+			dev_warn(vf->dev, "Error %d when processing message %s from PF\n",
+				 err, otx2_mbox_id2name(msg->id));
+		}
+		offset = mbox->rx_start + msg->next_msgoff;
+	}
+
+	otx2_mbox_msg_send(mbox, 0);
+}
+
+/* Link events come in only on a change, so query current status */
+static int otx2vf_update_link_status(struct otx2_nic *vf)
+{
+	struct cgx_link_info_msg *rsp;
+	struct msg_req *req;
+	int err;
+
+	mutex_lock(&vf->mbox.lock);
+	req = otx2_mbox_alloc_msg_CGX_GET_LINKINFO(&vf->mbox);
+	if (!req) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	err = otx2_sync_mbox_msg(&vf->mbox);
+	if (err)
+		goto out;
+
+	rsp = (struct cgx_link_info_msg *)
+	       otx2_mbox_get_rsp(&vf->mbox.mbox, 0, &req->hdr);
+	if (IS_ERR(rsp)) {
+		err = PTR_ERR(rsp);
+		goto out;
+	}
+
+	err = rsp->hdr.rc;
+	if (!err)
+		otx2vf_link_event(vf, &rsp->link_info);
+out:
+	mutex_unlock(&vf->mbox.lock);
+	return err;
 }
 
 static irqreturn_t otx2vf_vfaf_mbox_intr_handler(int irq, void *vf_irq)
@@ -228,6 +357,7 @@ static int otx2vf_vfaf_mbox_init(struct otx2_nic *vf)
 	int err;
 
 	mbox->pfvf = vf;
+	mutex_init(&mbox->lock);
 	vf->mbox_wq = alloc_workqueue("otx2_vfaf_mailbox",
 				      WQ_UNBOUND | WQ_HIGHPRI |
 				      WQ_MEM_RECLAIM, 1);
@@ -280,6 +410,10 @@ static int otx2vf_open(struct net_device *netdev)
 		pr_info("%s NIC Link is UP\n", netdev->name);
 		netif_carrier_on(netdev);
 		netif_tx_start_all_queues(netdev);
+	} else if (vf->tx_chan_base >= CGX_CHAN_BASE) {
+		/* VF of a CGX mapped PF, shares PF's link */
+		if (otx2vf_update_link_status(vf))
+			netdev_warn(netdev, "Failed to get link status\n");
 	}
 
 	return 0;
@@ -307,6 +441,14 @@ static netdev_tx_t otx2vf_xmit(struct sk_buff *skb, struct net_device *netdev)
 
 	/* Check for minimum packet length */
 	if (skb->len <= ETH_HLEN) {
+		struct otx2_sq_stats *sq_stats = &vf->hw.sq_stats[qidx];
+
+		/* SQEs staged for earlier packets still need to go out */
+		if (!skb->xmit_more)
+			otx2_sqe_flush(&vf->qset.sq[qidx]);
+		u64_stats_update_begin(&sq_stats->syncp);
+		sq_stats->drops++;
+		u64_stats_update_end(&sq_stats->syncp);
 		dev_kfree_skb(skb);
 		return NETDEV_TX_OK;
 	}
@@ -332,6 +474,21 @@ static netdev_tx_t otx2vf_xmit(struct sk_buff *skb, struct net_device *netdev)
 	return NETDEV_TX_OK;
 }
 
+static int otx2vf_set_features(struct net_device *netdev,
+			       netdev_features_t features)
+{
+	netdev_features_t changed = features ^ netdev->features;
+	struct otx2_nic *vf = netdev_priv(netdev);
+
+	if ((changed & NETIF_F_NTUPLE) && !(features & NETIF_F_NTUPLE))
+		otx2_mcam_flow_del(vf);
+
+	if ((changed & NETIF_F_HW_VLAN_CTAG_RX) && netif_running(netdev))
+		return otx2_enable_rxvlan(vf,
+					  features & NETIF_F_HW_VLAN_CTAG_RX);
+	return 0;
+}
+
 static void otx2vf_reset_task(struct work_struct *work)
 {
 	struct otx2_nic *vf = container_of(work, struct otx2_nic, reset_task);
@@ -350,8 +507,14 @@ static const struct net_device_ops otx2vf_netdev_ops = {
 	.ndo_start_xmit = otx2vf_xmit,
 	.ndo_set_mac_address = otx2_set_mac_address,
 	.ndo_change_mtu = otx2_change_mtu,
+	.ndo_fix_features = otx2_fix_features,
+	.ndo_set_features = otx2vf_set_features,
 	.ndo_get_stats64 = otx2_get_stats64,
 	.ndo_tx_timeout = otx2_tx_timeout,
+	.ndo_set_tx_maxrate = otx2_set_tx_maxrate,
+	.ndo_bpf = otx2_xdp,
+	.ndo_xdp_xmit = otx2_xdp_xmit,
+	.ndo_xdp_flush = otx2_xdp_flush,
 };
 
 static int otx2vf_probe(struct pci_dev *pdev, const struct pci_device_id *id)
@@ -408,7 +571,12 @@ static int otx2vf_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 	hw->rx_queues = qcount;
 	hw->tx_queues = qcount;
 	hw->max_queues = qcount;
-	hw->rqpool_cnt = qcount;
+
+	err = otx2_alloc_queue_stats(vf);
+	if (err)
+		goto err_free_netdev;
+
+	otx2_mcam_flow_init(vf);
 
 	vf->reg_base = pcim_iomap(pdev, PCI_CFG_REG_BAR_NUM, 0);
 	if (!vf->reg_base) {
@@ -437,12 +605,18 @@ static int otx2vf_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 		goto err_detach_rsrc;
 
 	netdev->hw_features = NETIF_F_RXCSUM | NETIF_F_IP_CSUM |
-			      NETIF_F_IPV6_CSUM | NETIF_F_RXHASH;
+			      NETIF_F_IPV6_CSUM | NETIF_F_RXHASH |
+			      NETIF_F_HW_VLAN_CTAG_RX |
+			      NETIF_F_HW_VLAN_STAG_RX |
+			      NETIF_F_HW_VLAN_CTAG_TX |
+			      NETIF_F_HW_VLAN_STAG_TX;
 	netdev->features = netdev->hw_features;
+	netdev->hw_features |= NETIF_F_NTUPLE;
+	netdev->vlan_features = NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM;
 
 	netdev->netdev_ops = &otx2vf_netdev_ops;
 
-	/* MTU range: 68 - 9190 */
+	/* MTU range: 68 - 9182 */
 	netdev->min_mtu = OTX2_MIN_MTU;
 	netdev->max_mtu = OTX2_MAX_MTU;
 
@@ -490,6 +664,7 @@ static void otx2vf_remove(struct pci_dev *pdev)
 
 	vf = netdev_priv(netdev);
 	unregister_netdev(netdev);
+	otx2_mcam_flow_del(vf);
 
 	otx2vf_disable_mbox_intr(vf);
 	otx2_disable_msix(vf);
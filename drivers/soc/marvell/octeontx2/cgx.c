@@ -9,6 +9,7 @@
  */
 
 #include <linux/acpi.h>
+#include <linux/bitfield.h>
 #include <linux/module.h>
 #include <linux/interrupt.h>
 #include <linux/pci.h>
@@ -278,6 +279,219 @@ void cgx_lmac_promisc_config(int cgx_id, int lmac_id, bool enable)
 }
 EXPORT_SYMBOL(cgx_lmac_promisc_config);
 
+/* With PTP mode enabled CGX prepends the 8 byte PTP timestamp
+ * to every received packet, for both GMP and SMU LMACs.
+ */
+void cgx_lmac_ptp_config(void *cgxd, int lmac_id, bool enable)
+{
+	struct cgx *cgx = cgxd;
+	u64 cfg;
+
+	if (!cgx || lmac_id >= cgx->lmac_count)
+		return;
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_GMP_GMI_RXX_FRM_CTL);
+	if (enable)
+		cfg |= CGX_GMP_GMI_RXX_FRM_CTL_PTP_MODE;
+	else
+		cfg &= ~CGX_GMP_GMI_RXX_FRM_CTL_PTP_MODE;
+	cgx_write(cgx, lmac_id, CGXX_GMP_GMI_RXX_FRM_CTL, cfg);
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL);
+	if (enable)
+		cfg |= CGX_SMUX_RX_FRM_CTL_PTP_MODE;
+	else
+		cfg &= ~CGX_SMUX_RX_FRM_CTL_PTP_MODE;
+	cgx_write(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL, cfg);
+}
+EXPORT_SYMBOL(cgx_lmac_ptp_config);
+
+/* Backpressure asserted by NIX on LMAC's channels is converted into
+ * PAUSE or PFC frames only when either is enabled, otherwise CGX is
+ * made to ignore it so that packets get dropped at NIX instead of
+ * stalling LMAC's receive FIFO.
+ */
+static void cgx_lmac_rx_bp_config(struct cgx *cgx, int lmac_id, bool enable)
+{
+	u64 cfg;
+
+	cfg = cgx_read(cgx, 0, CGXX_CMR_RX_OVR_BP);
+	if (enable) {
+		cfg &= ~CGX_CMR_RX_OVR_BP_EN(lmac_id);
+	} else {
+		cfg |= CGX_CMR_RX_OVR_BP_EN(lmac_id);
+		cfg &= ~CGX_CMR_RX_OVR_BP_BP(lmac_id);
+	}
+	cgx_write(cgx, 0, CGXX_CMR_RX_OVR_BP, cfg);
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_TX_CTL);
+	if (enable)
+		cfg |= CGX_SMUX_TX_CTL_L2P_BP_CONV;
+	else
+		cfg &= ~CGX_SMUX_TX_CTL_L2P_BP_CONV;
+	cgx_write(cgx, lmac_id, CGXX_SMUX_TX_CTL, cfg);
+
+	/* Source MAC address put in PAUSE and PFC frames */
+	if (enable)
+		cgx_write(cgx, lmac_id, CGXX_SMUX_SMAC,
+			  cgx_lmac_addr_get(cgx->cgx_id, lmac_id));
+}
+
+/* 802.3x PAUSE, with rx_pause LMAC stops transmitting on receiving
+ * PAUSE frames and with tx_pause sends them when NIX backpressures.
+ * This is exclusive with PFC, hence disables the latter.
+ */
+int cgx_lmac_set_pause_frm(void *cgxd, int lmac_id, bool tx_pause,
+			   bool rx_pause)
+{
+	struct cgx *cgx = cgxd;
+	u64 cfg;
+
+	if (!cgx || lmac_id >= cgx->lmac_count)
+		return -ENODEV;
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL);
+	if (rx_pause)
+		cfg |= CGX_SMUX_RX_FRM_CTL_CTL_BCK;
+	else
+		cfg &= ~CGX_SMUX_RX_FRM_CTL_CTL_BCK;
+	cgx_write(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL, cfg);
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_GMP_GMI_RXX_FRM_CTL);
+	if (rx_pause)
+		cfg |= CGX_GMP_GMI_RXX_FRM_CTL_CTL_BCK;
+	else
+		cfg &= ~CGX_GMP_GMI_RXX_FRM_CTL_CTL_BCK;
+	cgx_write(cgx, lmac_id, CGXX_GMP_GMI_RXX_FRM_CTL, cfg);
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_CBFC_CTL);
+	if (tx_pause || rx_pause) {
+		cfg &= ~(CGX_SMUX_CBFC_CTL_RX_EN | CGX_SMUX_CBFC_CTL_TX_EN |
+			 CGX_SMUX_CBFC_CTL_DRP_EN | CGX_SMUX_CBFC_CTL_BCK_EN |
+			 CGX_SMUX_CBFC_CTL_PHYS_EN);
+		cgx_write(cgx, lmac_id, CGXX_SMUX_CBFC_CTL, cfg);
+	}
+
+	cgx_lmac_rx_bp_config(cgx, lmac_id,
+			      tx_pause || (cfg & CGX_SMUX_CBFC_CTL_TX_EN));
+	return 0;
+}
+EXPORT_SYMBOL(cgx_lmac_set_pause_frm);
+
+int cgx_lmac_get_pause_frm(void *cgxd, int lmac_id, bool *tx_pause,
+			   bool *rx_pause)
+{
+	struct cgx *cgx = cgxd;
+	u8 lmac_type;
+	u64 cfg;
+
+	if (!cgx || lmac_id >= cgx->lmac_count)
+		return -ENODEV;
+
+	/* SGMII/QSGMII LMACs go through GMP, which has no PFC. PAUSE
+	 * frames are sent when NIX backpressure isn't overridden.
+	 */
+	lmac_type = cgx_get_lmac_type(cgx, lmac_id);
+	if (lmac_type == LMAC_MODE_SGMII || lmac_type == LMAC_MODE_QSGMII) {
+		cfg = cgx_read(cgx, lmac_id, CGXX_GMP_GMI_RXX_FRM_CTL);
+		*rx_pause = !!(cfg & CGX_GMP_GMI_RXX_FRM_CTL_CTL_BCK);
+		cfg = cgx_read(cgx, 0, CGXX_CMR_RX_OVR_BP);
+		*tx_pause = !(cfg & CGX_CMR_RX_OVR_BP_EN(lmac_id));
+		return 0;
+	}
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL);
+	*rx_pause = !!(cfg & CGX_SMUX_RX_FRM_CTL_CTL_BCK);
+
+	/* Backpressure is converted to PFC frames if that is enabled */
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_TX_CTL);
+	*tx_pause = !!(cfg & CGX_SMUX_TX_CTL_L2P_BP_CONV);
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_CBFC_CTL);
+	if (cfg & CGX_SMUX_CBFC_CTL_TX_EN)
+		*tx_pause = false;
+	return 0;
+}
+EXPORT_SYMBOL(cgx_lmac_get_pause_frm);
+
+/* PFC, 'pfc_en' is the bitmap of priorities for which PFC frames are
+ * sent on NIX backpressure and received ones are acted upon. Only
+ * LMACs going through SMU i.e not SGMII/QSGMII support this.
+ */
+int cgx_lmac_pfc_config(void *cgxd, int lmac_id, u8 pfc_en)
+{
+	struct cgx *cgx = cgxd;
+	u8 lmac_type;
+	u64 cfg;
+
+	if (!cgx || lmac_id >= cgx->lmac_count)
+		return -ENODEV;
+
+	lmac_type = cgx_get_lmac_type(cgx, lmac_id);
+	if (lmac_type == LMAC_MODE_SGMII || lmac_type == LMAC_MODE_QSGMII)
+		return -EOPNOTSUPP;
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_CBFC_CTL);
+	cfg &= ~(CGX_SMUX_CBFC_CTL_RX_EN | CGX_SMUX_CBFC_CTL_TX_EN |
+		 CGX_SMUX_CBFC_CTL_DRP_EN | CGX_SMUX_CBFC_CTL_BCK_EN |
+		 CGX_SMUX_CBFC_CTL_PHYS_EN);
+	if (pfc_en) {
+		cfg |= CGX_SMUX_CBFC_CTL_RX_EN | CGX_SMUX_CBFC_CTL_TX_EN |
+		       CGX_SMUX_CBFC_CTL_DRP_EN | CGX_SMUX_CBFC_CTL_BCK_EN;
+		cfg |= FIELD_PREP(CGX_SMUX_CBFC_CTL_PHYS_EN, pfc_en);
+
+		/* Link level PAUSE is not acted upon along with PFC */
+		cgx_write(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL,
+			  cgx_read(cgx, lmac_id, CGXX_SMUX_RX_FRM_CTL) &
+			  ~CGX_SMUX_RX_FRM_CTL_CTL_BCK);
+	}
+	cgx_write(cgx, lmac_id, CGXX_SMUX_CBFC_CTL, cfg);
+
+	cgx_lmac_rx_bp_config(cgx, lmac_id, !!pfc_en);
+	return 0;
+}
+EXPORT_SYMBOL(cgx_lmac_pfc_config);
+
+int cgx_lmac_get_pfc(void *cgxd, int lmac_id, u8 *pfc_en)
+{
+	struct cgx *cgx = cgxd;
+	u64 cfg;
+
+	if (!cgx || lmac_id >= cgx->lmac_count)
+		return -ENODEV;
+
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_CBFC_CTL);
+	*pfc_en = 0;
+	if (cfg & CGX_SMUX_CBFC_CTL_TX_EN)
+		*pfc_en = FIELD_GET(CGX_SMUX_CBFC_CTL_PHYS_EN, cfg);
+	return 0;
+}
+EXPORT_SYMBOL(cgx_lmac_get_pfc);
+
+/* PAUSE and PFC frames are sent with the max pause time, and resent
+ * at half that interval for as long as backpressure is asserted.
+ */
+static void cgx_lmac_pause_init(struct cgx *cgx, int lmac_id)
+{
+	u64 cfg;
+
+	cgx_write(cgx, lmac_id, CGXX_SMUX_TX_PAUSE_PKT_TIME, CGX_PAUSE_TIME);
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_TX_PAUSE_PKT_INTERVAL);
+	cfg &= ~0xFFFFULL;
+	cgx_write(cgx, lmac_id, CGXX_SMUX_TX_PAUSE_PKT_INTERVAL,
+		  cfg | (CGX_PAUSE_TIME / 2));
+
+	cgx_write(cgx, lmac_id, CGXX_GMP_GMI_TX_PAUSE_PKT_TIME, CGX_PAUSE_TIME);
+	cfg = cgx_read(cgx, lmac_id, CGXX_GMP_GMI_TX_PAUSE_PKT_INTERVAL);
+	cfg &= ~0xFFFFULL;
+	cgx_write(cgx, lmac_id, CGXX_GMP_GMI_TX_PAUSE_PKT_INTERVAL,
+		  cfg | (CGX_PAUSE_TIME / 2));
+
+	/* Keep NIX backpressure in line with PAUSE/PFC left enabled */
+	cfg = cgx_read(cgx, lmac_id, CGXX_SMUX_TX_CTL);
+	cgx_lmac_rx_bp_config(cgx, lmac_id,
+			      !!(cfg & CGX_SMUX_TX_CTL_L2P_BP_CONV));
+}
+
 int cgx_get_rx_stats(void *cgxd, int lmac_id, int idx, u64 *rx_stat)
 {
 	struct cgx *cgx = cgxd;
@@ -659,6 +873,8 @@ static int cgx_lmac_init(struct cgx *cgx)
 		cgx_write(cgx, lmac->lmac_id, CGXX_CMRX_INT_ENA_W1S,
 			  FW_CGX_INT);
 
+		cgx_lmac_pause_init(cgx, i);
+
 		/* Add reference */
 		cgx->lmac_idmap[i] = lmac;
 	}
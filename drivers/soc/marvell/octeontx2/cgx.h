@@ -38,6 +38,9 @@
 #define CGXX_CMRX_RX_ID_MAP		0x060
 #define CGXX_CMRX_RX_STAT0		0x070
 #define CGXX_CMRX_RX_LMACS		0x128
+#define CGXX_CMR_RX_OVR_BP		0x130
+#define  CGX_CMR_RX_OVR_BP_EN(x)		BIT_ULL((x) + 8)
+#define  CGX_CMR_RX_OVR_BP_BP(x)		BIT_ULL((x) + 4)
 #define CGXX_CMRX_RX_DMAC_CTL0		0x1F8
 #define  CGX_DMAC_CTL0_CAM_ENABLE		BIT_ULL(3)
 #define  CGX_DMAC_CAM_ACCEPT			BIT_ULL(3)
@@ -53,6 +56,25 @@
 #define CGX_CONST			0x2000
 #define CGXX_SPUX_CONTROL1		0x10000
 #define  CGXX_SPUX_CONTROL1_LBK			BIT_ULL(14)
+#define CGXX_SMUX_RX_FRM_CTL		0x20020
+#define  CGX_SMUX_RX_FRM_CTL_CTL_BCK		BIT_ULL(3)
+#define  CGX_SMUX_RX_FRM_CTL_PTP_MODE		BIT_ULL(12)
+#define CGXX_SMUX_SMAC			0x20108
+#define CGXX_SMUX_TX_PAUSE_PKT_TIME	0x20110
+#define CGXX_SMUX_TX_PAUSE_PKT_INTERVAL	0x20120
+#define CGXX_SMUX_TX_CTL		0x20178
+#define  CGX_SMUX_TX_CTL_L2P_BP_CONV		BIT_ULL(7)
+#define CGXX_SMUX_CBFC_CTL		0x20218
+#define  CGX_SMUX_CBFC_CTL_RX_EN		BIT_ULL(0)
+#define  CGX_SMUX_CBFC_CTL_TX_EN		BIT_ULL(1)
+#define  CGX_SMUX_CBFC_CTL_DRP_EN		BIT_ULL(2)
+#define  CGX_SMUX_CBFC_CTL_BCK_EN		BIT_ULL(3)
+#define  CGX_SMUX_CBFC_CTL_PHYS_EN		GENMASK_ULL(47, 32)
+#define CGXX_GMP_GMI_RXX_FRM_CTL	0x38028
+#define  CGX_GMP_GMI_RXX_FRM_CTL_CTL_BCK	BIT_ULL(3)
+#define  CGX_GMP_GMI_RXX_FRM_CTL_PTP_MODE	BIT_ULL(12)
+#define CGXX_GMP_GMI_TX_PAUSE_PKT_TIME	0x38230
+#define CGXX_GMP_GMI_TX_PAUSE_PKT_INTERVAL	0x38248
 #define CGXX_GMP_PCS_MRX_CTL		0x30000
 #define  CGXX_GMP_PCS_MRX_CTL_LBK		BIT_ULL(14)
 
@@ -61,6 +83,8 @@
 #define CGX_CMD_TIMEOUT			2200 /* msecs */
 
 #define CGX_NVEC			37
+#define CGX_PAUSE_TIME			0x7FF /* In 512 bit times */
+#define CGX_PFC_CLASS_CNT		8
 #define CGX_LMAC_FWI			0
 
 enum LMAC_TYPE {
@@ -105,6 +129,13 @@ int cgx_lmac_addr_set(u8 cgx_id, u8 lmac_id, u8 *mac_addr);
 u64 cgx_lmac_addr_get(u8 cgx_id, u8 lmac_id);
 void cgx_lmac_promisc_config(int cgx_id, int lmac_id, bool enable);
 int cgx_lmac_internal_loopback(void *cgxd, int lmac_id, bool enable);
+void cgx_lmac_ptp_config(void *cgxd, int lmac_id, bool enable);
+int cgx_lmac_set_pause_frm(void *cgxd, int lmac_id, bool tx_pause,
+			   bool rx_pause);
+int cgx_lmac_get_pause_frm(void *cgxd, int lmac_id, bool *tx_pause,
+			   bool *rx_pause);
+int cgx_lmac_pfc_config(void *cgxd, int lmac_id, u8 pfc_en);
+int cgx_lmac_get_pfc(void *cgxd, int lmac_id, u8 *pfc_en);
 int cgx_get_link_info(void *cgxd, int lmac_id, struct cgx_link_user_info
 			*linfo);
 #endif /* CGX_H */
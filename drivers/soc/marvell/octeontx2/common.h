@@ -141,12 +141,21 @@ enum nix_scheduler {
 #define NIX_LINK_LBK(a)			(12 + (a))
 #define NIX_CHAN_CGX_LMAC_CHX(a, b, c)	(0x800 + 0x100 * (a) + 0x10 * (b) + (c))
 #define NIX_CHAN_LBK_CHX(a, b)		(0 + 0x100 * (a) + (b))
+#define NIX_CGX_LMAC_CHAN_CNT		16
 
 /* NIX LSO format indices.
  * As of now TSO is the only one using, so statically assigning indices.
  */
 #define NIX_LSO_FORMAT_IDX_TSOV4	0
 #define NIX_LSO_FORMAT_IDX_TSOV6	1
+/* TSO of tunneled packets, one format for each of outer and inner
+ * IPv4/IPv6 combinations i.e base + (outer_v6 << 1 | inner_v6).
+ * UDP tunnels (VXLAN, GENEVE) also update outer UDP length, IP
+ * tunnels (GRE, IP-in-IP) have no outer L4 fields to update.
+ */
+#define NIX_LSO_FORMAT_IDX_UDP_TUN	2
+#define NIX_LSO_FORMAT_IDX_IP_TUN	6
+#define NIX_LSO_TUN_FORMATS		4
 
 /* RSS info */
 #define MAX_RSS_GROUPS			8
@@ -126,6 +126,7 @@ M(DETACH_RESOURCES,	0x003, rsrc_detach, msg_rsp)			\
 M(FREE_RSRC_CNT,	0x004, msg_req, free_rsrcs_rsp)			\
 M(MSIX_OFFSET,		0x005, msg_req, msix_offset_rsp)		\
 M(VF_FLR,		0x006, msg_req, msg_rsp)			\
+M(PTP_OP,		0x007, ptp_req, ptp_rsp)			\
 /* CGX mbox IDs (range 0x200 - 0x3FF) */				\
 M(CGX_START_RXTX,	0x200, msg_req, msg_rsp)			\
 M(CGX_STOP_RXTX,	0x201, msg_req, msg_rsp)			\
@@ -141,6 +142,11 @@ M(CGX_STOP_LINKEVENTS,	0x208, msg_req, msg_rsp)			\
 M(CGX_GET_LINKINFO,	0x209, msg_req, cgx_link_info_msg)		\
 M(CGX_INTLBK_ENABLE,	0x20A, msg_req, msg_rsp)			\
 M(CGX_INTLBK_DISABLE,	0x20B, msg_req, msg_rsp)			\
+M(CGX_PTP_RX_ENABLE,	0x20C, msg_req, msg_rsp)			\
+M(CGX_PTP_RX_DISABLE,	0x20D, msg_req, msg_rsp)			\
+M(CGX_CFG_PAUSE_FRM,	0x20E, cgx_pause_frm_cfg,			\
+				cgx_pause_frm_cfg)			\
+M(CGX_CFG_PFC,		0x20F, cgx_pfc_cfg, cgx_pfc_cfg)		\
 /* NPA mbox IDs (range 0x400 - 0x5FF) */				\
 M(NPA_LF_ALLOC,		0x400, npa_lf_alloc_req, npa_lf_alloc_rsp)	\
 M(NPA_LF_FREE,		0x401, msg_req, msg_rsp)			\
@@ -189,7 +195,11 @@ M(NIX_VTAG_CFG,		0x8008, nix_vtag_config, msg_rsp)		\
 M(NIX_RSS_FLOWKEY_CFG,  0x8009, nix_rss_flowkey_cfg, nix_rss_flowkey_cfg_rsp)\
 M(NIX_SET_MAC_ADDR,	0x800a, nix_set_mac_addr, msg_rsp)		\
 M(NIX_SET_RX_MODE,	0x800b, nix_rx_mode, msg_rsp)			\
-M(NIX_SET_HW_FRS,	0x800c, nix_frs_cfg, msg_rsp)
+M(NIX_SET_HW_FRS,	0x800c, nix_frs_cfg, msg_rsp)			\
+M(NIX_LF_PTP_TX_ENABLE, 0x800d, msg_req, msg_rsp)			\
+M(NIX_LF_PTP_TX_DISABLE, 0x800e, msg_req, msg_rsp)			\
+M(NIX_BP_ENABLE,	0x800f, nix_bp_cfg_req, nix_bp_cfg_rsp)		\
+M(NIX_BP_DISABLE,	0x8010, nix_bp_cfg_req, msg_rsp)
 
 /* Messages initiated by AF (range 0xC00 - 0xDFF) */
 #define MBOX_UP_CGX_MESSAGES						\
@@ -297,6 +307,22 @@ struct msix_offset_rsp {
 	u16  cptlf_msixoff[MAX_RVU_BLKLF_CNT];
 };
 
+enum ptp_op {
+	PTP_OP_ADJFINE = 0,
+	PTP_OP_GET_CLOCK = 1,
+};
+
+struct ptp_req {
+	struct mbox_msghdr hdr;
+	u8 op;
+	s64 scaled_ppm;
+};
+
+struct ptp_rsp {
+	struct mbox_msghdr hdr;
+	u64 clk;
+};
+
 /* CGX mbox message formats */
 
 struct cgx_stats_rsp {
@@ -329,6 +355,23 @@ struct cgx_link_info_msg {
 	struct cgx_link_user_info link_info;
 };
 
+/* 802.3x PAUSE config, with 'set' clear current config is returned */
+struct cgx_pause_frm_cfg {
+	struct mbox_msghdr hdr;
+	u8 set;
+	u8 rx_pause; /* Stop transmitting on receiving PAUSE */
+	u8 tx_pause; /* Send PAUSE when NIX asserts backpressure */
+};
+
+/* PFC config, 'pfc_en' is the bitmap of priorities PFC is enabled for,
+ * with 'set' clear current config is returned.
+ */
+struct cgx_pfc_cfg {
+	struct mbox_msghdr hdr;
+	u8 set;
+	u8 pfc_en;
+};
+
 /* NPA mbox message formats */
 
 /* NPA mailbox error codes
@@ -451,6 +494,9 @@ struct nix_lf_alloc_rsp {
 	u8	lf_tx_stats; /* NIX_AF_CONST1::LF_TX_STATS */
 	u16	cints; /* NIX_AF_CONST2::CINTS */
 	u16	qints; /* NIX_AF_CONST2::QINTS */
+	/* First of NIX_LSO_TUN_FORMATS formats for tunneled TSO */
+	u8	lso_udp_tun_idx;
+	u8	lso_ip_tun_idx;
 };
 
 /* NIX AQ enqueue msg */
@@ -601,6 +647,21 @@ struct nix_frs_cfg {
 	u16	minlen;
 };
 
+/* Enable or disable backpressure on 'chan_cnt' RX channels starting
+ * from PF's rx_chan_base, CQs and auras assert it using the returned
+ * BPID.
+ */
+struct nix_bp_cfg_req {
+	struct mbox_msghdr hdr;
+	u8	chan_cnt;
+};
+
+struct nix_bp_cfg_rsp {
+	struct mbox_msghdr hdr;
+	u16	bpid;
+	u8	chan_cnt; /* Zero if backpressure isn't supported */
+};
+
 /* SSO mailbox error codes
  * Range 501 - 600.
  */
@@ -259,4 +259,11 @@ struct nix_rx_action {
 #endif
 };
 
+/* NPC_RESULT_S VTAG0 action bits, capture VTAG0 from start of layer
+ * 'lid' as NIX_AF_LF()_RX_VTAG_TYPE 't'.
+ */
+#define NPC_RX_VTAG0_VALID	BIT_ULL(15)
+#define NPC_RX_VTAG0_TYPE(t)	(((u64)(t) & 0x7) << 12)
+#define NPC_RX_VTAG0_LID(lid)	(((u64)(lid) & 0x7) << 8)
+
 #endif /* NPC_H */
@@ -535,3 +535,89 @@ int rvu_mbox_handler_CGX_INTLBK_DISABLE(struct rvu *rvu, struct msg_req *req,
 	rvu_cgx_config_intlbk(rvu, req->hdr.pcifunc, false);
 	return 0;
 }
+
+static int rvu_cgx_ptp_rx_cfg(struct rvu *rvu, u16 pcifunc, bool enable)
+{
+	int pf = rvu_get_pf(pcifunc);
+	u8 cgx_id, lmac_id;
+	void *cgxd;
+
+	/* Timestamps are prepended by CGX, so this is applicable only
+	 * to PFs mapped to CGX LMACs.
+	 */
+	if ((pcifunc & RVU_PFVF_FUNC_MASK) || !is_pf_cgxmapped(rvu, pf))
+		return -ENODEV;
+
+	rvu_get_cgx_lmac_id(rvu->pf2cgxlmac_map[pf], &cgx_id, &lmac_id);
+	cgxd = rvu_cgx_pdata(cgx_id, rvu);
+
+	cgx_lmac_ptp_config(cgxd, lmac_id, enable);
+	/* Packets received on this PF's pkind now start with the 8 byte
+	 * timestamp, have NPC skip it before parsing the ethernet header.
+	 */
+	return npc_config_ts_kpuaction(rvu, pf, pcifunc, enable);
+}
+
+int rvu_mbox_handler_CGX_PTP_RX_ENABLE(struct rvu *rvu, struct msg_req *req,
+				       struct msg_rsp *rsp)
+{
+	return rvu_cgx_ptp_rx_cfg(rvu, req->hdr.pcifunc, true);
+}
+
+int rvu_mbox_handler_CGX_PTP_RX_DISABLE(struct rvu *rvu, struct msg_req *req,
+					struct msg_rsp *rsp)
+{
+	return rvu_cgx_ptp_rx_cfg(rvu, req->hdr.pcifunc, false);
+}
+
+int rvu_mbox_handler_CGX_CFG_PAUSE_FRM(struct rvu *rvu,
+				       struct cgx_pause_frm_cfg *req,
+				       struct cgx_pause_frm_cfg *rsp)
+{
+	int pf = rvu_get_pf(req->hdr.pcifunc);
+	bool tx_pause, rx_pause;
+	u8 cgx_id, lmac_id;
+	void *cgxd;
+	int err;
+
+	/* PAUSE is a property of the link, only PFs mapped to
+	 * CGX LMACs can configure it.
+	 */
+	if ((req->hdr.pcifunc & RVU_PFVF_FUNC_MASK) ||
+	    !is_pf_cgxmapped(rvu, pf))
+		return -ENODEV;
+
+	rvu_get_cgx_lmac_id(rvu->pf2cgxlmac_map[pf], &cgx_id, &lmac_id);
+	cgxd = rvu_cgx_pdata(cgx_id, rvu);
+
+	if (req->set)
+		return cgx_lmac_set_pause_frm(cgxd, lmac_id, req->tx_pause,
+					      req->rx_pause);
+
+	err = cgx_lmac_get_pause_frm(cgxd, lmac_id, &tx_pause, &rx_pause);
+	if (err)
+		return err;
+	rsp->tx_pause = tx_pause;
+	rsp->rx_pause = rx_pause;
+	return 0;
+}
+
+int rvu_mbox_handler_CGX_CFG_PFC(struct rvu *rvu, struct cgx_pfc_cfg *req,
+				 struct cgx_pfc_cfg *rsp)
+{
+	int pf = rvu_get_pf(req->hdr.pcifunc);
+	u8 cgx_id, lmac_id;
+	void *cgxd;
+
+	if ((req->hdr.pcifunc & RVU_PFVF_FUNC_MASK) ||
+	    !is_pf_cgxmapped(rvu, pf))
+		return -ENODEV;
+
+	rvu_get_cgx_lmac_id(rvu->pf2cgxlmac_map[pf], &cgx_id, &lmac_id);
+	cgxd = rvu_cgx_pdata(cgx_id, rvu);
+
+	if (req->set)
+		return cgx_lmac_pfc_config(cgxd, lmac_id, req->pfc_en);
+
+	return cgx_lmac_get_pfc(cgxd, lmac_id, &rsp->pfc_en);
+}
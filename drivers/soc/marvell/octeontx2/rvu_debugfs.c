@@ -857,7 +857,7 @@ static void print_nix_cq_ctx(struct nix_aq_enq_rsp *rsp)
 		cq_ctx->substream, cq_ctx->ena);
 	pr_info("W3: drop_ena \t\t\t%d\nW3: drop \t\t\t%d\n",
 		cq_ctx->drop_ena, cq_ctx->drop);
-	pr_info("W3: dp \t\t\t\t%d\n\n", cq_ctx->dp);
+	pr_info("W3: bp \t\t\t\t%d\n\n", cq_ctx->bp);
 }
 
 static void read_nix_ctx(struct rvu *rvu, bool all, int nixlf,
@@ -10,6 +10,7 @@
 
 #include <linux/module.h>
 #include <linux/pci.h>
+#include <linux/if_ether.h>
 
 #include "rvu_struct.h"
 #include "rvu_reg.h"
@@ -212,10 +213,26 @@ static int nix_interface_init(struct rvu *rvu, u16 pcifunc, int type, int nixlf)
 	return 0;
 }
 
+/* Stop backpressure on PF's receive channels and unmap their BPID */
+static void nix_rx_bp_disable(struct rvu *rvu, int blkaddr, u16 pcifunc,
+			      int chan_cnt)
+{
+	struct rvu_pfvf *pfvf = rvu_get_pfvf(rvu, pcifunc);
+	int chan, reg;
+	u64 cfg;
+
+	for (chan = 0; chan < chan_cnt; chan++) {
+		reg = NIX_AF_RX_CHANX_CFG(pfvf->rx_chan_base + chan);
+		cfg = rvu_read64(rvu, blkaddr, reg);
+		cfg &= ~(NIX_AF_RX_CHAN_BP_ENA | NIX_AF_RX_CHAN_BPID);
+		rvu_write64(rvu, blkaddr, reg, cfg);
+	}
+}
+
 static void nix_interface_deinit(struct rvu *rvu, u16 pcifunc, u8 nixlf)
 {
 	struct rvu_pfvf *pfvf = rvu_get_pfvf(rvu, pcifunc);
-	int err;
+	int blkaddr, err;
 
 	pfvf->maxlen = 0;
 	pfvf->minlen = 0;
@@ -230,15 +247,21 @@ static void nix_interface_deinit(struct rvu *rvu, u16 pcifunc, u8 nixlf)
 
 	/* Free and disable any MCAM entries used by this NIX LF */
 	rvu_npc_disable_mcam_entries(rvu, pcifunc, nixlf);
+
+	/* Stop backpressuring LMAC's channels, BPID goes along with LF */
+	blkaddr = rvu_get_blkaddr(rvu, BLKTYPE_NIX, pcifunc);
+	if (!(pcifunc & RVU_PFVF_FUNC_MASK) && blkaddr >= 0 &&
+	    is_pf_cgxmapped(rvu, rvu_get_pf(pcifunc)))
+		nix_rx_bp_disable(rvu, blkaddr, pcifunc, NIX_CGX_LMAC_CHAN_CNT);
 }
 
-static void nix_setup_lso_tso_l3(struct rvu *rvu, int blkaddr,
-				 u64 format, bool v4, u64 *fidx)
+static void nix_setup_lso_tso_l3(struct rvu *rvu, int blkaddr, u64 format,
+				 u8 layer, bool v4, u64 *fidx)
 {
 	struct nix_lso_format field = {0};
 
 	/* IP's Length field */
-	field.layer = NIX_TXLAYER_OL3;
+	field.layer = layer;
 	/* In ipv4, length field is at offset 2 bytes, for ipv6 it's 4 */
 	field.offset = v4 ? 2 : 4;
 	field.sizem1 = 1; /* i.e 2 bytes */
@@ -252,7 +275,7 @@ static void nix_setup_lso_tso_l3(struct rvu *rvu, int blkaddr,
 		return;
 
 	/* IP's ID field */
-	field.layer = NIX_TXLAYER_OL3;
+	field.layer = layer;
 	field.offset = 4;
 	field.sizem1 = 1; /* i.e 2 bytes */
 	field.alg = NIX_LSOALG_ADD_SEGNUM;
@@ -261,13 +284,13 @@ static void nix_setup_lso_tso_l3(struct rvu *rvu, int blkaddr,
 		    *(u64 *)&field);
 }
 
-static void nix_setup_lso_tso_l4(struct rvu *rvu, int blkaddr,
-				 u64 format, u64 *fidx)
+static void nix_setup_lso_tso_l4(struct rvu *rvu, int blkaddr, u64 format,
+				 u8 layer, u64 *fidx)
 {
 	struct nix_lso_format field = {0};
 
 	/* TCP's sequence number field */
-	field.layer = NIX_TXLAYER_OL4;
+	field.layer = layer;
 	field.offset = 4;
 	field.sizem1 = 3; /* i.e 4 bytes */
 	field.alg = NIX_LSOALG_ADD_OFFSET;
@@ -276,7 +299,7 @@ static void nix_setup_lso_tso_l4(struct rvu *rvu, int blkaddr,
 		    *(u64 *)&field);
 
 	/* TCP's flags field */
-	field.layer = NIX_TXLAYER_OL4;
+	field.layer = layer;
 	field.offset = 12;
 	field.sizem1 = 0; /* not needed */
 	field.alg = NIX_LSOALG_TCP_FLAGS;
@@ -285,9 +308,55 @@ static void nix_setup_lso_tso_l4(struct rvu *rvu, int blkaddr,
 		    *(u64 *)&field);
 }
 
+/* Outer UDP header of a UDP tunnel */
+static void nix_setup_lso_udp_tun(struct rvu *rvu, int blkaddr,
+				  u64 format, u64 *fidx)
+{
+	struct nix_lso_format field = {0};
+
+	/* UDP's Length field */
+	field.layer = NIX_TXLAYER_OL4;
+	field.offset = 4;
+	field.sizem1 = 1; /* i.e 2 bytes */
+	field.alg = NIX_LSOALG_ADD_PAYLEN;
+	rvu_write64(rvu, blkaddr,
+		    NIX_AF_LSO_FORMATX_FIELDX(format, (*fidx)++),
+		    *(u64 *)&field);
+}
+
+/* Set rest of the fields to NOP */
+static void nix_setup_lso_nop(struct rvu *rvu, int blkaddr,
+			      u64 format, u64 fidx)
+{
+	for (; fidx < 8; fidx++) {
+		rvu_write64(rvu, blkaddr,
+			    NIX_AF_LSO_FORMATX_FIELDX(format, fidx), 0x0ULL);
+	}
+}
+
+/* TSO of packets tunneled over UDP or IP, inner TCP header's
+ * and both outer and inner IP headers' fields are updated.
+ */
+static void nix_setup_lso_tun(struct rvu *rvu, int blkaddr, u64 format,
+			      bool outer_v4, bool inner_v4, bool udp)
+{
+	u64 fidx = 0;
+
+	nix_setup_lso_tso_l3(rvu, blkaddr, format, NIX_TXLAYER_OL3,
+			     outer_v4, &fidx);
+	if (udp)
+		nix_setup_lso_udp_tun(rvu, blkaddr, format, &fidx);
+	nix_setup_lso_tso_l3(rvu, blkaddr, format, NIX_TXLAYER_IL3,
+			     inner_v4, &fidx);
+	nix_setup_lso_tso_l4(rvu, blkaddr, format, NIX_TXLAYER_IL4, &fidx);
+	nix_setup_lso_nop(rvu, blkaddr, format, fidx);
+}
+
 static void nix_setup_lso(struct rvu *rvu, int blkaddr)
 {
 	u64 cfg, idx, fidx = 0;
+	bool outer_v4, inner_v4;
+	int tun;
 
 	/* Enable LSO */
 	cfg = rvu_read64(rvu, blkaddr, NIX_AF_LSO_CFG);
@@ -300,25 +369,25 @@ static void nix_setup_lso(struct rvu *rvu, int blkaddr)
 
 	/* Configure format fields for TCPv4 segmentation offload */
 	idx = NIX_LSO_FORMAT_IDX_TSOV4;
-	nix_setup_lso_tso_l3(rvu, blkaddr, idx, true, &fidx);
-	nix_setup_lso_tso_l4(rvu, blkaddr, idx, &fidx);
-
-	/* Set rest of the fields to NOP */
-	for (; fidx < 8; fidx++) {
-		rvu_write64(rvu, blkaddr,
-			    NIX_AF_LSO_FORMATX_FIELDX(idx, fidx), 0x0ULL);
-	}
+	nix_setup_lso_tso_l3(rvu, blkaddr, idx, NIX_TXLAYER_OL3, true, &fidx);
+	nix_setup_lso_tso_l4(rvu, blkaddr, idx, NIX_TXLAYER_OL4, &fidx);
+	nix_setup_lso_nop(rvu, blkaddr, idx, fidx);
 
 	/* Configure format fields for TCPv6 segmentation offload */
 	idx = NIX_LSO_FORMAT_IDX_TSOV6;
 	fidx = 0;
-	nix_setup_lso_tso_l3(rvu, blkaddr, idx, false, &fidx);
-	nix_setup_lso_tso_l4(rvu, blkaddr, idx, &fidx);
-
-	/* Set rest of the fields to NOP */
-	for (; fidx < 8; fidx++) {
-		rvu_write64(rvu, blkaddr,
-			    NIX_AF_LSO_FORMATX_FIELDX(idx, fidx), 0x0ULL);
+	nix_setup_lso_tso_l3(rvu, blkaddr, idx, NIX_TXLAYER_OL3, false, &fidx);
+	nix_setup_lso_tso_l4(rvu, blkaddr, idx, NIX_TXLAYER_OL4, &fidx);
+	nix_setup_lso_nop(rvu, blkaddr, idx, fidx);
+
+	/* Configure format fields for tunneled TCP segmentation offload */
+	for (tun = 0; tun < NIX_LSO_TUN_FORMATS; tun++) {
+		outer_v4 = !(tun & 0x2);
+		inner_v4 = !(tun & 0x1);
+		idx = NIX_LSO_FORMAT_IDX_UDP_TUN + tun;
+		nix_setup_lso_tun(rvu, blkaddr, idx, outer_v4, inner_v4, true);
+		idx = NIX_LSO_FORMAT_IDX_IP_TUN + tun;
+		nix_setup_lso_tun(rvu, blkaddr, idx, outer_v4, inner_v4, false);
 	}
 }
 
@@ -826,6 +895,12 @@ int rvu_mbox_handler_NIX_LF_ALLOC(struct rvu *rvu,
 	/* Enable LMTST for this NIX LF */
 	rvu_write64(rvu, blkaddr, NIX_AF_LFX_TX_CFG2(nixlf), BIT_ULL(0));
 
+	/* Set TPIDs of VLAN0 and VLAN1 tags inserted via SQE, they are
+	 * used for 802.1ad and 802.1Q tags respectively.
+	 */
+	cfg = ((u64)ETH_P_8021Q << 16) | ETH_P_8021AD;
+	rvu_write64(rvu, blkaddr, NIX_AF_LFX_TX_CFG(nixlf), cfg);
+
 	/* Set CQE/WQE size, NPA_PF_FUNC for SQBs and also SSO_PF_FUNC
 	 * If requester has sent a 'RVU_DEFAULT_PF_FUNC' use this NIX LF's
 	 * PCIFUNC itself.
@@ -870,6 +945,8 @@ int rvu_mbox_handler_NIX_LF_ALLOC(struct rvu *rvu,
 	rsp->tx_chan_cnt = pfvf->tx_chan_cnt;
 	rsp->lso_tsov4_idx = NIX_LSO_FORMAT_IDX_TSOV4;
 	rsp->lso_tsov6_idx = NIX_LSO_FORMAT_IDX_TSOV6;
+	rsp->lso_udp_tun_idx = NIX_LSO_FORMAT_IDX_UDP_TUN;
+	rsp->lso_ip_tun_idx = NIX_LSO_FORMAT_IDX_IP_TUN;
 	/* Get HW supported stat count */
 	cfg = rvu_read64(rvu, blkaddr, NIX_AF_CONST1);
 	rsp->lf_rx_stats = ((cfg >> 32) & 0xFF);
@@ -2337,6 +2414,127 @@ int rvu_mbox_handler_NIX_SET_HW_FRS(struct rvu *rvu, struct nix_frs_cfg *req,
 	return 0;
 }
 
+/* With send timestamping enabled, NIX captures PTP clock into
+ * the address specified by a SEND_MEM subdesc with ALG 'SETTSTMP'.
+ */
+static int nix_lf_ptp_tx_cfg(struct rvu *rvu, u16 pcifunc, bool enable)
+{
+	struct rvu_hwinfo *hw = rvu->hw;
+	struct rvu_block *block;
+	int blkaddr;
+	int nixlf;
+	u64 cfg;
+
+	blkaddr = rvu_get_blkaddr(rvu, BLKTYPE_NIX, pcifunc);
+	if (blkaddr < 0)
+		return NIX_AF_ERR_AF_LF_INVALID;
+
+	block = &hw->block[blkaddr];
+	nixlf = rvu_get_lf(rvu, block, pcifunc, 0);
+	if (nixlf < 0)
+		return NIX_AF_ERR_AF_LF_INVALID;
+
+	cfg = rvu_read64(rvu, blkaddr, NIX_AF_LFX_TX_CFG(nixlf));
+
+	if (enable)
+		cfg |= NIX_LF_TX_PTP_ENA;
+	else
+		cfg &= ~NIX_LF_TX_PTP_ENA;
+
+	rvu_write64(rvu, blkaddr, NIX_AF_LFX_TX_CFG(nixlf), cfg);
+	return 0;
+}
+
+int rvu_mbox_handler_NIX_LF_PTP_TX_ENABLE(struct rvu *rvu, struct msg_req *req,
+					  struct msg_rsp *rsp)
+{
+	return nix_lf_ptp_tx_cfg(rvu, req->hdr.pcifunc, true);
+}
+
+int rvu_mbox_handler_NIX_LF_PTP_TX_DISABLE(struct rvu *rvu,
+					   struct msg_req *req,
+					   struct msg_rsp *rsp)
+{
+	return nix_lf_ptp_tx_cfg(rvu, req->hdr.pcifunc, false);
+}
+
+/* Each CGX LMAC gets a BPID of its own, the LMAC's channels asked
+ * for are mapped to it. CQs and auras of all PFs/VFs using the LMAC
+ * assert backpressure on it when they run low on free entries, which
+ * CGX turns into PAUSE or PFC frames if enabled. Since the LMAC is
+ * shared with VFs, only the PF mapped to it can configure this.
+ */
+int rvu_mbox_handler_NIX_BP_ENABLE(struct rvu *rvu,
+				   struct nix_bp_cfg_req *req,
+				   struct nix_bp_cfg_rsp *rsp)
+{
+	u16 pcifunc = req->hdr.pcifunc;
+	struct rvu_hwinfo *hw = rvu->hw;
+	int pf = rvu_get_pf(pcifunc);
+	struct rvu_pfvf *pfvf;
+	int blkaddr, chan;
+	u8 cgx_id, lmac_id;
+	u16 bpid;
+	u64 cfg;
+	int reg;
+
+	if (pcifunc & RVU_PFVF_FUNC_MASK)
+		return -ENODEV;
+
+	blkaddr = rvu_get_blkaddr(rvu, BLKTYPE_NIX, pcifunc);
+	if (blkaddr < 0)
+		return NIX_AF_ERR_AF_LF_INVALID;
+
+	/* Only CGX links are backpressured, not LBK */
+	rsp->chan_cnt = 0;
+	if (!is_pf_cgxmapped(rvu, pf))
+		return 0;
+
+	if (req->chan_cnt > NIX_CGX_LMAC_CHAN_CNT)
+		return NIX_AF_ERR_PARAM;
+
+	pfvf = rvu_get_pfvf(rvu, pcifunc);
+	rvu_get_cgx_lmac_id(rvu->pf2cgxlmac_map[pf], &cgx_id, &lmac_id);
+	bpid = (cgx_id * hw->lmac_per_cgx) + lmac_id;
+
+	for (chan = 0; chan < req->chan_cnt; chan++) {
+		reg = NIX_AF_RX_CHANX_CFG(pfvf->rx_chan_base + chan);
+		cfg = rvu_read64(rvu, blkaddr, reg);
+		cfg &= ~NIX_AF_RX_CHAN_BPID;
+		cfg |= NIX_AF_RX_CHAN_BP_ENA | bpid;
+		rvu_write64(rvu, blkaddr, reg, cfg);
+	}
+
+	rsp->bpid = bpid;
+	rsp->chan_cnt = req->chan_cnt;
+	return 0;
+}
+
+int rvu_mbox_handler_NIX_BP_DISABLE(struct rvu *rvu,
+				    struct nix_bp_cfg_req *req,
+				    struct msg_rsp *rsp)
+{
+	u16 pcifunc = req->hdr.pcifunc;
+	int pf = rvu_get_pf(pcifunc);
+	int blkaddr;
+
+	if (pcifunc & RVU_PFVF_FUNC_MASK)
+		return -ENODEV;
+
+	blkaddr = rvu_get_blkaddr(rvu, BLKTYPE_NIX, pcifunc);
+	if (blkaddr < 0)
+		return NIX_AF_ERR_AF_LF_INVALID;
+
+	if (!is_pf_cgxmapped(rvu, pf))
+		return 0;
+
+	if (req->chan_cnt > NIX_CGX_LMAC_CHAN_CNT)
+		return NIX_AF_ERR_PARAM;
+
+	nix_rx_bp_disable(rvu, blkaddr, pcifunc, req->chan_cnt);
+	return 0;
+}
+
 static void nix_link_config(struct rvu *rvu, int blkaddr)
 {
 	struct rvu_hwinfo *hw = rvu->hw;
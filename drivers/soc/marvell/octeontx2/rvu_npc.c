@@ -26,6 +26,14 @@
 
 #define NPC_PARSE_RESULT_DMAC_OFFSET	8
 
+/* RX VTAG action, capture VTAG0 from start of layer LB as
+ * NIX_AF_LF()_RX_VTAG_TYPE0, strip is enabled by the LF itself.
+ */
+#define NPC_RX_VTAG0_ACTION	(NPC_RX_VTAG0_VALID | NPC_RX_VTAG0_TYPE(0) | \
+				 NPC_RX_VTAG0_LID(NPC_LID_LB))
+
+#define NPC_HW_TSTAMP_OFFSET	8
+
 static void npc_mcam_free_all_entries(struct rvu *rvu, struct npc_mcam *mcam,
 				      int blkaddr, u16 pcifunc);
 static void npc_mcam_free_all_counters(struct rvu *rvu, struct npc_mcam *mcam,
@@ -59,6 +67,36 @@ int rvu_npc_get_pkind(struct rvu *rvu, u16 pf)
 	return -1;
 }
 
+/* With PTP enabled CGX prepends an 8 byte timestamp to packets,
+ * move pkind's parse pointer past it so that KPUs see the L2 header
+ * at the usual offset.
+ */
+int npc_config_ts_kpuaction(struct rvu *rvu, int pf, u16 pcifunc, bool en)
+{
+	struct npc_kpu_action0 *action0;
+	int pkind, blkaddr;
+	u64 val;
+
+	pkind = rvu_npc_get_pkind(rvu, pf);
+	if (pkind < 0) {
+		dev_err(rvu->dev, "%s: pkind not mapped\n", __func__);
+		return -EINVAL;
+	}
+
+	blkaddr = rvu_get_blkaddr(rvu, BLKTYPE_NPC, pcifunc);
+	if (blkaddr < 0) {
+		dev_err(rvu->dev, "%s: NPC block not implemented\n", __func__);
+		return -EINVAL;
+	}
+
+	val = rvu_read64(rvu, blkaddr, NPC_AF_PKINDX_ACTION0(pkind));
+	action0 = (struct npc_kpu_action0 *)&val;
+	action0->ptr_advance = en ? NPC_HW_TSTAMP_OFFSET : 0;
+	rvu_write64(rvu, blkaddr, NPC_AF_PKINDX_ACTION0(pkind), val);
+
+	return 0;
+}
+
 static int npc_get_nixlf_mcam_index(struct npc_mcam *mcam,
 				    u16 pcifunc, int nixlf, int type)
 {
@@ -347,6 +385,7 @@ void rvu_npc_install_ucast_entry(struct rvu *rvu, u16 pcifunc,
 	}
 
 	entry.action = *(u64 *)&action;
+	entry.vtag_action = NPC_RX_VTAG0_ACTION;
 	npc_config_mcam_entry(rvu, mcam, blkaddr, index,
 			      NIX_INTF_RX, &entry, true);
 }
@@ -384,6 +423,7 @@ void rvu_npc_install_promisc_entry(struct rvu *rvu, u16 pcifunc,
 	action.pf_func = pcifunc;
 
 	entry.action = *(u64 *)&action;
+	entry.vtag_action = NPC_RX_VTAG0_ACTION;
 	npc_config_mcam_entry(rvu, mcam, blkaddr, index,
 			      NIX_INTF_RX, &entry, true);
 }
@@ -465,6 +505,7 @@ void rvu_npc_install_bcast_match_entry(struct rvu *rvu, u16 pcifunc,
 #endif
 
 	entry.action = *(u64 *)&action;
+	entry.vtag_action = NPC_RX_VTAG0_ACTION;
 	npc_config_mcam_entry(rvu, mcam, blkaddr, index,
 			      NIX_INTF_RX, &entry, true);
 }
@@ -364,6 +364,8 @@
 #define NIX_AF_TX_VTAG_DEFX_DATA(a)             (0x1A10 | (a) << 16)
 #define NIX_AF_RX_BPIDX_STATUS(a)               (0x1A20 | (a) << 17)
 #define NIX_AF_RX_CHANX_CFG(a)                  (0x1A30 | (a) << 15)
+#define NIX_AF_RX_CHAN_BPID			GENMASK_ULL(8, 0)
+#define NIX_AF_RX_CHAN_BP_ENA			BIT_ULL(16)
 #define NIX_AF_CINT_TIMERX(a)                   (0x1A40 | (a) << 18)
 #define NIX_AF_LSO_FORMATX_FIELDX(a, b)         (0x1B00 | (a) << 16 | (b) << 3)
 #define NIX_AF_LFX_CFG(a)		(0x4000 | (a) << 17)
@@ -375,6 +377,7 @@
 #define NIX_AF_LFX_CQS_CFG(a)		(0x4060 | (a) << 17)
 #define NIX_AF_LFX_CQS_BASE(a)		(0x4070 | (a) << 17)
 #define NIX_AF_LFX_TX_CFG(a)		(0x4080 | (a) << 17)
+#define NIX_LF_TX_PTP_ENA		BIT_ULL(32)
 #define NIX_AF_LFX_TX_PARSE_CFG(a)	(0x4090 | (a) << 17)
 #define NIX_AF_LFX_RX_CFG(a)		(0x40A0 | (a) << 17)
 #define NIX_AF_LFX_RSS_CFG(a)		(0x40C0 | (a) << 17)